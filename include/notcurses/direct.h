@@ -49,6 +49,13 @@ extern "C" {
 // all diagnostics, a superset of NCDIRECT_OPTION_VERBOSE (which this implies).
 #define NCDIRECT_OPTION_VERY_VERBOSE        0x0020ull
 
+// Don't flush output following each color or style change. It is instead
+// written along with subsequent text according to the buffering mode of 'fp'
+// (at each newline if it is line-buffered, as terminals usually are, or
+// whenever its buffer fills), or upon ncdirect_flush(). This eliminates a
+// write(2) per call when decorating large amounts of text.
+#define NCDIRECT_OPTION_BUFFERED_OUTPUT     0x0040ull
+
 // Initialize a direct-mode Notcurses context on the connected terminal at 'fp'.
 // 'fp' must be a tty. You'll usually want stdout. Direct mode supports a
 // limited subset of Notcurses routines which directly affect 'fp', and neither
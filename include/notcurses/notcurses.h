@@ -1032,6 +1032,21 @@ typedef enum {
 // equivalent to calling ncplane_set_scrolling(notcurses_stdplane(nc), true).
 #define NCOPTION_SCROLLING           0x0200ull
 
+// Merge runs of mouse motion events having identical buttons and modifiers
+// into the most recent one, and likewise merge repeated resize events, so
+// long as the earlier event has not yet been read. notcurses_get_coalesced()
+// reports how many events were merged into the one returned. Resize events
+// are furthermore held back until the geometry has been stable for 50ms.
+#define NCOPTION_COALESCE_INPUT      0x0400ull
+
+// When the displayed pile changes, the old pile's Kitty graphics are deleted
+// from the terminal, and must be retransmitted in full should their pile be
+// displayed once more. With this option, their image data is instead left
+// loaded in the terminal (only their placements are removed), so that
+// switching back to a recently displayed pile can show them anew at little
+// cost. Has no effect on terminals without the Kitty graphics protocol.
+#define NCOPTION_RETAIN_PILE_BITMAPS 0x0800ull
+
 // "CLI mode" is just setting these four options.
 #define NCOPTION_CLI_MODE (NCOPTION_NO_ALTERNATE_SCREEN \
                            |NCOPTION_NO_CLEAR_BITMAPS \
@@ -1165,6 +1180,83 @@ API int ncpile_render_to_buffer(struct ncplane* p, char** buf, size_t* buflen)
 API int ncpile_render_to_file(struct ncplane* p, FILE* fp)
   __attribute__ ((nonnull (1, 2)));
 
+// An output sink receives each frame written to the terminal by
+// notcurses_render(), ncpile_rasterize(), and notcurses_refresh(), allowing
+// the display to be mirrored or recorded without rasterizing it again. Each
+// sink is serviced by its own thread, from its own bounded queue. Sinks may
+// be created and destroyed concurrently with rasterization, but not from
+// within a sink callback.
+struct ncsink;
+
+// Invoked from the sink's thread with each frame, along with the
+// CLOCK_MONOTONIC time (in nanoseconds) at which it was rasterized. A non-zero
+// return marks the sink as failed; further frames are discarded.
+typedef int(*ncsink_callback)(struct ncsink* s, const void* buf, size_t len,
+                              uint64_t ns, void* curry);
+
+// Rather than dropping frames when the sink's queue is full, block the
+// rasterizer until there is space. The sink will not miss output, but can
+// stall rendering.
+#define NCSINK_OPTION_BLOCK 0x0001ull
+
+typedef struct ncsink_options {
+  void* curry;     // parameter provided to the callback
+  // frames are queued until this many bytes are pending; 0 selects 4MiB. a
+  // frame larger than this is accepted into an otherwise empty queue.
+  size_t maxqueue;
+  uint64_t flags;  // bitfield over NCSINK_OPTION_*
+} ncsink_options;
+
+// Attach a sink to 'nc'. Each frame is handed to 'cbfxn', or written to 'fd'
+// if 'cbfxn' is NULL (the caller retains ownership of 'fd'). Unless
+// NCSINK_OPTION_BLOCK is provided, a frame which would overflow the queue is
+// dropped, and the sink then skips frames until a keyframe paints every glyph
+// of the screen. A keyframe is built for the sinks needing one (the terminal
+// doesn't see it) once the queue has drained to half its bound. Bitmaps are
+// not included in keyframes.
+API ALLOC struct ncsink* ncsink_create(struct notcurses* nc, const ncsink_options* opts,
+                                       int fd, ncsink_callback cbfxn)
+  __attribute__ ((nonnull (1)));
+
+// Attach a sink writing an asciicast v2 recording to 'fd' (which the caller
+// retains). The header is written immediately; each frame becomes an output
+// event timestamped relative to this call, and geometry changes are recorded
+// as resize events.
+API ALLOC struct ncsink* ncsink_asciicast(struct notcurses* nc, const ncsink_options* opts,
+                                          int fd)
+  __attribute__ ((nonnull (1)));
+
+// How many frames has the sink dropped?
+API uint64_t ncsink_dropped(struct ncsink* s)
+  __attribute__ ((nonnull (1)));
+
+// Detach the sink, wait for its queue to be written out, and destroy it.
+// Returns -1 if the sink failed at any point. Any sinks remaining at
+// notcurses_stop() are destroyed there.
+API int ncsink_destroy(struct ncsink* s);
+
+// Limit rasterized output to approximately 'bps' bytes per second, averaged
+// over about a second; 0 (the default) removes any limit. When output exceeds
+// the budget, it is progressively degraded: first RGB is quantized to 5 bits
+// per component, then to the 256-color palette (or 4 bits per component, if
+// the palette is unavailable or has been modified), and finally updates to
+// NCPLANE_OPTION_LOWPRIORITY planes and bitmap redraws are deferred. Fidelity
+// is restored as the budget allows. See the 'degradation' stats.
+API int notcurses_set_bandwidth(struct notcurses* nc, uint64_t bps)
+  __attribute__ ((nonnull (1)));
+
+// Use up to 'registers' of the 256-color palette's entries, counting down
+// from 255, to emit frequently-used RGB colors with the shorter indexed SGR.
+// Colors are assigned to registers (and the registers reprogrammed) when
+// they're emitted often enough to pay for it, and evicted least recently
+// used first. 0 (the default) disables this. Fails unless the terminal
+// supports RGB and can change its palette. Cells using these palette indices
+// directly will take on whatever colors they're programmed with; entries
+// set via ncpalette_use() are left to the application. See the 'dynpal'
+// stats.
+API int notcurses_set_dynamic_palette(struct notcurses* nc, unsigned registers)
+  __attribute__ ((nonnull (1)));
+
 // Destroy all ncplanes other than the stdplane.
 API void notcurses_drop_planes(struct notcurses* nc)
   __attribute__ ((nonnull (1)));
@@ -1302,6 +1394,13 @@ API uint32_t notcurses_get(struct notcurses* n, const struct timespec* ts,
                            ncinput* ni)
   __attribute__ ((nonnull (1)));
 
+// As notcurses_get(), additionally writing to 'coalesced' the number of prior
+// events merged into the one returned (see NCOPTION_COALESCE_INPUT). This is
+// always 0 when coalescing is not enabled, or when no event is returned.
+API uint32_t notcurses_get_coalesced(struct notcurses* n, const struct timespec* ts,
+                                     ncinput* ni, unsigned* coalesced)
+  __attribute__ ((nonnull (1, 4)));
+
 // Acquire up to 'vcount' ncinputs at the vector 'ni'. The number read will be
 // returned, or -1 on error without any reads, 0 on timeout.
 API int notcurses_getvec(struct notcurses* n, const struct timespec* ts,
@@ -1459,6 +1558,15 @@ API char* notcurses_at_yx(struct notcurses* nc, unsigned yoff, unsigned xoff,
 // plane with this flag is equivalent to immediately calling
 // ncplane_set_scrolling(p, true) following plane creation.
 #define NCPLANE_OPTION_VSCROLL      0x0020ull
+// Updates to this plane may be deferred while output is degraded to meet a
+// bandwidth budget (see notcurses_set_bandwidth()). Its cells continue to
+// show their last rasterized contents until the budget allows them through.
+#define NCPLANE_OPTION_LOWPRIORITY  0x0040ull
+// Store the plane's cells in 8 bytes rather than 16, interning their channels
+// into a per-plane table of up to 65536 distinct pairs (the plane quietly
+// reverts to full cells should it need more). Intended for large text planes,
+// such as scrollback. Bitmaps cannot be blitted onto compact planes.
+#define NCPLANE_OPTION_COMPACT      0x0080ull
 
 typedef struct ncplane_options {
   int y;            // vertical placement relative to parent plane
@@ -1810,6 +1918,17 @@ typedef struct ncstats {
   // current state -- these can decrease
   uint64_t fbbytes;          // total bytes devoted to all active framebuffers
   unsigned planes;           // number of planes currently in existence
+  unsigned degradation;      // output degradation level, 0 (none) through 3
+
+  // further purely increasing stats, appended to preserve the ABI
+  uint64_t degraded_frames;  // frames rasterized with degraded output
+  uint64_t degraded_cells;   // cell updates absorbed or deferred by degradation
+  uint64_t degraded_bytes;   // estimated bytes saved by degradation
+  uint64_t cleanrows;        // rows found unchanged without per-cell compares
+  uint64_t sprixelcopied;    // sprixel bytes copied into the frame buffer
+  uint64_t sprixelspliced;   // sprixel bytes written without being copied
+  uint64_t dynpal_saved;     // SGR bytes saved through dynamic palette registers
+  uint64_t dynpal_spent;     // bytes spent programming dynamic palette registers
 } ncstats;
 
 // Allocate an ncstats object. Use this rather than allocating your own, since
@@ -1996,6 +2115,41 @@ API int ncplane_scrollup(struct ncplane* n, int r)
 API int ncplane_scrollup_child(struct ncplane* n, const struct ncplane* child)
   __attribute__ ((nonnull (1, 2)));
 
+// A scrollback store retains the rows which scroll off the top of a plane,
+// compressing them into pages. Compressed pages beyond 'maxresident' bytes
+// are written to an unlinked temporary file, and mapped back in as needed.
+typedef struct ncscrollback_options {
+  // retain at least the most recent 'maxrows' rows, discarding older ones
+  // a page at a time. 0 retains everything.
+  unsigned maxrows;
+  // bytes of compressed pages to keep in memory. older pages are spilled to
+  // disk. 0 keeps all pages in memory.
+  size_t maxresident;
+  // directory in which to create the spill file. NULL uses $TMPDIR, or /tmp.
+  const char* spilldir;
+  uint64_t flags;  // currently must be 0
+} ncscrollback_options;
+
+// Attach a scrollback store to 'n', replacing (and discarding) any existing
+// store, or detach and discard it if 'opts' is NULL. Rows enter the store
+// only as 'n' scrolls (an autogrowing plane grows rather than scrolling).
+API int ncplane_set_scrollback(struct ncplane* n, const ncscrollback_options* opts)
+  __attribute__ ((nonnull (1)));
+
+// Return the number of rows held in n's scrollback store (0 if there is none).
+API unsigned ncplane_scrollback_rows(const struct ncplane* n)
+  __attribute__ ((nonnull (1)));
+
+// Draw a window onto the history of 'n' into 'dst', which must be some other
+// plane. The top row of 'dst' receives the row 'back' rows above the top of
+// 'n', and successive rows follow, continuing into the rows of 'n' once the
+// scrollback is exhausted. If 'back' exceeds the rows retained, the window
+// begins at the oldest. Cells of 'dst' without a source are erased. Returns
+// the number of rows drawn from the scrollback, or -1 on error.
+API int ncplane_scrollback_window(struct ncplane* n, unsigned back,
+                                  struct ncplane* dst)
+  __attribute__ ((nonnull (1, 3)));
+
 // Rotate the plane π/2 radians clockwise or counterclockwise. This cannot
 // be performed on arbitrary planes, because glyphs cannot be arbitrarily
 // rotated. The glyphs which can be rotated are limited: line-drawing
@@ -4541,14 +4695,31 @@ typedef int(*ncfdplane_done_cb)(struct ncfdplane* n, int fderrno, void* curry);
 // callback will be invoked, and the user ought destroy the ncfdplane. the
 // data is *not* guaranteed to be nul-terminated, and may contain arbitrary
 // zeroes.
+
+// 'bufsize' and 'coalesce_ns' are valid (they are otherwise not read, and
+// need not be present in the structure).
+#define NCOPTION_FDPLANE_BATCH 0x0001ull
+
 typedef struct ncfdplane_options {
   void* curry;    // parameter provided to callbacks
   bool follow;    // keep reading after hitting end? (think tail -f)
   uint64_t flags; // bitfield over NCOPTION_FDPLANE_*
+  // the following are only read if NCOPTION_FDPLANE_BATCH is set.
+  // the fd is read until it would block or this many bytes have been
+  // accumulated, and the data is then handed to the callback in one go.
+  // 0 selects BUFSIZ.
+  size_t bufsize;
+  // if non-zero, data arriving within this many nanoseconds of the previous
+  // callback is held back (up to 'bufsize' bytes), and delivered in a single
+  // callback once the interval has passed. this bounds the callback rate for
+  // chatty sources.
+  uint64_t coalesce_ns;
 } ncfdplane_options;
 
 // Create an ncfdplane around the fd 'fd'. Consider this function to take
 // ownership of the file descriptor, which will be closed in ncfdplane_destroy().
+// If 'cbfxn' is NULL, a built-in callback writes the data to the plane; the
+// caller remains responsible for rendering it.
 API ALLOC struct ncfdplane* ncfdplane_create(struct ncplane* n, const ncfdplane_options* opts,
                                              int fd, ncfdplane_callback cbfxn, ncfdplane_done_cb donecbfxn)
   __attribute__ ((nonnull (1)));
@@ -4558,13 +4729,20 @@ API struct ncplane* ncfdplane_plane(struct ncfdplane* n)
 
 API int ncfdplane_destroy(struct ncfdplane* n);
 
+// as NCOPTION_FDPLANE_BATCH, for ncsubproc_options.
+#define NCOPTION_SUBPROC_BATCH 0x0001ull
+
 typedef struct ncsubproc_options {
   void* curry;
   uint64_t restart_period; // restart this many seconds after an exit (watch)
   uint64_t flags;          // bitfield over NCOPTION_SUBPROC_*
+  // only read if NCOPTION_SUBPROC_BATCH is set; see ncfdplane_options
+  size_t bufsize;
+  uint64_t coalesce_ns;
 } ncsubproc_options;
 
-// see exec(2). p-types use $PATH. e-type passes environment vars.
+// see exec(2). p-types use $PATH. e-type passes environment vars. as with
+// ncfdplane_create(), a NULL 'cbfxn' selects the built-in plane writer.
 API ALLOC struct ncsubproc* ncsubproc_createv(struct ncplane* n, const ncsubproc_options* opts,
                                               const char* bin, const char* const arg[],
                                               ncfdplane_callback cbfxn, ncfdplane_done_cb donecbfxn)
@@ -63,6 +63,10 @@ struct winsize {
  unsigned short ws_ypixel;
 };
 #define WNOHANG 0
+struct iovec {
+ void* iov_base;
+ size_t iov_len;
+};
 #else
 static inline char
 path_separator(void){
@@ -75,6 +79,7 @@ path_separator(void){
 #include <sys/time.h>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #endif
 
 // get the default data directory (heap-allocated). on unix, this is compiled
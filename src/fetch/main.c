@@ -1,3 +1,4 @@
+#include <time.h>
 #include <errno.h>
 #include <stdio.h>
 #include <fcntl.h>
@@ -8,6 +9,7 @@
 #include <strings.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include <sys/stat.h>
 #include <sys/param.h>
 #include <sys/types.h>
 #if defined(__linux__) || defined(__gnu_hurd__)
@@ -54,6 +56,7 @@ typedef struct fetched_info {
   char* username;              // we borrow a reference
   char* hostname; 
   const distro_info* distro;
+  char* distro_id;             // strdup(ID) from /etc/os-release
   char* logo;                  // strdup() from /etc/os-release
   char* distro_pretty;         // strdup() from /etc/os-release
   char* kernel;                // strdup(uname(2)->name)
@@ -76,6 +79,8 @@ free_fetched_info(fetched_info* fi){
   free(fi->kernel);
   free(fi->kernver);
   free(fi->distro_pretty);
+  free(fi->distro_id);
+  free(fi->logo);
   free(fi->term);
 }
 
@@ -209,9 +214,12 @@ fetch_cpu_info(fetched_info* fi){
 #undef TAG
 #undef CORE
   }
+  fclose(cpuinfo);
   return 0;
 }
 
+#define OSRELEASE "/etc/os-release"
+
 #ifdef __linux__
 // Given a filename, check for its existence in the directories specified by
 // https://specifications.freedesktop.org/icon-theme-spec/latest/ar01s03.html.
@@ -235,11 +243,11 @@ get_xdg_logo(const char *spec){
 }
 #endif
 
-// FIXME deal more forgivingly with quotation marks
-static const distro_info*
-linux_ncneofetch(fetched_info* fi){
-  const distro_info* dinfo = NULL;
 #ifdef __linux__
+// map fi->distro_id to its known logo, if any, and to neofetch art if we
+// have no logo from /etc/os-release.
+static const distro_info*
+linux_distro(fetched_info* fi){
   static const distro_info distros[] = {
     {
       .name = "arch",
@@ -266,7 +274,25 @@ linux_ncneofetch(fetched_info* fi){
       .logofile = NULL,
     },
   };
-  FILE* osinfo = fopen("/etc/os-release", "re");
+  const distro_info* dinfo;
+  for(dinfo = distros ; dinfo->name ; ++dinfo){
+    if(strcmp(dinfo->name, fi->distro_id) == 0){
+      break;
+    }
+  }
+  if(fi->logo == NULL){
+    fi->neologo = get_neofetch_art(fi->distro_id);
+  }
+  return dinfo;
+}
+#endif
+
+// FIXME deal more forgivingly with quotation marks
+static const distro_info*
+linux_ncneofetch(fetched_info* fi){
+  const distro_info* dinfo = NULL;
+#ifdef __linux__
+  FILE* osinfo = fopen(OSRELEASE, "re");
   if(osinfo == NULL){
     return NULL;
   }
@@ -311,21 +337,175 @@ linux_ncneofetch(fetched_info* fi){
   if(distro == NULL){
     return NULL;
   }
-  for(dinfo = distros ; dinfo->name ; ++dinfo){
-    if(strcmp(dinfo->name, distro) == 0){
-      break;
-    }
-  }
-  if(fi->logo == NULL){
-    fi->neologo = get_neofetch_art(distro);
-  }
-  free(distro);
+  fi->distro_id = distro;
+  dinfo = linux_distro(fi);
 #else
   (void)fi;
 #endif
   return dinfo;
 }
 
+#ifdef __linux__
+// the distro, logo path, and CPU model are slow to acquire on a cold cache,
+// and rarely change. with -c, they're stored in $XDG_CACHE_HOME/ncneofetch.
+// the cache is valid so long as /etc/os-release and the logo have the
+// mtimes we recorded, and we haven't since rebooted.
+static char*
+fact_cache_path(void){
+  const char* base = getenv("XDG_CACHE_HOME");
+  const char* sub = "";
+  if(base == NULL || *base == '\0'){
+    if((base = getenv("HOME")) == NULL){
+      return NULL;
+    }
+    sub = "/.cache";
+  }
+  const char* fname = "/ncneofetch";
+  char* path = malloc(strlen(base) + strlen(sub) + strlen(fname) + 1);
+  if(path){
+    strcpy(path, base);
+    strcat(path, sub);
+    strcat(path, fname);
+  }
+  return path;
+}
+
+// boot time in seconds since the epoch, as best we can tell. it's derived
+// from the uptime, and thus jitters by a second.
+static long
+boot_time(void){
+  struct sysinfo sinfo;
+  if(sysinfo(&sinfo)){
+    return -1;
+  }
+  return (long)time(NULL) - sinfo.uptime;
+}
+
+// mtime of path as "sec.nsec", or "0.0" if it can't be stat(2)ed.
+static void
+mtime_string(const char* path, char* buf, size_t len){
+  struct stat st;
+  if(path == NULL || stat(path, &st)){
+    snprintf(buf, len, "0.0");
+  }else{
+    snprintf(buf, len, "%lld.%09ld", (long long)st.st_mtim.tv_sec,
+             st.st_mtim.tv_nsec);
+  }
+}
+
+// returns 0 and fills in the static facts of fi if the cache at path is
+// present and valid. otherwise, fi is untouched.
+static int
+load_fact_cache(const char* path, fetched_info* fi){
+  FILE* fp = fopen(path, "re");
+  if(fp == NULL){
+    return -1;
+  }
+  char osmtime[64], logomtime[64];
+  fetched_info cached = {0};
+  bool osvalid = false, logovalid = false, bootvalid = false;
+  int cores = -1;
+  char buf[BUFSIZ];
+  while(fgets(buf, sizeof(buf), fp)){
+    char* nl = strchr(buf, '\n');
+    if(nl){
+      *nl = '\0';
+    }
+    char* val = strchr(buf, ' ');
+    if(val == NULL){
+      continue;
+    }
+    *val++ = '\0';
+    if(strcmp(buf, "osrelease") == 0){
+      mtime_string(OSRELEASE, osmtime, sizeof(osmtime));
+      osvalid = (strcmp(val, osmtime) == 0);
+    }else if(strcmp(buf, "logomtime") == 0){
+      // the logo is always written before its mtime
+      mtime_string(cached.logo, logomtime, sizeof(logomtime));
+      logovalid = (strcmp(val, logomtime) == 0);
+    }else if(strcmp(buf, "boot") == 0){
+      long boot = strtol(val, NULL, 10);
+      long now = boot_time();
+      bootvalid = (now >= 0 && labs(now - boot) <= 2);
+    }else if(strcmp(buf, "id") == 0){
+      free(cached.distro_id);
+      cached.distro_id = strdup(val);
+    }else if(strcmp(buf, "pretty") == 0){
+      free(cached.distro_pretty);
+      cached.distro_pretty = strdup(val);
+    }else if(strcmp(buf, "logo") == 0){
+      free(cached.logo);
+      cached.logo = strdup(val);
+    }else if(strcmp(buf, "cpu") == 0){
+      free(cached.cpu_model);
+      cached.cpu_model = strdup(val);
+    }else if(strcmp(buf, "cores") == 0){
+      cores = atoi(val);
+    }
+  }
+  fclose(fp);
+  if(!osvalid || !bootvalid || cores < 0 || cached.distro_id == NULL ||
+     (cached.logo && !logovalid)){
+    free_fetched_info(&cached);
+    return -1;
+  }
+  fi->distro_id = cached.distro_id;
+  fi->distro_pretty = cached.distro_pretty;
+  fi->logo = cached.logo;
+  fi->cpu_model = cached.cpu_model;
+  fi->core_count = cores;
+  fi->distro = linux_distro(fi);
+  return 0;
+}
+
+// write the static facts of fi to the cache at path. the new cache is
+// renamed into place, so a concurrent reader never sees a partial file.
+static int
+save_fact_cache(const char* path, const fetched_info* fi){
+  if(fi->distro_id == NULL){
+    return -1;
+  }
+  char* tmp = malloc(strlen(path) + 8);
+  if(tmp == NULL){
+    return -1;
+  }
+  sprintf(tmp, "%s.XXXXXX", path);
+  int fd = mkstemp(tmp);
+  if(fd < 0){
+    free(tmp);
+    return -1;
+  }
+  FILE* fp = fdopen(fd, "w");
+  if(fp == NULL){
+    close(fd);
+    unlink(tmp);
+    free(tmp);
+    return -1;
+  }
+  char osmtime[64], logomtime[64];
+  mtime_string(OSRELEASE, osmtime, sizeof(osmtime));
+  int r = fprintf(fp, "osrelease %s\nboot %ld\nid %s\ncores %d\n", osmtime,
+                  boot_time(), fi->distro_id, fi->core_count);
+  if(r >= 0 && fi->distro_pretty){
+    r = fprintf(fp, "pretty %s\n", fi->distro_pretty);
+  }
+  if(r >= 0 && fi->logo){
+    mtime_string(fi->logo, logomtime, sizeof(logomtime));
+    r = fprintf(fp, "logo %s\nlogomtime %s\n", fi->logo, logomtime);
+  }
+  if(r >= 0 && fi->cpu_model){
+    r = fprintf(fp, "cpu %s\n", fi->cpu_model);
+  }
+  if(fclose(fp) || r < 0 || rename(tmp, path)){
+    unlink(tmp);
+    free(tmp);
+    return -1;
+  }
+  free(tmp);
+  return 0;
+}
+#endif
+
 typedef enum {
   NCNEO_LINUX,
   NCNEO_FREEBSD,
@@ -653,11 +833,21 @@ infoplane(struct notcurses* nc, const fetched_info* fi, int nextline){
 struct marshal {
   int nextline; // line following display plane, where info plane ought be placed
   struct notcurses* nc;
-  const distro_info* dinfo;
-  const char* logo; // read from /etc/os-release (or builtin), may be NULL
+  const char* logo; // from /etc/os-release or the distro table, may be NULL
   const char* neologo; // fallback from neofetch, text with color sub templates
+  bool decoding;    // is decode_thread() loading logo into ncv?
+  pthread_t decodetid;
+  struct ncvisual* ncv;
 };
 
+// decode the logo while the palette is drawn and the system is probed
+static void*
+decode_thread(void* vmarshal){
+  struct marshal* m = vmarshal;
+  m->ncv = ncvisual_from_file(m->logo);
+  return NULL;
+}
+
 // present a neofetch-style logo. we want to substitute colors for ${cN} inline
 // sequences, and center the logo.
 static int
@@ -721,12 +911,13 @@ display_thread(void* vmarshal){
   // we've just rendered, so any necessary scrolling has been performed. draw
   // our image wherever the palette ended, and then scroll as necessary to
   // make that new plane visible.
-  if(notcurses_canopen_images(m->nc)){
-    struct ncvisual* ncv = NULL;
-    if(m->logo){
+  if(m->logo){
+    struct ncvisual* ncv;
+    if(m->decoding){
+      pthread_join(m->decodetid, NULL);
+      ncv = m->ncv;
+    }else{
       ncv = ncvisual_from_file(m->logo);
-    }else if(m->dinfo && m->dinfo->logofile){
-      ncv = ncvisual_from_file(m->dinfo->logofile);
     }
     if(ncv){
       unsigned y;
@@ -768,13 +959,54 @@ display_thread(void* vmarshal){
   return NULL;
 }
 
+struct cpuprobe {
+  ncneo_kernel_e kern;
+  fetched_info* fi; // we write only cpu_model and core_count
+};
+
+static void*
+cpu_thread(void* vprobe){
+  struct cpuprobe* probe = vprobe;
+  if(probe->kern == NCNEO_LINUX){
+    fetch_cpu_info(probe->fi);
+  }else if(probe->kern == NCNEO_WINDOWS){
+    fetch_windows_cpuinfo(probe->fi);
+  }else{
+    fetch_bsd_cpuinfo(probe->fi);
+  }
+  return NULL;
+}
+
 static int
-ncneofetch(struct notcurses* nc){
+ncneofetch(struct notcurses* nc, bool usecache){
   fetched_info fi = {0};
   ncneo_kernel_e kern = get_kernel(&fi);
+  char* cachepath = NULL;
+  bool cached = false;
+#ifdef __linux__
+  if(usecache && kern == NCNEO_LINUX && (cachepath = fact_cache_path())){
+    cached = !load_fact_cache(cachepath, &fi);
+  }
+#else
+  (void)usecache;
+#endif
+  // the CPU probe is independent of the distro probe, so run them together
+  struct cpuprobe probe = {
+    .kern = kern,
+    .fi = &fi,
+  };
+  pthread_t cputid;
+  bool cpulaunched = false;
+  if(!cached){
+    if(!(cpulaunched = !pthread_create(&cputid, NULL, cpu_thread, &probe))){
+      cpu_thread(&probe);
+    }
+  }
   switch(kern){
     case NCNEO_LINUX:
-      fi.distro = linux_ncneofetch(&fi);
+      if(!cached){
+        fi.distro = linux_ncneofetch(&fi);
+      }
       break;
     case NCNEO_FREEBSD:
       fi.distro = freebsd_ncneofetch(&fi);
@@ -791,29 +1023,44 @@ ncneofetch(struct notcurses* nc){
     case NCNEO_UNKNOWN:
       break;
   }
-  // go ahead and spin the image load + render into its own thread while the
-  // rest of the fetching continues. cuts total runtime.
+  // go ahead and spin the image load + render into their own threads while
+  // the rest of the fetching continues. the logo is decoded while the
+  // palette is drawn, and blitted as soon as both are done.
   struct marshal display_marshal = {
     .nc = nc,
-    .dinfo = fi.distro,
-    .logo = fi.logo,
     .neologo = fi.neologo,
     .nextline = -1,
   };
+  if(notcurses_canopen_images(nc)){
+    if(fi.logo){
+      display_marshal.logo = fi.logo;
+    }else if(fi.distro && fi.distro->logofile){
+      display_marshal.logo = fi.distro->logofile;
+    }
+    if(display_marshal.logo){
+      display_marshal.decoding = !pthread_create(&display_marshal.decodetid,
+                                                 NULL, decode_thread,
+                                                 &display_marshal);
+    }
+  }
   pthread_t tid;
   const bool launched = !pthread_create(&tid, NULL, display_thread, &display_marshal);
   fi.hostname = notcurses_hostname();
   fi.username = notcurses_accountname();
   fetch_env_vars(nc, &fi);
-  if(kern == NCNEO_LINUX){
-    fetch_cpu_info(&fi);
-  }else if(kern == NCNEO_WINDOWS){
-    fetch_windows_cpuinfo(&fi);
-  }else{
-    fetch_bsd_cpuinfo(&fi);
+  if(cpulaunched){
+    pthread_join(cputid, NULL);
+  }
+#ifdef __linux__
+  if(cachepath && !cached){
+    save_fact_cache(cachepath, &fi);
   }
+#endif
+  free(cachepath);
   if(launched){
     pthread_join(tid, NULL);
+  }else{
+    display_thread(&display_marshal);
   }
   assert(display_marshal.nextline >= 0);
   if(infoplane(nc, &fi, display_marshal.nextline)){
@@ -826,7 +1073,7 @@ ncneofetch(struct notcurses* nc){
 
 static void
 usage(const char* arg0, FILE* fp){
-  fprintf(fp, "usage: %s [ -v ]\n", arg0);
+  fprintf(fp, "usage: %s [ -v ] [ -c ]\n", arg0);
   if(fp == stderr){
     exit(EXIT_FAILURE);
   }
@@ -841,11 +1088,12 @@ int main(int argc, char** argv){
              | NCOPTION_PRESERVE_CURSOR
              | NCOPTION_DRAIN_INPUT,
   };
-  if(argc > 2){
-    usage(argv[0], stderr);
-  }else if(argc == 2){
-    if(strcmp(argv[1], "-v") == 0){
+  bool usecache = false;
+  for(int i = 1 ; i < argc ; ++i){
+    if(strcmp(argv[i], "-v") == 0){
       opts.loglevel = NCLOGLEVEL_TRACE;
+    }else if(strcmp(argv[i], "-c") == 0){
+      usecache = true;
     }else{
       usage(argv[0], stderr);
     }
@@ -856,6 +1104,6 @@ int main(int argc, char** argv){
   }
   struct ncplane* stdn = notcurses_stdplane(nc);
   ncplane_set_scrolling(stdn, true);
-  int r = ncneofetch(nc);
+  int r = ncneofetch(nc, usecache);
   return r ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -0,0 +1,139 @@
+#include "internal.h"
+
+// widgets create and destroy many small planes, each of which costs a plane
+// struct and a framebuffer from the heap. each pile keeps a few of both
+// around for reuse. framebuffers of up to ARENA_MAX_CELLS cells are rounded
+// up to a size class (two per power of two), so that any freed framebuffer
+// can satisfy any later request of its class. larger framebuffers go
+// straight to the heap. a pile is only ever manipulated by one thread at a
+// time, so no locking is necessary.
+
+#define ARENA_MIN_CELLS 16
+#define ARENA_MAX_CELLS 4096
+// each size class retains at most this many bytes of free framebuffers
+// (but always at least one).
+#define ARENA_CLASS_BYTES 32768
+#define ARENA_MAX_SHELLS 32
+
+// returns the size class for a framebuffer of |cells| cells, writing the
+// number of cells actually allocated for that class to |classcells|, or -1
+// if |cells| is too large to be pooled.
+static inline int
+fbclass(size_t cells, size_t* classcells){
+  if(cells > ARENA_MAX_CELLS){
+    *classcells = cells;
+    return -1;
+  }
+  if(cells <= ARENA_MIN_CELLS){
+    *classcells = ARENA_MIN_CELLS;
+    return 0;
+  }
+  // ARENA_MIN_CELLS < cells, so the log is at least 4
+  unsigned lg = 63 - __builtin_clzll(cells - 1);
+  size_t base = 1ull << lg;
+  int idx = (lg - 4) * 2 + 1;
+  if(cells <= base + base / 2){
+    *classcells = base + base / 2;
+    return idx;
+  }
+  *classcells = base * 2;
+  return idx + 1;
+}
+
+static inline unsigned
+fbclass_limit(size_t classcells){
+  unsigned lim = ARENA_CLASS_BYTES / (classcells * sizeof(nccell));
+  return lim ? lim : 1;
+}
+
+// the contents of the returned framebuffer are undefined. pile may be NULL.
+nccell* ncpile_fb_alloc(ncpile* pile, size_t cells){
+  size_t classcells;
+  int c = fbclass(cells, &classcells);
+  if(c >= 0 && pile && pile->fbfree[c]){
+    nccell* fb = pile->fbfree[c];
+    memcpy(&pile->fbfree[c], fb, sizeof(fb));
+    --pile->fbcount[c];
+    return fb;
+  }
+  return malloc(classcells * sizeof(nccell));
+}
+
+// fb must have come from ncpile_fb_alloc() (of any pile) with |cells|.
+void ncpile_fb_free(ncpile* pile, nccell* fb, size_t cells){
+  if(fb == NULL){
+    return;
+  }
+  size_t classcells;
+  int c = fbclass(cells, &classcells);
+  if(c >= 0 && pile && pile->fbcount[c] < fbclass_limit(classcells)){
+    // the freelist is threaded through the first bytes of each framebuffer
+    memcpy(fb, &pile->fbfree[c], sizeof(fb));
+    pile->fbfree[c] = fb;
+    ++pile->fbcount[c];
+    return;
+  }
+  free(fb);
+}
+
+// resize fb from |oldcells| to |newcells|, preserving the first
+// min(oldcells, newcells) cells. returns NULL on failure, in which case fb is
+// untouched. if both sizes fall in the same class, fb is returned as-is.
+nccell* ncpile_fb_realloc(ncpile* pile, nccell* fb, size_t oldcells,
+                          size_t newcells){
+  size_t oldclass, newclass;
+  int oldc = fbclass(oldcells, &oldclass);
+  int newc = fbclass(newcells, &newclass);
+  if(oldc >= 0 && oldc == newc){
+    return fb;
+  }
+  if(oldc < 0 && newc < 0){
+    return realloc(fb, newclass * sizeof(nccell));
+  }
+  nccell* ret = ncpile_fb_alloc(pile, newcells);
+  if(ret){
+    memcpy(ret, fb, sizeof(*fb) * (oldcells < newcells ? oldcells : newcells));
+    ncpile_fb_free(pile, fb, oldcells);
+  }
+  return ret;
+}
+
+// a recycled plane is zeroed; a fresh one is not. pile may be NULL.
+ncplane* ncpile_plane_alloc(ncpile* pile){
+  if(pile && pile->shells){
+    ncplane* p = pile->shells;
+    pile->shells = p->bnext;
+    --pile->shellcount;
+    memset(p, 0, sizeof(*p));
+    return p;
+  }
+  return malloc(sizeof(ncplane));
+}
+
+// p must have been fully torn down.
+void ncpile_plane_free(ncpile* pile, ncplane* p){
+  if(pile && pile->shellcount < ARENA_MAX_SHELLS){
+    p->bnext = pile->shells;
+    pile->shells = p;
+    ++pile->shellcount;
+    return;
+  }
+  free(p);
+}
+
+void ncpile_arena_release(ncpile* pile){
+  while(pile->shells){
+    ncplane* p = pile->shells;
+    pile->shells = p->bnext;
+    free(p);
+  }
+  pile->shellcount = 0;
+  for(unsigned c = 0 ; c < ARENA_FBCLASSES ; ++c){
+    while(pile->fbfree[c]){
+      nccell* fb = pile->fbfree[c];
+      memcpy(&pile->fbfree[c], fb, sizeof(fb));
+      free(fb);
+    }
+    pile->fbcount[c] = 0;
+  }
+}
@@ -15,6 +15,12 @@
 // sequences to be coming in from the connected terminal, and everything else
 // is bulk input.
 
+// set in a compiled transition if the target node requires any action upon
+// being entered (it accepts, calls a function, or begins a string). pure
+// transit nodes, including numeric accumulators and kleene closures, lack it,
+// and can thus be walked without ever touching the node itself.
+#define AUTOMATON_ACTION 0x80000000u
+
 // we assumed escapes can only be composed of 7-bit chars
 typedef struct esctrie {
   // if non-NULL, this is the next level of radix-128 trie. it is NULL on
@@ -79,6 +85,8 @@ create_esctrie_node(automaton* a, int special){
 }
 
 void input_free_esctrie(automaton* a){
+  free(a->delta);
+  a->delta = NULL;
   a->escapes = 0;
   a->poolsize = 0;
   for(unsigned i = 0 ; i < a->poolused ; ++i){
@@ -412,6 +420,10 @@ link_numeric(automaton* a, const char* prefix, int pfxlen,
 
 static esctrie*
 insert_path(automaton* a, const char* seq){
+  if(a->delta){
+    logerror("automaton has already been compiled");
+    return NULL;
+  }
   if(a->escapes == 0){
     if((a->escapes = create_esctrie_node(a, 0)) == 0){
       return NULL;
@@ -539,6 +551,63 @@ int inputctx_add_input_escape(automaton* a, const char* esc, uint32_t special,
   return 0;
 }
 
+// does entering |e| require anything more than updating our state?
+static inline bool
+esctrie_action_p(const esctrie* e){
+  switch(e->ntype){
+    case NODE_NUMERIC:
+      return false;
+    case NODE_SPECIAL:
+      return e->ni.id != 0;
+    case NODE_STRING:
+    case NODE_FUNCTION:
+      break;
+  }
+  return true;
+}
+
+int compile_automaton(automaton* a){
+  if(a->poolused >= AUTOMATON_ACTION){
+    logerror("too many nodes to compile (%u)", a->poolused);
+    return -1;
+  }
+  const size_t rowlen = 0x80;
+  unsigned* delta = malloc(sizeof(*delta) * rowlen * a->poolused);
+  if(delta == NULL){
+    return -1;
+  }
+  for(unsigned i = 0 ; i < a->poolused ; ++i){
+    const esctrie* e = &a->nodepool[i];
+    unsigned* row = delta + i * rowlen;
+    if(e->trie == NULL){
+      memset(row, 0, sizeof(*row) * rowlen);
+      continue;
+    }
+    for(unsigned c = 0 ; c < rowlen ; ++c){
+      row[c] = e->trie[c];
+      if(row[c] && esctrie_action_p(esctrie_from_idx(a, row[c]))){
+        row[c] |= AUTOMATON_ACTION;
+      }
+    }
+  }
+  // the radix tries are no longer needed; the table supersedes them
+  for(unsigned i = 0 ; i < a->poolused ; ++i){
+    free(a->nodepool[i].trie);
+    a->nodepool[i].trie = NULL;
+  }
+  free(a->delta);
+  a->delta = delta;
+  loginfo("compiled %u automaton nodes (%zuB)", a->poolused,
+          sizeof(*delta) * rowlen * a->poolused);
+  return 0;
+}
+
+// look up the compiled transition from 1-biased |state| on |candidate|.
+static inline unsigned
+automaton_delta(const automaton* a, unsigned state, unsigned candidate){
+  return a->delta[(state - 1) * 0x80 + candidate];
+}
+
 // returns -1 for non-match, 0 for match, 1 for acceptance. if we are in the
 // middle of a sequence, and receive an escape, *do not call this*, but
 // instead call reset_automaton() after replaying the used characters to the
@@ -549,16 +618,16 @@ int walk_automaton(automaton* a, struct inputctx* ictx, unsigned candidate,
     logerror("eight-bit char %u in control sequence", candidate);
     return -1;
   }
-  esctrie* e = esctrie_from_idx(a, a->state);
   // we ought not have been called for an escape with any state!
   if(candidate == 0x1b && !a->instring){
-    assert(NULL == e);
+    assert(0 == a->state);
     a->state = a->escapes;
     return 0;
   }
-  if(e->ntype == NODE_STRING){
+  esctrie* e;
+  if(a->instring){
     if(candidate == 0x1b || candidate == 0x07){
-      a->state = e->trie[candidate];
+      a->state = automaton_delta(a, a->state, candidate) & ~AUTOMATON_ACTION;
       a->instring = 0;
     }
     e = esctrie_from_idx(a, a->state);
@@ -570,17 +639,22 @@ int walk_automaton(automaton* a, struct inputctx* ictx, unsigned candidate,
     }
     return 0;
   }
-  if((a->state = e->trie[candidate]) == 0){
-    if(esctrie_idx(a, e) == a->escapes){
+  unsigned prev = a->state;
+  unsigned t = automaton_delta(a, prev, candidate);
+  if((a->state = t & ~AUTOMATON_ACTION) == 0){
+    if(prev == a->escapes){
       memset(ni, 0, sizeof(*ni));
       ni->id = candidate;
       ni->alt = true;
       return 1;
     }
-    loginfo("unexpected transition on %u[%u]",
-            esctrie_idx(a, e), candidate);
+    loginfo("unexpected transition on %u[%u]", prev, candidate);
     return -1;
   }
+  // pure transit (including numeric accumulation); nothing else to do
+  if(!(t & AUTOMATON_ACTION)){
+    return 0;
+  }
   e = esctrie_from_idx(a, a->state);
   // initialize any node we've just stepped into
   switch(e->ntype){
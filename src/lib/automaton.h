@@ -28,6 +28,11 @@ typedef struct automaton {
   unsigned poolsize;
   unsigned poolused;
   struct esctrie* nodepool;
+  // once construction is complete, compile_automaton() flattens the trie into
+  // a single table of 0x80 transitions per node. entries are 1-biased node
+  // indices, possibly ORed with AUTOMATON_ACTION (see automaton.c). no further
+  // paths may be added once compiled.
+  unsigned* delta;
 } automaton;
 
 // wipe out all storage internal to |a| (but not |a| itself).
@@ -39,6 +44,11 @@ int inputctx_add_input_escape(automaton* a, const char* esc,
 int inputctx_add_cflow(automaton* a, const char* csi, triefunc fxn)
   __attribute__ ((nonnull (1, 2)));
 
+// flatten the trie into the transition table used by walk_automaton(). must
+// be called after all escapes have been added, and before any walking.
+int compile_automaton(automaton* a)
+  __attribute__ ((nonnull (1)));
+
 int walk_automaton(automaton* a, struct inputctx* ictx, unsigned candidate,
                    struct ncinput* ni)
   __attribute__ ((nonnull (1, 2, 4)));
@@ -965,6 +965,68 @@ const struct blitset* lookup_blitset(const tinfo* tcache, ncblitter_e setid,
   return &notcurses_blitters[setid - 1];
 }
 
+// Reverse maps from a cell's gcluster to its index in a blitset's 'egcs', for
+// ncplane_as_rgba(). Every blitter EGC is a single codepoint of at most four
+// UTF-8 bytes, and is thus stored inline in the nccell; we can key directly
+// on the gcluster, without extracting or decoding anything.
+#define EGCREV_SLOTS 512 // power of two, at least twice the largest set
+
+typedef struct egcrev {
+  uint32_t keys[EGCREV_SLOTS]; // gclusters; 0 (the empty EGC) marks a free slot
+  uint16_t idx[EGCREV_SLOTS];
+} egcrev;
+
+static egcrev egcrevs[sizeof(notcurses_blitters) / sizeof(*notcurses_blitters)];
+static pthread_once_t egcrevs_once = PTHREAD_ONCE_INIT;
+
+static inline unsigned
+egcrev_slot(uint32_t gcluster){
+  return (gcluster * 2654435761u) >> 23; // top 9 bits
+}
+
+static void
+build_egcrevs(void){
+  _Static_assert(EGCREV_SLOTS == 1u << (32 - 23), "egcrev_slot() disagrees");
+  for(size_t b = 0 ; notcurses_blitters[b].geom ; ++b){
+    const wchar_t* egcs = notcurses_blitters[b].egcs;
+    if(egcs == NULL){
+      continue;
+    }
+    for(unsigned i = 0 ; egcs[i] ; ++i){
+      uint32_t ucs32 = egcs[i];
+      unsigned char utf8[WCHAR_MAX_UTF8BYTES] = {0};
+      if(notcurses_ucs32_to_utf8(&ucs32, 1, utf8, sizeof(utf8)) < 0){
+        logpanic("couldn't encode %s egc %u", notcurses_blitters[b].name, i);
+        continue;
+      }
+      uint32_t key;
+      memcpy(&key, utf8, sizeof(key));
+      unsigned slot = egcrev_slot(key);
+      while(egcrevs[b].keys[slot] && egcrevs[b].keys[slot] != key){
+        slot = (slot + 1) % EGCREV_SLOTS;
+      }
+      egcrevs[b].keys[slot] = key;
+      egcrevs[b].idx[slot] = i; // later duplicates win, as with wcsrchr()
+    }
+  }
+}
+
+int blitset_egc_idx(const struct blitset* bset, uint32_t gcluster){
+  pthread_once(&egcrevs_once, build_egcrevs);
+  if(gcluster == 0){ // the empty EGC is all background, as is space
+    return 0;
+  }
+  const egcrev* rev = &egcrevs[bset - notcurses_blitters];
+  unsigned slot = egcrev_slot(gcluster);
+  while(rev->keys[slot]){
+    if(rev->keys[slot] == gcluster){
+      return rev->idx[slot];
+    }
+    slot = (slot + 1) % EGCREV_SLOTS;
+  }
+  return -1;
+}
+
 int notcurses_lex_blitter(const char* op, ncblitter_e* blitfxn){
   const struct blitset* bset = notcurses_blitters;
   while(bset->name){
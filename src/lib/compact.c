@@ -0,0 +1,368 @@
+#include "internal.h"
+
+// NCPLANE_OPTION_COMPACT planes store 8-byte nccompacts rather than 16-byte
+// nccells. large text planes tend to use a handful of channel pairs, so we
+// intern them into a per-plane table, and store a 16-bit index. if a plane
+// needs more than 65536 pairs at once (or uses styles which don't fit in 8
+// bits), it is converted to a full framebuffer.
+
+#define COMPACT_MAXPAIRS 65536u
+
+static inline unsigned
+pair_slot(uint64_t channels, unsigned mask){
+  return ((channels * 0x9e3779b97f4a7c15ull) >> 32u) & mask;
+}
+
+static int
+pairs_rehash(compactfb* cfb, unsigned hashcap){
+  uint16_t* hash = calloc(hashcap, sizeof(*hash));
+  if(hash == NULL){
+    return -1;
+  }
+  for(unsigned i = 1 ; i < cfb->paircount ; ++i){
+    unsigned slot = pair_slot(cfb->pairs[i], hashcap - 1);
+    while(hash[slot]){
+      slot = (slot + 1) & (hashcap - 1);
+    }
+    hash[slot] = i;
+  }
+  free(cfb->pairhash);
+  cfb->pairhash = hash;
+  cfb->hashcap = hashcap;
+  return 0;
+}
+
+static int
+pairs_init(compactfb* cfb){
+  cfb->paircap = 16;
+  cfb->paircount = 1;
+  if((cfb->pairs = malloc(sizeof(*cfb->pairs) * cfb->paircap)) == NULL){
+    return -1;
+  }
+  cfb->pairs[0] = 0;
+  cfb->hashcap = 0;
+  cfb->pairhash = NULL;
+  if(pairs_rehash(cfb, cfb->paircap * 2)){
+    free(cfb->pairs);
+    return -1;
+  }
+  return 0;
+}
+
+// returns the index of |channels| in the pair table, adding it if necessary.
+// returns -1 if the table is full, or on allocation failure.
+static int
+pair_intern(compactfb* cfb, uint64_t channels){
+  if(channels == 0){
+    return 0;
+  }
+  const unsigned mask = cfb->hashcap - 1;
+  unsigned slot = pair_slot(channels, mask);
+  unsigned idx;
+  while( (idx = cfb->pairhash[slot]) ){
+    if(cfb->pairs[idx] == channels){
+      return idx;
+    }
+    slot = (slot + 1) & mask;
+  }
+  if(cfb->paircount == COMPACT_MAXPAIRS){
+    return -1;
+  }
+  if(cfb->paircount == cfb->paircap){
+    unsigned newcap = cfb->paircap * 2;
+    uint64_t* tmp = realloc(cfb->pairs, sizeof(*tmp) * newcap);
+    if(tmp == NULL){
+      return -1;
+    }
+    cfb->pairs = tmp;
+    cfb->paircap = newcap;
+  }
+  idx = cfb->paircount++;
+  cfb->pairs[idx] = channels;
+  // keep the hash no more than half full
+  if(cfb->paircount * 2 > cfb->hashcap){
+    if(pairs_rehash(cfb, cfb->hashcap * 2)){
+      --cfb->paircount;
+      return -1;
+    }
+  }else{
+    cfb->pairhash[slot] = idx;
+  }
+  return idx;
+}
+
+static inline void
+compact_expand(const compactfb* cfb, const nccompact* src, nccell* dst,
+               unsigned len){
+  for(unsigned x = 0 ; x < len ; ++x){
+    dst[x].gcluster = src[x].gcluster;
+    dst[x].gcluster_backstop = 0;
+    dst[x].width = src[x].width;
+    dst[x].stylemask = src[x].stylemask;
+    dst[x].channels = cfb->pairs[src[x].pair];
+  }
+}
+
+// returns -1 if any cell can't be represented, in which case dst is partially
+// written (but holds valid pair indices).
+static int
+compact_compress(compactfb* cfb, const nccell* src, nccompact* dst,
+                 unsigned len){
+  for(unsigned x = 0 ; x < len ; ++x){
+    if(src[x].stylemask > 0xffu){
+      return -1;
+    }
+    int pair = pair_intern(cfb, src[x].channels);
+    if(pair < 0){
+      return -1;
+    }
+    dst[x].gcluster = src[x].gcluster;
+    dst[x].pair = pair;
+    dst[x].width = src[x].width;
+    dst[x].stylemask = src[x].stylemask;
+  }
+  return 0;
+}
+
+// rebuild the pair table from the cells (excepting the hot row, which is
+// about to be written back), dropping pairs no longer in use.
+static int
+compact_collect(ncplane* n){
+  compactfb* cfb = n->compact;
+  compactfb fresh;
+  if(pairs_init(&fresh)){
+    return -1;
+  }
+  // intern everything before remapping any cell, so that we can fail cleanly
+  for(int pass = 0 ; pass < 2 ; ++pass){
+    for(unsigned y = 0 ; y < n->leny ; ++y){
+      if((int)y == cfb->hoty){
+        continue;
+      }
+      nccompact* row = cfb->cells + (size_t)y * n->lenx;
+      for(unsigned x = 0 ; x < n->lenx ; ++x){
+        int pair = pair_intern(&fresh, cfb->pairs[row[x].pair]);
+        if(pair < 0){
+          free(fresh.pairs);
+          free(fresh.pairhash);
+          return -1;
+        }
+        if(pass){
+          row[x].pair = pair;
+        }
+      }
+    }
+  }
+  loginfo("collected %u pairs down to %u", cfb->paircount, fresh.paircount);
+  free(cfb->pairs);
+  free(cfb->pairhash);
+  cfb->pairs = fresh.pairs;
+  cfb->paircount = fresh.paircount;
+  cfb->paircap = fresh.paircap;
+  cfb->pairhash = fresh.pairhash;
+  cfb->hashcap = fresh.hashcap;
+  return 0;
+}
+
+static void
+compact_destroy(compactfb* cfb){
+  if(cfb){
+    free(cfb->cells);
+    free(cfb->pairs);
+    free(cfb->pairhash);
+    free(cfb->hotrow);
+    free(cfb);
+  }
+}
+
+// convert n to a full framebuffer.
+static int
+ncplane_decompact(ncplane* n){
+  compactfb* cfb = n->compact;
+  const size_t cells = (size_t)n->leny * n->lenx;
+  nccell* fb = ncpile_fb_alloc(ncplane_pile(n), cells);
+  if(fb == NULL){
+    return -1;
+  }
+  logwarn("converting compact %ux%u plane to full cells", n->leny, n->lenx);
+  for(unsigned y = 0 ; y < n->leny ; ++y){
+    nccell* dst = fb + (size_t)y * n->lenx;
+    if((int)y == cfb->hoty){
+      memcpy(dst, cfb->hotrow, sizeof(*dst) * n->lenx);
+    }else{
+      compact_expand(cfb, cfb->cells + (size_t)y * n->lenx, dst, n->lenx);
+    }
+  }
+  if(ncplane_pile(n)){
+    notcurses* nc = ncplane_notcurses(n);
+    pthread_mutex_lock(&nc->stats.lock);
+      nc->stats.s.fbbytes += cells * (sizeof(nccell) - sizeof(nccompact));
+    pthread_mutex_unlock(&nc->stats.lock);
+  }
+  compact_destroy(cfb);
+  n->compact = NULL;
+  n->fb = fb;
+  return 0;
+}
+
+// write the hot row back, if it's been modified. if we run out of pairs,
+// collect unused ones and try again, and failing that, decompact.
+static int
+compact_writeback(ncplane* n){
+  compactfb* cfb = n->compact;
+  if(cfb->hoty < 0 || !cfb->hotdirty){
+    return 0;
+  }
+  nccompact* row = cfb->cells + (size_t)cfb->hoty * n->lenx;
+  if(compact_compress(cfb, cfb->hotrow, row, n->lenx) == 0){
+    cfb->hotdirty = false;
+    return 0;
+  }
+  if(compact_collect(n) == 0){
+    if(compact_compress(cfb, cfb->hotrow, row, n->lenx) == 0){
+      cfb->hotdirty = false;
+      return 0;
+    }
+  }
+  if(ncplane_decompact(n)){
+    logerror("couldn't write back row %d of compact plane", cfb->hoty);
+    cfb->hotdirty = false;
+    return -1;
+  }
+  return 0;
+}
+
+nccell* compactfb_cell(ncplane* n, int vrow, unsigned x, bool write){
+  compact_writeback(n);
+  if(n->compact == NULL){ // we were decompacted
+    return &n->fb[fbcellidx(vrow, n->lenx, x)];
+  }
+  compactfb* cfb = n->compact;
+  compact_expand(cfb, cfb->cells + (size_t)vrow * n->lenx, cfb->hotrow, n->lenx);
+  cfb->hoty = vrow;
+  cfb->hotdirty = write;
+  return cfb->hotrow + x;
+}
+
+int ncplane_compact_init(ncplane* n){
+  compactfb* cfb = malloc(sizeof(*cfb));
+  if(cfb == NULL){
+    return -1;
+  }
+  cfb->cells = calloc((size_t)n->leny * n->lenx, sizeof(*cfb->cells));
+  cfb->hotrow = malloc(sizeof(*cfb->hotrow) * n->lenx);
+  if(cfb->cells == NULL || cfb->hotrow == NULL || pairs_init(cfb)){
+    free(cfb->cells);
+    free(cfb->hotrow);
+    free(cfb);
+    return -1;
+  }
+  cfb->hoty = -1;
+  cfb->hotdirty = false;
+  n->compact = cfb;
+  return 0;
+}
+
+void ncplane_compact_free(ncplane* n){
+  compact_destroy(n->compact);
+  n->compact = NULL;
+}
+
+void ncplane_compact_flush(ncplane* n){
+  if(n->compact){
+    compact_writeback(n);
+    if(n->compact){
+      n->compact->hoty = -1;
+    }
+  }
+}
+
+// release any EGCpool storage held by a compact cell
+static inline void
+compact_release(ncplane* n, const nccompact* cc){
+  nccell c = {
+    .gcluster = cc->gcluster,
+  };
+  nccell_release(n, &c);
+}
+
+void ncplane_compact_clear_row(ncplane* n, int vrow){
+  compactfb* cfb = n->compact;
+  nccompact* row = cfb->cells + (size_t)vrow * n->lenx;
+  if(vrow == cfb->hoty){ // the hot row is authoritative
+    for(unsigned x = 0 ; x < n->lenx ; ++x){
+      nccell_release(n, &cfb->hotrow[x]);
+    }
+    cfb->hoty = -1;
+    cfb->hotdirty = false;
+  }else{
+    for(unsigned x = 0 ; x < n->lenx ; ++x){
+      compact_release(n, &row[x]);
+    }
+  }
+  memset(row, 0, sizeof(*row) * n->lenx);
+}
+
+// the caller is responsible for the EGCpool
+void ncplane_compact_erase(ncplane* n){
+  compactfb* cfb = n->compact;
+  memset(cfb->cells, 0, sizeof(*cfb->cells) * n->leny * n->lenx);
+  cfb->hoty = -1;
+  cfb->hotdirty = false;
+  // every pair is now unused
+  cfb->paircount = 1;
+  memset(cfb->pairhash, 0, sizeof(*cfb->pairhash) * cfb->hashcap);
+}
+
+// the compact analogue of the framebuffer manipulation in
+// ncplane_resize_internal(). the new cells are laid out in logical order.
+// the hot row must have been flushed.
+int ncplane_compact_resize(ncplane* n, int keepy, int keepx,
+                           unsigned keepleny, unsigned keeplenx,
+                           int yoff, int xoff, unsigned ylen, unsigned xlen){
+  compactfb* cfb = n->compact;
+  nccompact* cells = calloc((size_t)ylen * xlen, sizeof(*cells));
+  if(cells == NULL){
+    return -1;
+  }
+  if(xlen != n->lenx){
+    nccell* hotrow = realloc(cfb->hotrow, sizeof(*hotrow) * xlen);
+    if(hotrow == NULL){
+      free(cells);
+      return -1;
+    }
+    cfb->hotrow = hotrow;
+  }
+  if(keepleny == 0 || keeplenx == 0){
+    egcpool_dump(&n->pool);
+  }else{
+    // release everything we're not keeping
+    for(unsigned y = 0 ; y < n->leny ; ++y){
+      const nccompact* row = cfb->cells + (size_t)logical_to_virtual(n, y) * n->lenx;
+      const bool keptrow = (int)y >= keepy && y < keepy + keepleny;
+      for(unsigned x = 0 ; x < n->lenx ; ++x){
+        if(!keptrow || (int)x < keepx || x >= keepx + keeplenx){
+          compact_release(n, &row[x]);
+        }
+      }
+    }
+    const unsigned targx = xoff < 0 ? -xoff : 0;
+    for(unsigned itery = 0 ; itery < ylen ; ++itery){
+      const int sourcey = itery + keepy + yoff;
+      if(sourcey < keepy || sourcey >= keepy + (int)keepleny){
+        continue;
+      }
+      unsigned copylen = keeplenx;
+      if(targx + copylen > xlen){
+        copylen = xlen - targx;
+      }
+      memcpy(cells + (size_t)itery * xlen + targx,
+             cfb->cells + (size_t)logical_to_virtual(n, sourcey) * n->lenx + keepx,
+             sizeof(*cells) * copylen);
+    }
+  }
+  free(cfb->cells);
+  cfb->cells = cells;
+  n->logrow = 0;
+  return 0;
+}
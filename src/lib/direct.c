@@ -513,6 +513,23 @@ ncdirect_set_fg_default_f(ncdirect* nc, fbuf* f){
   return 0;
 }
 
+// write the EGC for |c|, borrowed from the plane's egcpool. empty cells take
+// the base cell's glyph, falling back to a space.
+static inline int
+ncdirect_dump_egc(const ncplane* np, const nccell* c, fbuf* f){
+  const char* egc = nccell_extended_gcluster(np, c);
+  if(*egc == '\0'){
+    egc = nccell_extended_gcluster(np, &np->basecell);
+    if(*egc == '\0'){
+      egc = " ";
+    }
+  }
+  return fbuf_puts(f, egc);
+}
+
+// walk the framebuffer in place, writing each row in a single pass. color
+// changes are only considered where a cell's channels differ from those of
+// its predecessor, so runs of identical cells are emitted as bare glyphs.
 static int
 ncdirect_dump_cellplane(ncdirect* n, const ncplane* np, fbuf* f, int xoff){
   unsigned dimy, dimx;
@@ -524,30 +541,32 @@ ncdirect_dump_cellplane(ncdirect* n, const ncplane* np, fbuf* f, int xoff){
   const uint32_t fgrgb = ncchannels_fg_rgb(n->channels);
   const uint32_t bgrgb = ncchannels_bg_rgb(n->channels);
   for(unsigned y = 0 ; y < dimy ; ++y){
+    const nccell* row = &np->fb[nfbcellidx(np, y, 0)];
+    // prime the run with channels which can't match any cell's
+    uint64_t lastchannels = ~0ull;
     for(unsigned x = 0 ; x < dimx ; ++x){
-      uint16_t stylemask;
-      uint64_t channels;
-      char* egc = ncplane_at_yx(np, y, x, &stylemask, &channels);
-      if(egc == NULL){
-        return -1;
+      const nccell* c = &row[x];
+      // the left half was written along with its full glyph
+      if(nccell_wide_right_p(c)){
+        continue;
       }
-      if(ncchannels_fg_alpha(channels) == NCALPHA_TRANSPARENT){
-        ncdirect_set_fg_default_f(n, f);
-      }else{
-        ncdirect_set_fg_rgb_f(n, ncchannels_fg_rgb(channels), f);
-      }
-      if(ncchannels_bg_alpha(channels) == NCALPHA_TRANSPARENT){
-        ncdirect_set_bg_default_f(n, f);
-      }else{
-        ncdirect_set_bg_rgb_f(n, ncchannels_bg_rgb(channels), f);
+      const uint64_t channels = c->channels;
+      if(channels != lastchannels){
+        if(ncchannels_fg_alpha(channels) == NCALPHA_TRANSPARENT){
+          ncdirect_set_fg_default_f(n, f);
+        }else{
+          ncdirect_set_fg_rgb_f(n, ncchannels_fg_rgb(channels), f);
+        }
+        if(ncchannels_bg_alpha(channels) == NCALPHA_TRANSPARENT){
+          ncdirect_set_bg_default_f(n, f);
+        }else{
+          ncdirect_set_bg_rgb_f(n, ncchannels_bg_rgb(channels), f);
+        }
+        lastchannels = channels;
       }
-//fprintf(stderr, "%03d/%03d [%s] (%03dx%03d)\n", y, x, egc, dimy, dimx);
-      size_t egclen = strlen(egc);
-      if(fbuf_putn(f, egclen == 0 ? " " : egc, egclen == 0 ? 1 : egclen) < 0){
-        free(egc);
+      if(ncdirect_dump_egc(np, c, f) < 0){
         return -1;
       }
-      free(egc);
     }
     // yes, we want to reset colors and emit an explicit new line following
     // each line of output; this is necessary if our output is lifted out and
@@ -586,17 +605,16 @@ ncdirect_dump_plane(ncdirect* n, const ncplane* np, int xoff){
       return -1;
     }
   }
-  fbuf f;
-  if(fbuf_init(&f)){
-    return -1;
-  }
+  fbuf* f = &n->obuf;
   if(np->sprite){
     unsigned y;
-    if(ncdirect_dump_sprixel(n, np, xoff, &y, &f)){
-      fbuf_free(&f);
+    if(ncdirect_dump_sprixel(n, np, xoff, &y, f)){
+      fbuf_reset(f);
       return -1;
     }
-    if(fbuf_finalize(&f, n->ttyfp)){
+    // pixel_draw_late() might write directly to the terminal, so this must
+    // go out now, even if we're otherwise buffering.
+    if(fbuf_flush(f, n->ttyfp)){
       return -1;
     }
     if(n->tcache.pixel_draw_late){
@@ -613,11 +631,11 @@ ncdirect_dump_plane(ncdirect* n, const ncplane* np, int xoff){
       return -1;
     }
   }else{
-    if(ncdirect_dump_cellplane(n, np, &f, xoff)){
-      fbuf_free(&f);
+    if(ncdirect_dump_cellplane(n, np, f, xoff)){
+      fbuf_reset(f);
       return -1;
     }
-    if(fbuf_finalize(&f, n->ttyfp)){
+    if(ncdirect_commit_obuf(n, true)){
       return -1;
     }
   }
@@ -778,7 +796,8 @@ int ncdirect_render_image(ncdirect* n, const char* file, ncalign_e align,
   return ncdirect_raster_frame(n, faken, align);
 }
 
-int ncdirect_set_fg_palindex(ncdirect* nc, int pidx){
+static int
+ncdirect_set_fg_palindex_f(ncdirect* nc, int pidx, fbuf* f){
   const char* setaf = get_escape(&nc->tcache, ESCAPE_SETAF);
   if(!setaf){
     return -1;
@@ -786,10 +805,19 @@ int ncdirect_set_fg_palindex(ncdirect* nc, int pidx){
   if(ncchannels_set_fg_palindex(&nc->channels, pidx) < 0){
     return -1;
   }
-  return term_emit(tiparm(setaf, pidx), nc->ttyfp, false);
+  return fbuf_emit(f, tiparm(setaf, pidx));
 }
 
-int ncdirect_set_bg_palindex(ncdirect* nc, int pidx){
+int ncdirect_set_fg_palindex(ncdirect* nc, int pidx){
+  if(ncdirect_set_fg_palindex_f(nc, pidx, &nc->obuf)){
+    fbuf_reset(&nc->obuf);
+    return -1;
+  }
+  return ncdirect_commit_obuf(nc, false);
+}
+
+static int
+ncdirect_set_bg_palindex_f(ncdirect* nc, int pidx, fbuf* f){
   const char* setab = get_escape(&nc->tcache, ESCAPE_SETAB);
   if(!setab){
     return -1;
@@ -797,7 +825,15 @@ int ncdirect_set_bg_palindex(ncdirect* nc, int pidx){
   if(ncchannels_set_bg_palindex(&nc->channels, pidx) < 0){
     return -1;
   }
-  return term_emit(tiparm(setab, pidx), nc->ttyfp, false);
+  return fbuf_emit(f, tiparm(setab, pidx));
+}
+
+int ncdirect_set_bg_palindex(ncdirect* nc, int pidx){
+  if(ncdirect_set_bg_palindex_f(nc, pidx, &nc->obuf)){
+    fbuf_reset(&nc->obuf);
+    return -1;
+  }
+  return ncdirect_commit_obuf(nc, false);
 }
 
 int ncdirect_vprintf_aligned(ncdirect* n, int y, ncalign_e align, const char* fmt, va_list ap){
@@ -869,7 +905,7 @@ ncdirect* ncdirect_core_init(const char* termtype, FILE* outfp, uint64_t flags){
   if(outfp == NULL){
     outfp = stdout;
   }
-  if(flags > (NCDIRECT_OPTION_DRAIN_INPUT << 1)){ // allow them through with warning
+  if(flags > (NCDIRECT_OPTION_BUFFERED_OUTPUT << 1)){ // allow them through with warning
     logwarn("Passed unsupported flags 0x%016" PRIx64 "\n", flags);
   }
   if(termtype){
@@ -913,12 +949,15 @@ ncdirect* ncdirect_core_init(const char* termtype, FILE* outfp, uint64_t flags){
     loglevel = NCLOGLEVEL_SILENT;
   }
   set_loglevel_from_env(&loglevel);
+  if(fbuf_init_small(&ret->obuf)){
+    goto err;
+  }
   int cursor_y = -1;
   int cursor_x = -1;
   if(interrogate_terminfo(&ret->tcache, ret->ttyfp, utf8, 1,
                           flags & NCDIRECT_OPTION_INHIBIT_CBREAK,
                           0, &cursor_y, &cursor_x, &ret->stats, 0, 0, 0, 0,
-                          flags & NCDIRECT_OPTION_DRAIN_INPUT)){
+                          flags & NCDIRECT_OPTION_DRAIN_INPUT, 0)){
     goto err;
   }
   if(cursor_y >= 0){
@@ -944,6 +983,7 @@ err:
     (void)tcsetattr(ret->tcache.ttyfd, TCSANOW, ret->tcache.tpreserved);
   }
   drop_signals(ret);
+  fbuf_free(&ret->obuf);
   pthread_mutex_destroy(&ret->stats.lock);
   free(ret);
   return NULL;
@@ -953,6 +993,7 @@ int ncdirect_stop(ncdirect* nc){
   int ret = 0;
   if(nc){
     ret |= ncdirect_stop_minimal(nc);
+    fbuf_free(&nc->obuf);
     free_terminfo_cache(&nc->tcache);
     if(nc->tcache.ttyfd >= 0){
       ret |= close(nc->tcache.ttyfd);
@@ -1133,22 +1174,22 @@ ncdirect_style_emit(ncdirect* n, unsigned stylebits, fbuf* f){
       if(!ncdirect_fg_palindex_p(n)){
         uint32_t fg = ncchannels_fg_rgb(n->channels);
         ncchannels_set_fg_default(&n->channels);
-        r |= ncdirect_set_fg_rgb(n, fg);
+        r |= ncdirect_set_fg_rgb_f(n, fg, f);
       }else{ // palette-indexed
         uint32_t fg = ncchannels_fg_palindex(n->channels);
         ncchannels_set_fg_default(&n->channels);
-        r |= ncdirect_set_fg_palindex(n, fg);
+        r |= ncdirect_set_fg_palindex_f(n, fg, f);
       }
     }
     if(!ncdirect_bg_default_p(n)){
       if(!ncdirect_bg_palindex_p(n)){
         uint32_t bg = ncchannels_bg_rgb(n->channels);
         ncchannels_set_bg_default(&n->channels);
-        r |= ncdirect_set_bg_rgb(n, bg);
+        r |= ncdirect_set_bg_rgb_f(n, bg, f);
       }else{ // palette-indexed
         uint32_t bg = ncchannels_bg_palindex(n->channels);
         ncchannels_set_bg_default(&n->channels);
-        r |= ncdirect_set_bg_palindex(n, bg);
+        r |= ncdirect_set_bg_palindex_f(n, bg, f);
       }
     }
   }
@@ -1160,18 +1201,11 @@ int ncdirect_on_styles(ncdirect* n, unsigned stylebits){
     return -1;
   }
   uint32_t stylemask = n->stylemask | stylebits;
-  fbuf f = {0};
-  if(fbuf_init_small(&f)){
+  if(ncdirect_style_emit(n, stylemask, &n->obuf)){
+    fbuf_reset(&n->obuf);
     return -1;
   }
-  if(ncdirect_style_emit(n, stylemask, &f)){
-    fbuf_free(&f);
-    return -1;
-  }
-  if(fbuf_finalize(&f, n->ttyfp)){
-    return -1;
-  }
-  return 0;
+  return ncdirect_commit_obuf(n, true);
 }
 
 uint16_t ncdirect_styles(const ncdirect* n){
@@ -1181,18 +1215,11 @@ uint16_t ncdirect_styles(const ncdirect* n){
 // turn off any specified stylebits
 int ncdirect_off_styles(ncdirect* n, unsigned stylebits){
   uint32_t stylemask = n->stylemask & ~stylebits;
-  fbuf f = {0};
-  if(fbuf_init_small(&f)){
+  if(ncdirect_style_emit(n, stylemask, &n->obuf)){
+    fbuf_reset(&n->obuf);
     return -1;
   }
-  if(ncdirect_style_emit(n, stylemask, &f)){
-    fbuf_free(&f);
-    return -1;
-  }
-  if(fbuf_finalize(&f, n->ttyfp)){
-    return -1;
-  }
-  return 0;
+  return ncdirect_commit_obuf(n, true);
 }
 
 // set the current stylebits to exactly those provided
@@ -1201,18 +1228,11 @@ int ncdirect_set_styles(ncdirect* n, unsigned stylebits){
     return -1;
   }
   uint32_t stylemask = stylebits;
-  fbuf f = {0};
-  if(fbuf_init_small(&f)){
+  if(ncdirect_style_emit(n, stylemask, &n->obuf)){
+    fbuf_reset(&n->obuf);
     return -1;
   }
-  if(ncdirect_style_emit(n, stylemask, &f)){
-    fbuf_free(&f);
-    return -1;
-  }
-  if(fbuf_finalize(&f, n->ttyfp)){
-    return -1;
-  }
-  return 0;
+  return ncdirect_commit_obuf(n, true);
 }
 
 unsigned ncdirect_palette_size(const ncdirect* nc){
@@ -1564,14 +1584,12 @@ int ncdirect_stream(ncdirect* n, const char* filename, ncstreamcb streamer,
     }
     if(lastid > -1){
       if(n->tcache.pixel_remove){
-        fbuf f = {0};
-        fbuf_init_small(&f);
-        if(n->tcache.pixel_remove(lastid, &f)){
-          fbuf_free(&f);
+        if(n->tcache.pixel_remove(lastid, &n->obuf)){
+          fbuf_reset(&n->obuf);
           ncvisual_destroy(ncv);
           return -1;
         }
-        if(fbuf_finalize(&f, n->ttyfp) < 0){
+        if(ncdirect_commit_obuf(n, true) < 0){
           ncvisual_destroy(ncv);
           return -1;
         }
@@ -35,7 +35,7 @@ alloc_ncplane_palette(ncplane* n, ncfadectx* pp, const struct timespec* ts){
   unsigned y;
   for(y = 0 ; y < pp->rows ; ++y){
     for(unsigned x = 0 ; x < pp->cols ; ++x){
-      channels = n->fb[nfbcellidx(n, y, x)].channels;
+      channels = ncplane_cell_peek_yx(n, y, x)->channels;
       pp->channels[y * pp->cols + x] = channels;
       ncchannels_fg_rgb8(channels, &r, &g, &b);
       if(r > pp->maxr){
@@ -119,7 +119,7 @@ int ncplane_fadein_iteration(ncplane* n, ncfadectx* nctx, int iter,
       ncchannels_fg_rgb8(nctx->channels[nctx->cols * y + x], &r, &g, &b);
       unsigned br, bg, bb;
       ncchannels_bg_rgb8(nctx->channels[nctx->cols * y + x], &br, &bg, &bb);
-      nccell* c = &n->fb[dimx * y + x];
+      nccell* c = ncplane_cell_ref_yx(n, y, x);
       if(!nccell_fg_default_p(c)){
         r = r * iter / nctx->maxsteps;
         g = g * iter / nctx->maxsteps;
@@ -182,7 +182,7 @@ int ncplane_fadeout_iteration(ncplane* n, ncfadectx* nctx, int iter,
   unsigned y;
   for(y = 0 ; y < nctx->rows && y < dimy ; ++y){
     for(unsigned x = 0 ; x < nctx->cols && x < dimx; ++x){
-      nccell* c = &n->fb[dimx * y + x];
+      nccell* c = ncplane_cell_ref_yx(n, y, x);
       if(!nccell_fg_default_p(c)){
         ncchannels_fg_rgb8(nctx->channels[nctx->cols * y + x], &r, &g, &b);
         r = r * (nctx->maxsteps - iter) / nctx->maxsteps;
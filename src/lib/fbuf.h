@@ -296,6 +296,107 @@ blocking_write(int fd, const char* buf, size_t buflen){
   return 0;
 }
 
+// writev(2) until we've written all |iovcnt| elements of |iov|, which is
+// modified (partial writes advance it). uses poll(2) like blocking_write().
+static inline int
+blocking_writev(int fd, struct iovec* iov, int iovcnt){
+#ifdef __MINGW32__
+  for(int i = 0 ; i < iovcnt ; ++i){
+    if(blocking_write(fd, (const char*)iov[i].iov_base, iov[i].iov_len)){
+      return -1;
+    }
+  }
+#else
+  while(iovcnt){
+    if(iov->iov_len == 0){
+      ++iov;
+      --iovcnt;
+      continue;
+    }
+    ssize_t w = writev(fd, iov, iovcnt);
+    if(w < 0){
+      if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != EBUSY){
+        logerror("Error writing out data on %d (%s)", fd, strerror(errno));
+        return -1;
+      }
+      w = 0;
+    }
+    while(iovcnt && (size_t)w >= iov->iov_len){
+      w -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if(iovcnt){
+      iov->iov_base = (char*)iov->iov_base + w;
+      iov->iov_len -= w;
+      struct pollfd pfd = {
+        .fd = fd,
+        .events = POLLOUT,
+        .revents = 0,
+      };
+      poll(&pfd, 1, -1);
+    }
+  }
+#endif
+  return 0;
+}
+
+// a payload which belongs immediately after the first |off| bytes of some
+// fbuf, but which is referenced rather than copied into it (large bitmap
+// payloads, for instance). an fbuf and an ordered list of its splices are
+// written together with fbuf_writev(). if |owned| has a buffer, the splice
+// has taken ownership of the payload's storage, to be freed once written.
+typedef struct fbufsplice {
+  uint64_t off;    // offset into the fbuf at which buf is written
+  const char* buf;
+  size_t len;
+  fbuf owned;
+} fbufsplice;
+
+// write the contents of |f| following its first |moffset| bytes, with the
+// |count| splices of |s| (sorted by offset, none less than |moffset|)
+// gathered in, to |fd|. neither |f| nor the splices are modified.
+static inline int
+fbuf_writev(int fd, const fbuf* f, size_t moffset, const fbufsplice* s,
+            unsigned count){
+  // each splice contributes at most two elements: the text preceding it,
+  // and itself. the final element is whatever text follows the last splice.
+  struct iovec iov[64];
+  int iovcnt = 0;
+  size_t pos = moffset;
+  for(unsigned i = 0 ; i < count ; ++i){
+    assert(s[i].off >= pos);
+    assert(s[i].off <= f->used);
+    if(iovcnt + 2 > (int)(sizeof(iov) / sizeof(*iov))){
+      if(blocking_writev(fd, iov, iovcnt)){
+        return -1;
+      }
+      iovcnt = 0;
+    }
+    if(s[i].off > pos){
+      iov[iovcnt].iov_base = f->buf + pos;
+      iov[iovcnt].iov_len = s[i].off - pos;
+      ++iovcnt;
+      pos = s[i].off;
+    }
+    iov[iovcnt].iov_base = (void*)s[i].buf;
+    iov[iovcnt].iov_len = s[i].len;
+    ++iovcnt;
+  }
+  if(f->used > pos){
+    if(iovcnt == (int)(sizeof(iov) / sizeof(*iov))){
+      if(blocking_writev(fd, iov, iovcnt)){
+        return -1;
+      }
+      iovcnt = 0;
+    }
+    iov[iovcnt].iov_base = f->buf + pos;
+    iov[iovcnt].iov_len = f->used - pos;
+    ++iovcnt;
+  }
+  return blocking_writev(fd, iov, iovcnt);
+}
+
 // attempt to write the contents of |f| to the FILE |fp|, if there are any
 // contents. reset the fbuf either way.
 static inline int
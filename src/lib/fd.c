@@ -32,12 +32,67 @@ ncfdplane_destroy_inner(ncfdplane* n){
   return ret;
 }
 
-// if pidfd is < 0, it won't be used in the poll()
+// is more data available on |fd| right now? used to avoid blocking in
+// read(2) on descriptors lacking O_NONBLOCK.
+static bool
+fd_readable(int fd){
+  struct pollfd pfd = {
+    .fd = fd,
+    .events = POLLIN,
+  };
+#ifndef __MINGW32__
+  return poll(&pfd, 1, 0) > 0;
+#else
+  return WSAPoll(&pfd, 1, 0) > 0;
+#endif
+}
+
+// read into |buf| until the fd would block, or we've accumulated bufsize
+// bytes. returns 0 on EOF, -1 on error, and 1 otherwise.
+static int
+fdplane_fill(ncfdplane* ncfp, char* buf, size_t* used){
+  while(*used < ncfp->bufsize){
+    size_t want = ncfp->bufsize - *used;
+    ssize_t r = read(ncfp->fd, buf + *used, want);
+    if(r == 0){
+      return 0;
+    }else if(r < 0){
+      if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR){
+        return 1;
+      }
+      return -1;
+    }
+    *used += r;
+    // a short read probably means we've drained the fd, but check before
+    // going back to read(2), lest we block
+    if((size_t)r < want && !fd_readable(ncfp->fd)){
+      return 1;
+    }
+  }
+  return 1;
+}
+
+// hand everything we've accumulated to the callback
+static int
+fdplane_deliver(ncfdplane* ncfp, char* buf, size_t* used){
+  int r = 0;
+  if(*used){
+    buf[*used] = '\0';
+    r = ncfp->cb(ncfp, buf, *used, ncfp->curry);
+    *used = 0;
+  }
+  return r;
+}
+
+// if pidfd is < 0, it won't be used in the poll(). the fd is drained on each
+// wakeup, and the data delivered in as few callbacks as possible. if we're
+// coalescing, data is held until coalesce_ns have passed since the previous
+// callback, and we poll() only for the remainder of that interval.
 static void
 fdthread(ncfdplane* ncfp, int pidfd){
   struct pollfd pfds[2];
   memset(pfds, 0, sizeof(pfds));
-  char* buf = malloc(BUFSIZ + 1);
+  char* buf = malloc(ncfp->bufsize + 1);
   pfds[0].fd = ncfp->fd;
   pfds[0].events = NCPOLLEVENTS;
   const int fdcount = pidfd < 0 ? 1 : 2;
@@ -45,37 +100,64 @@ fdthread(ncfdplane* ncfp, int pidfd){
     pfds[1].fd = pidfd;
     pfds[1].events = NCPOLLEVENTS;
   }
-  ssize_t r = 0;
+  size_t used = 0;     // bytes read, but not yet delivered
+  uint64_t lastcb = 0; // time of the most recent callback
+  int timeout = -1;
+  int err = ENOMEM;    // errno for the completion callback
+  int r = buf ? 0 : -1;
+  while(buf){
 #ifndef __MINGW32__
-  while(poll(pfds, fdcount, -1) >= 0 || errno == EINTR){
+    if(poll(pfds, fdcount, timeout) < 0){
 #else
-  while(WSAPoll(pfds, fdcount, -1) >= 0){
+    if(WSAPoll(pfds, fdcount, timeout) < 0){
 #endif
-    if(pfds[0].revents){
-      while((r = read(ncfp->fd, buf, BUFSIZ)) >= 0){
-        if(r == 0){
-          break;
-        }
-        buf[r] = '\0';
-        if( (r = ncfp->cb(ncfp, buf, r, ncfp->curry)) ){
-          break;
-        }
-        if(ncfp->destroyed){
+      if(errno == EINTR){
+        continue;
+      }
+      err = errno;
+      r = -1;
+      break;
+    }
+    const bool exited = fdcount > 1 && pfds[1].revents;
+    int f = 1;
+    if(pfds[0].revents || exited){
+      // a full buffer is always delivered immediately
+      while((f = fdplane_fill(ncfp, buf, &used)) > 0 && used == ncfp->bufsize){
+        if((r = fdplane_deliver(ncfp, buf, &used)) || ncfp->destroyed){
           break;
         }
+        lastcb = clock_getns(CLOCK_MONOTONIC);
       }
-      // if we're not doing follow, break out on a zero-byte read
-      if(r == 0 && !ncfp->follow){
+      if(r || ncfp->destroyed){
+        err = errno;
         break;
       }
+      err = errno;
     }
-    if(fdcount > 1 && pfds[1].revents){
-      r = 0;
+    uint64_t now = clock_getns(CLOCK_MONOTONIC);
+    if(used && (f <= 0 || exited || now - lastcb >= ncfp->coalesce_ns)){
+      if((r = fdplane_deliver(ncfp, buf, &used)) || ncfp->destroyed){
+        err = errno;
+        break;
+      }
+      lastcb = now;
+    }
+    if(f < 0){
+      r = -1;
       break;
     }
+    // if we're not doing follow, break out on a zero-byte read
+    if(exited || (f == 0 && !ncfp->follow)){
+      break;
+    }
+    timeout = -1;
+    if(used){
+      uint64_t remaining = ncfp->coalesce_ns - (now - lastcb);
+      timeout = (remaining + 999999) / 1000000;
+    }
   }
-  if(r <= 0 && !ncfp->destroyed){
-    ncfp->donecb(ncfp, r == 0 ? 0 : errno, ncfp->curry);
+  if(r <= 0 && !ncfp->destroyed && ncfp->donecb){
+    ncfp->donecb(ncfp, r == 0 ? 0 : err, ncfp->curry);
   }
   if(ncfp->destroyed){
     ncfdplane_destroy_inner(ncfp);
@@ -83,6 +165,78 @@ fdthread(ncfdplane* ncfp, int pidfd){
   free(buf);
 }
 
+// the built-in callback, used when none is provided. runs of printable ASCII
+// are written without UTF-8 decoding; anything else goes through
+// ncplane_putnstr(). control characters other than newline and tab are
+// dropped. a UTF-8 sequence split across reads is carried to the next call.
+// |vbuf| is always fdthread()'s own buffer, so we can terminate it in place.
+static int
+fdplane_sink(ncfdplane* ncfp, const void* vbuf, size_t len, void* curry){
+  unsigned char* buf = (unsigned char*)vbuf;
+  ncplane* n = ncfp->ncp;
+  size_t off = 0;
+  if(ncfp->carried){
+    unsigned need = utf8_codepoint_length(ncfp->carry[0]);
+    while(ncfp->carried < need && off < len){
+      ncfp->carry[ncfp->carried++] = buf[off++];
+    }
+    if(ncfp->carried < need){
+      return 0;
+    }
+    ncfp->carry[ncfp->carried] = '\0';
+    ncplane_putnstr(n, ncfp->carried, (const char*)ncfp->carry);
+    ncfp->carried = 0;
+  }
+  // hold back an incomplete sequence at the end of the buffer
+  size_t end = len;
+  for(size_t back = 1 ; back <= 3 && back <= len - off ; ++back){
+    const unsigned char c = buf[len - back];
+    if(c >= 0xc0){
+      if(utf8_codepoint_length(c) > back){
+        end = len - back;
+      }
+      break;
+    }else if(c < 0x80){
+      break;
+    }
+  }
+  // stash the partial sequence, and keep cluster detection from reading it
+  while(end + ncfp->carried < len){
+    ncfp->carry[ncfp->carried] = buf[end + ncfp->carried];
+    ++ncfp->carried;
+  }
+  buf[end] = '\0';
+  while(off < end){
+    size_t run = off;
+    while(run < end && buf[run] >= 0x20 && buf[run] < 0x7f){
+      ++run;
+    }
+    // a non-ASCII byte might begin a combining character, so the final ASCII
+    // character is written along with it, as part of the same cluster
+    if(run < end && buf[run] >= 0x80 && run > off){
+      --run;
+    }
+    if(run > off){
+      ncplane_putascii(n, (const char*)buf + off, run - off);
+      off = run;
+    }else if(buf[off] < 0x80 && (buf[off] < 0x20 || buf[off] == 0x7f)){
+      if(buf[off] == '\n' || buf[off] == '\t'){
+        ncplane_putnstr(n, 1, (const char*)buf + off);
+      }
+      ++off;
+    }else{
+      size_t seg = off + 1;
+      while(seg < end && buf[seg] >= 0x80){
+        ++seg;
+      }
+      ncplane_putnstr(n, seg - off, (const char*)buf + off);
+      off = seg;
+    }
+  }
+  (void)curry;
+  return 0;
+}
+
 static void *
 ncfdplane_thread(void* vncfp){
   fdthread(vncfp, -1);
@@ -93,15 +247,26 @@ static ncfdplane*
 ncfdplane_create_internal(ncplane* n, const ncfdplane_options* opts, int fd,
                           ncfdplane_callback cbfxn, ncfdplane_done_cb donecbfxn,
                           bool thread){
-  if(opts->flags > 0){
+  if(opts->flags > NCOPTION_FDPLANE_BATCH){
     logwarn("provided unsupported flags %016" PRIx64, opts->flags);
   }
   ncfdplane* ret = malloc(sizeof(*ret));
   if(ret == NULL){
     return ret;
   }
-  ret->cb = cbfxn;
+  ret->cb = cbfxn ? cbfxn : fdplane_sink;
   ret->donecb = donecbfxn;
+  // callers predating these fields don't set the flag, and their structures
+  // might not extend to them.
+  ret->bufsize = BUFSIZ;
+  ret->coalesce_ns = 0;
+  if(opts->flags & NCOPTION_FDPLANE_BATCH){
+    if(opts->bufsize){
+      ret->bufsize = opts->bufsize;
+    }
+    ret->coalesce_ns = opts->coalesce_ns;
+  }
+  ret->carried = 0;
   ret->follow = opts->follow;
   ret->ncp = n;
   ret->destroyed = false;
@@ -123,7 +288,7 @@ ncfdplane* ncfdplane_create(ncplane* n, const ncfdplane_options* opts, int fd,
   if(!opts){
     opts = &zeroed;
   }
-  if(fd < 0 || !cbfxn || !donecbfxn){
+  if(fd < 0){
     return NULL;
   }
   return ncfdplane_create_internal(n, opts, fd, cbfxn, donecbfxn, true);
@@ -300,7 +465,7 @@ ncsubproc_waiter(void* vncsp){
   pthread_mutex_lock(&ncsp->lock);
   ncsp->waited = true;
   pthread_mutex_unlock(&ncsp->lock);
-  if(!ncsp->nfp->destroyed){
+  if(!ncsp->nfp->destroyed && ncsp->nfp->donecb){
     ncsp->nfp->donecb(ncsp->nfp, *status, ncsp->nfp->curry);
   }
   return status;
@@ -313,6 +478,11 @@ ncsubproc_launch(ncplane* n, ncsubproc* ret, const ncsubproc_options* opts, int
     .curry = opts->curry,
     .follow = true,
   };
+  if(opts->flags & NCOPTION_SUBPROC_BATCH){
+    popts.flags = NCOPTION_FDPLANE_BATCH;
+    popts.bufsize = opts->bufsize;
+    popts.coalesce_ns = opts->coalesce_ns;
+  }
   ret->nfp = ncfdplane_create_internal(n, &popts, fd, cbfxn, donecbfxn, false);
   if(ret->nfp == NULL){
     return NULL;
@@ -343,10 +513,7 @@ ncexecvpe(ncplane* n, const ncsubproc_options* opts, unsigned usepath,
   if(!opts){
     opts = &zeroed;
   }
-  if(!cbfxn || !donecbfxn){
-    return NULL;
-  }
-  if(opts->flags > 0){
+  if(opts->flags > NCOPTION_SUBPROC_BATCH){
     logwarn("provided unsupported flags %016" PRIx64, opts->flags);
   }
 #ifndef __MINGW32__
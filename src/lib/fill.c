@@ -3,7 +3,7 @@
 void ncplane_greyscale(ncplane *n){
   for(unsigned y = 0 ; y < n->leny ; ++y){
     for(unsigned x = 0 ; x < n->lenx ; ++x){
-      nccell* c = &n->fb[nfbcellidx(n, y, x)];
+      nccell* c = ncplane_cell_ref_yx(n, y, x);
       unsigned r, g, b;
       nccell_fg_rgb8(c, &r, &g, &b);
       int gy = rgb_greyscale(r, g, b);
@@ -32,7 +32,7 @@ ncplane_polyfill_inner(ncplane* n, unsigned y, unsigned x, const nccell* c, cons
     stack = stack->next;
     y = s->y;
     x = s->x;
-    nccell* cur = &n->fb[nfbcellidx(n, y, x)];
+    nccell* cur = ncplane_cell_ref_yx(n, y, x);
     const char* glust = nccell_extended_gcluster(n, cur);
 //fprintf(stderr, "checking %d/%d (%s) for [%s]\n", y, x, glust, filltarg);
     if(strcmp(glust, filltarg) == 0){
@@ -98,7 +98,7 @@ int ncplane_polyfill_yx(ncplane* n, int ystart, int xstart, const nccell* c){
     logerror("invalid start: %u/%u (%u/%u)", y, x, n->leny, n->lenx);
     return -1;
   }
-  const nccell* cur = &n->fb[nfbcellidx(n, y, x)];
+  const nccell* cur = ncplane_cell_peek_yx(n, y, x);
   const char* targ = nccell_extended_gcluster(n, cur);
   const char* fillegc = nccell_extended_gcluster(n, c);
 //fprintf(stderr, "checking %d/%d (%s) for [%s]\n", y, x, targ, fillegc);
@@ -446,8 +446,8 @@ rotate_merge(ncplane* n, ncplane* newp){
   if(ret == 0){
     for(unsigned y = 0 ; y < dimy ; ++y){
       for(unsigned x = 0 ; x < dimx ; ++x){
-        const nccell* src = &newp->fb[fbcellidx(y, dimx, x)];
-        nccell* targ = &n->fb[fbcellidx(y, dimx, x)];
+        const nccell* src = ncplane_cell_peek_yx(newp, y, x);
+        nccell* targ = ncplane_cell_ref_yx(n, y, x);
         if(cell_duplicate_far(&n->pool, targ, newp, src) < 0){
           return -1;
         }
@@ -1,6 +1,9 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 #include "automaton.h"
 #include "internal.h"
 #include "unixsig.h"
@@ -48,6 +51,25 @@ typedef int ipipe;
 typedef HANDLE ipipe;
 #endif
 
+// events lexed during a single pass over our input buffers are staged here,
+// and published to the ringbuffer all at once (one lock acquisition, one
+// readiness signal, one broadcast). if we fill the stage mid-pass, we publish
+// early and keep going.
+#define STAGED_INPUTS 256
+
+// when NCOPTION_COALESCE_INPUT is in use, a SIGWINCH is held this long before
+// we synthesize NCKEY_RESIZE, and each further SIGWINCH restarts the wait.
+// dragging a window border thus yields a single resize, once it settles.
+#define RESIZE_DEBOUNCE_NS (50 * NANOSECS_IN_SEC / 1000)
+
+// kinds of events which can be merged into an immediately preceding event of
+// the same kind, when NCOPTION_COALESCE_INPUT is in use.
+typedef enum {
+  MERGE_NONE,
+  MERGE_MOTION,   // mouse motion report (with or without buttons held)
+  MERGE_RESIZE,   // NCKEY_RESIZE
+} mergekind_e;
+
 // local state for the input thread. don't put this large struct on the stack.
 typedef struct inputctx {
   // these two are not ringbuffers; we always move any leftover materia to the
@@ -77,6 +99,7 @@ typedef struct inputctx {
   // ringbuffers for processed, structured input
   cursorloc* csrs;    // cursor reports are dumped here
   ncinput* inputs;    // processed input is dumped here
+  unsigned* icoalesced; // events merged into each of inputs (parallel array)
   int coutstanding;   // outstanding cursor location requests
   int csize, isize;   // total number of slots in csrs/inputs
   int cvalid, ivalid; // population count of csrs/inputs
@@ -84,6 +107,13 @@ typedef struct inputctx {
                       //  we cannot write if valid == size
   int cread, iread;   // slot from which clients read the next csr/input;
                       //  they cannot read if valid == 0
+  ncinput staged[STAGED_INPUTS]; // lexed, but not yet published to inputs
+  unsigned scoalesced[STAGED_INPUTS]; // events merged into each of staged
+  int svalid;         // population count of staged
+  unsigned sevents;   // input events seen since our last publication
+  unsigned coalesce;  // merge runs of motion/resize events?
+  uint64_t resizedue; // when coalescing, the deadline for a held NCKEY_RESIZE
+  mergekind_e lastmerge; // kind of the most recently queued event
   pthread_mutex_t ilock; // lock for ncinput ringbuffer, also initial state
   pthread_cond_t icond;  // condvar for ncinput ringbuffer
   pthread_mutex_t clock; // lock for csrs ringbuffer
@@ -100,7 +130,10 @@ typedef struct inputctx {
   ncsharedstats *stats; // stats shared with notcurses context
 
   ipipe ipipes[2];
-  ipipe readypipes[2]; // pipes[0]: poll()able fd indicating the presence of user input
+  // readyfds[0]: poll()able fd indicating the presence of user input. on
+  // linux, this is an eventfd (and readyfds[0] == readyfds[1]); elsewhere, a
+  // pipe. it is readable iff the input ringbuffer is non-empty (or we're EOF).
+  ipipe readyfds[2];
   // initially, initdata is non-NULL and initdata_complete is NULL. once we
   // get DA1, initdata_complete is non-NULL (it is the same value as
   // initdata). once we complete reading the input payload that the DA1 arrived
@@ -112,13 +145,6 @@ typedef struct inputctx {
   bool failed;         // error initializing input automaton, abort
 } inputctx;
 
-static inline void
-inc_input_events(inputctx* ictx){
-  pthread_mutex_lock(&ictx->stats->lock);
-  ++ictx->stats->s.input_events;
-  pthread_mutex_unlock(&ictx->stats->lock);
-}
-
 static inline void
 inc_input_errors(inputctx* ictx){
   pthread_mutex_lock(&ictx->stats->lock);
@@ -476,15 +502,122 @@ mark_pipe_ready(ipipe pipes[static 2]){
   }
 }
 
-// shove the assembled input |tni| into the input queue (if there's room, and
-// we're not draining, and we haven't hit EOF). send any synthesized signal as
-// the last thing we do. if Ctrl or Shift are among the modifiers, we replace
-// any lowercase letter with its uppercase form, to maintain compatibility with
-// other input methods.
+// indicate readiness on the user-facing descriptor. call with ilock held.
+static void
+mark_ready(ipipe fds[static 2]){
+#ifdef __linux__
+  uint64_t one = 1;
+  if(write(fds[1], &one, sizeof(one)) != sizeof(one)){
+    logwarn("error writing to eventfd (%d) (%s)", fds[1], strerror(errno));
+  }else{
+    loginfo("wrote to readiness eventfd");
+  }
+#else
+  mark_pipe_ready(fds);
+#endif
+}
+
+// clear readiness on the user-facing descriptor. call with ilock held.
+static void
+drain_ready(ipipe fds[static 2]){
+#ifdef __linux__
+  uint64_t count;
+  // counter mode: a single read() consumes the entire count
+  if(read(fds[0], &count, sizeof(count)) < 0 && errno != EAGAIN){
+    logwarn("error reading eventfd (%d) (%s)", fds[0], strerror(errno));
+  }
+#elif !defined(__MINGW32__)
+  char c;
+  while(read(fds[0], &c, sizeof(c)) == 1){
+    // FIXME accelerate?
+  }
+#else
+  // we ought be draining this, but it breaks everything, as we can't easily
+  // do nonblocking input from a pipe in windows, augh...
+  // Ne pleure pas, Alfred! J'ai besoin de tout mon courage pour mourir a vingt ans!
+  /*while(ReadFile(ictx->readyfds[0], &c, sizeof(c), NULL, NULL)){
+    // FIXME accelerate?
+  }*/
+  (void)fds;
+#endif
+}
+
+// move everything staged into the input ringbuffer under a single acquisition
+// of ilock, and wake up any consumers. readiness is only signaled on the
+// empty->nonempty transition (consumers clear it when they empty the queue).
+// anything which doesn't fit is dropped. also folds the staged event count
+// into the shared stats.
+static void
+publish_staged_inputs(inputctx* ictx){
+  int count = 0;
+  int dropped = 0;
+  if(ictx->svalid){
+    pthread_mutex_lock(&ictx->ilock);
+    count = ictx->isize - ictx->ivalid;
+    if(count > ictx->svalid){
+      count = ictx->svalid;
+    }
+    // the ringbuffer might wrap, so we need at most two copies
+    int first = ictx->isize - ictx->iwrite;
+    if(first > count){
+      first = count;
+    }
+    memcpy(ictx->inputs + ictx->iwrite, ictx->staged, sizeof(*ictx->staged) * first);
+    memcpy(ictx->inputs, ictx->staged + first, sizeof(*ictx->staged) * (count - first));
+    memcpy(ictx->icoalesced + ictx->iwrite, ictx->scoalesced,
+           sizeof(*ictx->scoalesced) * first);
+    memcpy(ictx->icoalesced, ictx->scoalesced + first,
+           sizeof(*ictx->scoalesced) * (count - first));
+    if((ictx->iwrite += count) >= ictx->isize){
+      ictx->iwrite -= ictx->isize;
+    }
+    if(count && ictx->ivalid == 0){
+      mark_ready(ictx->readyfds);
+    }
+    ictx->ivalid += count;
+    pthread_mutex_unlock(&ictx->ilock);
+    if(count){
+      pthread_cond_broadcast(&ictx->icond);
+    }
+    for(dropped = 0 ; count + dropped < ictx->svalid ; ++dropped){
+      logwarn("dropping input 0x%08x", ictx->staged[count + dropped].id);
+    }
+    ictx->svalid = 0;
+    if(dropped){
+      ictx->lastmerge = MERGE_NONE;
+    }
+  }
+  if(ictx->sevents || dropped){
+    pthread_mutex_lock(&ictx->stats->lock);
+    ictx->stats->s.input_events += ictx->sevents;
+    ictx->stats->s.input_errors += dropped;
+    pthread_mutex_unlock(&ictx->stats->lock);
+    ictx->sevents = 0;
+  }
+}
+
+// how many more events can we lex before the ringbuffer is full?
+static int
+input_room(inputctx* ictx){
+  pthread_mutex_lock(&ictx->ilock);
+  int room = ictx->isize - ictx->ivalid;
+  pthread_mutex_unlock(&ictx->ilock);
+  return room - ictx->svalid;
+}
+
+// stage the assembled input |tni| for the input queue (if we're not draining,
+// and we haven't hit EOF). it will be published by publish_staged_inputs()
+// once we've finished this pass over our input. any synthesized signal
+// forces immediate publication, and is sent as the last thing we do. if Ctrl
+// or Shift are among the modifiers, we replace any lowercase letter with its
+// uppercase form, to maintain compatibility with other input methods.
 //
 // note that this w orks entirely off 'modifiers', not the obsolete
 // shift/alt/ctrl booleans, which it neither sets nor tests!
-static void
+//
+// returns true if the event was staged (i.e. we're neither draining nor at
+// EOF), in which case it is the most recently queued event.
+static bool
 load_ncinput(inputctx* ictx, ncinput *tni){
   int synth = 0;
   if(tni->modifiers & (NCKEY_MOD_CTRL | NCKEY_MOD_SHIFT | NCKEY_MOD_CAPSLOCK)){
@@ -514,20 +647,17 @@ load_ncinput(inputctx* ictx, ncinput *tni){
       }
     }
   }
-  inc_input_events(ictx);
+  ++ictx->sevents;
+  ictx->lastmerge = MERGE_NONE;
   if(ictx->drain || ictx->stdineof){
     send_synth_signal(synth);
-    return;
+    return false;
   }
-  pthread_mutex_lock(&ictx->ilock);
-  if(ictx->ivalid == ictx->isize){
-    pthread_mutex_unlock(&ictx->ilock);
-    logwarn("dropping input 0x%08x", tni->id);
-    inc_input_errors(ictx);
-    send_synth_signal(synth);
-    return;
+  if(ictx->svalid == STAGED_INPUTS){
+    publish_staged_inputs(ictx);
   }
-  ncinput* ni = ictx->inputs + ictx->iwrite;
+  ictx->scoalesced[ictx->svalid] = 0;
+  ncinput* ni = ictx->staged + ictx->svalid++;
   memcpy(ni, tni, sizeof(*tni));
   // perform final normalizations
   if(ni->id == 0x7f || ni->id == 0x8){
@@ -540,20 +670,75 @@ load_ncinput(inputctx* ictx, ncinput *tni){
     ni->id = ni->id + 'A' - 1;
     ni->modifiers |= NCKEY_MOD_CTRL;
   }
-  if(++ictx->iwrite == ictx->isize){
-    ictx->iwrite = 0;
+  if(synth){
+    publish_staged_inputs(ictx);
+    send_synth_signal(synth);
   }
-  ++ictx->ivalid;
-  // FIXME we don't always need to write here; write if ictx->ivalid was 0, and
-  // also write *from the client context* if we empty the input buffer there..?
-  mark_pipe_ready(ictx->readypipes);
-  pthread_mutex_unlock(&ictx->ilock);
-  pthread_cond_broadcast(&ictx->icond);
-  send_synth_signal(synth);
+  return true;
+}
+
+// try to fold |tni| into the most recently queued event, which must be of the
+// same |kind| and match in id, modifiers, and event type. that event is either
+// the tail of the stage, or (if nothing is staged) the tail of the ringbuffer,
+// assuming the client hasn't yet taken it. returns true if |tni| was merged.
+static bool
+coalesce_ncinput(inputctx* ictx, const ncinput* tni, mergekind_e kind){
+  if(!ictx->coalesce || kind == MERGE_NONE || ictx->lastmerge != kind){
+    return false;
+  }
+  if(ictx->drain || ictx->stdineof){
+    return false;
+  }
+  bool merged = false;
+  bool locked = false;
+  ncinput* prev = NULL;
+  unsigned* prevcount = NULL;
+  if(ictx->svalid){
+    prev = &ictx->staged[ictx->svalid - 1];
+    prevcount = &ictx->scoalesced[ictx->svalid - 1];
+  }else{
+    pthread_mutex_lock(&ictx->ilock);
+    locked = true;
+    if(ictx->ivalid){
+      int tail = (ictx->iwrite ? ictx->iwrite : ictx->isize) - 1;
+      prev = &ictx->inputs[tail];
+      prevcount = &ictx->icoalesced[tail];
+    }
+  }
+  if(prev && prev->id == tni->id && prev->modifiers == tni->modifiers
+      && prev->evtype == tni->evtype){
+    prev->y = tni->y;
+    prev->x = tni->x;
+    prev->ypx = tni->ypx;
+    prev->xpx = tni->xpx;
+    ++*prevcount;
+    merged = true;
+  }
+  if(locked){
+    pthread_mutex_unlock(&ictx->ilock);
+  }
+  if(merged){
+    ++ictx->sevents;
+    logdebug("coalesced 0x%08x into prior event", tni->id);
+  }
+  return merged;
 }
 
+// as load_ncinput(), but first try to merge |tni| into the previous event
+// if coalescing is enabled. only an event which was actually queued can be
+// merged into later.
 static void
-pixelmouse_click(inputctx* ictx, ncinput* ni, long y, long x){
+load_mergeable_ncinput(inputctx* ictx, ncinput* tni, mergekind_e kind){
+  if(coalesce_ncinput(ictx, tni, kind)){
+    return;
+  }
+  if(load_ncinput(ictx, tni)){
+    ictx->lastmerge = kind;
+  }
+}
+
+static void
+pixelmouse_click(inputctx* ictx, ncinput* ni, long y, long x, mergekind_e kind){
   --x;
   --y;
   if(ictx->ti->cellpxy == 0 || ictx->ti->cellpxx == 0){
@@ -582,7 +767,7 @@ pixelmouse_click(inputctx* ictx, ncinput* ni, long y, long x){
   }
   ni->y = y;
   ni->x = x;
-  load_ncinput(ictx, ni);
+  load_mergeable_ncinput(ictx, ni, kind);
 }
 
 // ictx->numeric, ictx->p3, and ictx->p2 have the two parameters. we're using
@@ -611,6 +796,8 @@ mouse_click(inputctx* ictx, unsigned release, char follow){
   }else{
     tni.evtype = NCTYPE_PRESS;
   }
+  // bit 5 (32) is set for any motion report, with or without buttons held.
+  mergekind_e kind = (mods & 0x20) ? MERGE_MOTION : MERGE_NONE;
   if(mods % 4 == 3){
     tni.id = NCKEY_MOTION;
     tni.evtype = NCTYPE_RELEASE;
@@ -627,7 +814,7 @@ mouse_click(inputctx* ictx, unsigned release, char follow){
     if(ictx->ti->cellpxx == 0){
       logerror("pixelmouse but no pixel info");
     }
-    return pixelmouse_click(ictx, &tni, y, x);
+    return pixelmouse_click(ictx, &tni, y, x, kind);
   }
   x -= (1 + ictx->lmargin);
   y -= (1 + ictx->tmargin);
@@ -648,7 +835,7 @@ mouse_click(inputctx* ictx, unsigned release, char follow){
   tni.y = y;
   tni.ypx = -1;
   tni.xpx = -1;
-  load_ncinput(ictx, &tni);
+  load_mergeable_ncinput(ictx, &tni, kind);
 }
 
 static int
@@ -1927,24 +2114,52 @@ getpipes(ipipe pipes[static 2]){
   return 0;
 }
 
+// on linux, the readiness descriptor is an eventfd in counter mode; we use
+// the same descriptor for both ends. elsewhere, fall back to a pipe.
+static int
+get_readyfds(ipipe fds[static 2]){
+#ifdef __linux__
+  int efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if(efd < 0){
+    logerror("couldn't get eventfd (%s)", strerror(errno));
+    return -1;
+  }
+  fds[0] = fds[1] = efd;
+  return 0;
+#else
+  return getpipes(fds);
+#endif
+}
+
+static void
+end_readyfds(ipipe fds[static 2]){
+#ifdef __linux__
+  closepipe(fds[0]);
+#else
+  endpipes(fds);
+#endif
+}
+
 static inline inputctx*
 create_inputctx(tinfo* ti, FILE* infp, int lmargin, int tmargin, int rmargin,
                 int bmargin, ncsharedstats* stats, unsigned drain,
-                int linesigs_enabled){
+                int linesigs_enabled, unsigned coalesce){
   bool sent_queries = (ti->ttyfd >= 0) ? true : false;
   inputctx* i = malloc(sizeof(*i));
   if(i){
     i->csize = 64;
     if( (i->csrs = malloc(sizeof(*i->csrs) * i->csize)) ){
       i->isize = BUFSIZ;
-      if( (i->inputs = malloc(sizeof(*i->inputs) * i->isize)) ){
+      i->inputs = malloc(sizeof(*i->inputs) * i->isize);
+      i->icoalesced = malloc(sizeof(*i->icoalesced) * i->isize);
+      if(i->inputs && i->icoalesced){
         if(pthread_mutex_init(&i->ilock, NULL) == 0){
           if(pthread_condmonotonic_init(&i->icond) == 0){
             if(pthread_mutex_init(&i->clock, NULL) == 0){
               if(pthread_condmonotonic_init(&i->ccond) == 0){
                 if((i->stdinfd = fileno(infp)) >= 0){
                   if( (i->initdata = malloc(sizeof(*i->initdata))) ){
-                    if(getpipes(i->readypipes) == 0){
+                    if(get_readyfds(i->readyfds) == 0){
                       if(getpipes(i->ipipes) == 0){
                         memset(&i->amata, 0, sizeof(i->amata));
                         if(prep_special_keys(i) == 0){
@@ -1965,6 +2180,10 @@ create_inputctx(tinfo* ti, FILE* infp, int lmargin, int tmargin, int rmargin,
                             }
                             i->kittykbd = 0;
                             i->iread = i->iwrite = i->ivalid = 0;
+                            i->svalid = 0;
+                            i->sevents = 0;
+                            i->coalesce = coalesce;
+                            i->lastmerge = MERGE_NONE;
                             i->cread = i->cwrite = i->cvalid = 0;
                             i->initdata_complete = NULL;
                             i->stats = stats;
@@ -1991,7 +2210,7 @@ create_inputctx(tinfo* ti, FILE* infp, int lmargin, int tmargin, int rmargin,
                       }
                       endpipes(i->ipipes);
                     }
-                    endpipes(i->readypipes);
+                    end_readyfds(i->readyfds);
                   }
                   free(i->initdata);
                 }
@@ -2003,8 +2222,9 @@ create_inputctx(tinfo* ti, FILE* infp, int lmargin, int tmargin, int rmargin,
           }
           pthread_mutex_destroy(&i->ilock);
         }
-        free(i->inputs);
       }
+      free(i->icoalesced);
+      free(i->inputs);
       free(i->csrs);
     }
     free(i);
@@ -2032,8 +2252,9 @@ free_inputctx(inputctx* i){
       free(i->initdata_complete->version);
       free(i->initdata_complete);
     }
-    endpipes(i->readypipes);
+    end_readyfds(i->readyfds);
     endpipes(i->ipipes);
+    free(i->icoalesced);
     free(i->inputs);
     free(i->csrs);
     free(i);
@@ -2214,10 +2435,14 @@ process_escape(inputctx* ictx, const unsigned char* buf, int buflen){
       // off the initial node, which definitely has a valid ->trie, or we're
       // coming from a transition, where ictx->triepos->trie is checked below.
     }else{
-      ncinput ni = {0};
+      // walk_automaton() fills in all of ni upon acceptance (and only then)
+      ncinput ni;
+      ni.id = 0;
       int w = walk_automaton(&ictx->amata, ictx, candidate, &ni);
-      logdebug("walk result on %u (%c): %d %u", candidate,
-               isprint(candidate) ? candidate : ' ', w, ictx->amata.state);
+      if(w){
+        logdebug("walk result on %u (%c): %d %u", candidate,
+                 isprint(candidate) ? candidate : ' ', w, ictx->amata.state);
+      }
       if(w > 0){
         if(ni.id){
           load_ncinput(ictx, &ni);
@@ -2282,6 +2507,67 @@ process_escapes(inputctx* ictx, unsigned char* buf, int* bufused){
   }
 }
 
+// return the length of the run of printable ASCII (0x20..0x7e) at the front of
+// |buf|. such characters require neither UTF-8 decoding nor normalization, and
+// can never be part of a control sequence. we examine a word at a time where
+// we can, and only fall back to bytes to find the end of the run.
+static int
+printable_ascii_run(const unsigned char* buf, int buflen){
+  int r = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  const uint64_t ones = 0x0101010101010101ull;
+  const uint64_t highs = 0x8080808080808080ull;
+  while(buflen - r >= (int)sizeof(uint64_t)){
+    uint64_t w;
+    memcpy(&w, buf + r, sizeof(w));
+    const uint64_t del = w ^ (ones * 0x7f);
+    // high bit of a byte is set if it's >= 0x80, < 0x20, or 0x7f. the
+    // subtractive tests can produce false positives, but only above (i.e.
+    // later in memory than) a true positive, so the first hit is accurate.
+    if((w | ((w - ones * 0x20) & ~w) | ((del - ones) & ~del)) & highs){
+      break;
+    }
+    r += sizeof(w);
+  }
+#endif
+  while(r < buflen && buf[r] >= 0x20 && buf[r] < 0x7f){
+    ++r;
+  }
+  return r;
+}
+
+// stage a run of |len| printable ASCII characters from |buf|. these need none
+// of load_ncinput()'s normalizations (the backspace character is never
+// printable), so we can write them directly, a stageful at a time.
+static void
+load_ascii_run(inputctx* ictx, const unsigned char* buf, int len){
+  ictx->sevents += len;
+  ictx->lastmerge = MERGE_NONE;
+  if(ictx->drain || ictx->stdineof){
+    return;
+  }
+  const ncintype_e evtype = ictx->kittykbd ? NCTYPE_PRESS : NCTYPE_UNKNOWN;
+  while(len){
+    if(ictx->svalid == STAGED_INPUTS){
+      publish_staged_inputs(ictx);
+    }
+    int n = STAGED_INPUTS - ictx->svalid;
+    if(n > len){
+      n = len;
+    }
+    ncinput* ni = ictx->staged + ictx->svalid;
+    memset(ni, 0, sizeof(*ni) * n);
+    memset(ictx->scoalesced + ictx->svalid, 0, sizeof(*ictx->scoalesced) * n);
+    for(int i = 0 ; i < n ; ++i){
+      ni[i].id = buf[i];
+      ni[i].evtype = evtype;
+    }
+    ictx->svalid += n;
+    buf += n;
+    len -= n;
+  }
+}
+
 // precondition: buflen >= 1. attempts to consume UTF8 input from buf. the
 // expected length of a UTF8 character can be determined from its first byte.
 // if we don't have that much data, return 0 and read more. if we determine
@@ -2337,19 +2623,25 @@ process_ncinput(inputctx* ictx, const unsigned char* buf, int buflen){
 static void
 process_bulk(inputctx* ictx, unsigned char* buf, int* bufused){
   int offset = 0;
+  // only the client can make more room, so we needn't recheck until we think
+  // we've run out (each consumed character stages at most one event).
+  int room = input_room(ictx);
   while(*bufused){
-    bool noroom = false;
-    pthread_mutex_lock(&ictx->ilock);
-    if(ictx->ivalid == ictx->isize){
-      noroom = true;
-    }
-    pthread_mutex_unlock(&ictx->ilock);
-    if(noroom){
-      break;
+    if(room <= 0){
+      publish_staged_inputs(ictx);
+      if((room = input_room(ictx)) <= 0){
+        break;
+      }
     }
-    int consumed = process_ncinput(ictx, buf + offset, *bufused);
-    if(consumed <= 0){
-      break;
+    int consumed = printable_ascii_run(buf + offset, *bufused < room ? *bufused : room);
+    if(consumed){
+      load_ascii_run(ictx, buf + offset, consumed);
+      room -= consumed;
+    }else{
+      if((consumed = process_ncinput(ictx, buf + offset, *bufused)) <= 0){
+        break;
+      }
+      --room;
     }
     *bufused -= consumed;
     offset += consumed;
@@ -2370,9 +2662,15 @@ process_melange(inputctx* ictx, const unsigned char* buf, int* bufused){
   int offset = 0;
   int origlen = *bufused;
   while(*bufused){
+    int consumed = printable_ascii_run(buf + offset, *bufused);
+    if(consumed){
+      load_ascii_run(ictx, buf + offset, consumed);
+      *bufused -= consumed;
+      offset += consumed;
+      continue;
+    }
     logdebug("input %d (%u)/%d [0x%02x] (%c)", offset, ictx->amata.used,
              *bufused, buf[offset], isprint(buf[offset]) ? buf[offset] : ' ');
-    int consumed = 0;
     if(buf[offset] == '\x1b'){
       consumed = process_escape(ictx, buf + offset, *bufused);
       if(consumed < 0){
@@ -2390,6 +2688,10 @@ process_melange(inputctx* ictx, const unsigned char* buf, int* bufused){
     // or if we need to read more to determine what it is.
     if(consumed <= 0 && !ictx->midescape){
       consumed = process_ncinput(ictx, buf + offset, *bufused);
+      // a UTF-8 character broken across reads; wait for the remainder
+      if(consumed == 0){
+        break;
+      }
     }
     if(consumed < 0){
       break;
@@ -2404,11 +2706,22 @@ process_melange(inputctx* ictx, const unsigned char* buf, int* bufused){
 static void
 process_ibuf(inputctx* ictx){
   if(resize_seen){
+    resize_seen = 0;
+    if(ictx->coalesce){
+      ictx->resizedue = clock_getns(CLOCK_MONOTONIC) + RESIZE_DEBOUNCE_NS;
+    }else{
+      ncinput tni = {
+        .id = NCKEY_RESIZE,
+      };
+      load_mergeable_ncinput(ictx, &tni, MERGE_RESIZE);
+    }
+  }
+  if(ictx->resizedue && clock_getns(CLOCK_MONOTONIC) >= ictx->resizedue){
+    ictx->resizedue = 0;
     ncinput tni = {
       .id = NCKEY_RESIZE,
     };
-    load_ncinput(ictx, &tni);
-    resize_seen = 0;
+    load_mergeable_ncinput(ictx, &tni, MERGE_RESIZE);
   }
   if(cont_seen){
     ncinput tni = {
@@ -2438,10 +2751,12 @@ process_ibuf(inputctx* ictx){
       }
     }
   }
+  publish_staged_inputs(ictx);
 }
 
 int ncinput_shovel(inputctx* ictx, const void* buf, int len){
   process_melange(ictx, buf, &len);
+  publish_staged_inputs(ictx);
   if(len){
     logwarn("dropping %d byte%s", len, len == 1 ? "" : "s");
     inc_input_errors(ictx);
@@ -2522,12 +2837,19 @@ block_on_input(inputctx* ictx, unsigned* rtfd, unsigned* rifd){
   sigdelset(&smask, SIGTHR);
 #endif
   int events;
+  // a held resize bounds our wait
+  uint64_t waitns = nonblock ? 0 : UINT64_MAX;
+  if(ictx->resizedue && !nonblock){
+    uint64_t now = clock_getns(CLOCK_MONOTONIC);
+    waitns = ictx->resizedue > now ? ictx->resizedue - now : 0;
+  }
 #if defined(__APPLE__) || defined(__MINGW32__)
-  int timeoutms = nonblock ? 0 : -1;
+  int timeoutms = waitns == UINT64_MAX ? -1 : (int)((waitns + 999999) / 1000000);
   while((events = poll(pfds, pfdcount, timeoutms)) < 0){ // FIXME smask?
 #else
-  struct timespec ts = { .tv_sec = 0, .tv_nsec = 0, };
-  struct timespec* pts = nonblock ? &ts : NULL;
+  struct timespec ts;
+  ns_to_timespec(waitns, &ts);
+  struct timespec* pts = waitns == UINT64_MAX ? NULL : &ts;
   while((events = ppoll(pfds, pfdcount, pts, &smask)) < 0){
 #endif
     if(errno == EINTR){
@@ -2581,7 +2903,9 @@ read_inputs_nblock(inputctx* ictx){
     // did we switch from non-EOF state to EOF? if so, mark us ready
     if(!eof && ictx->stdineof){
       // we hit EOF; write an event to the readiness fd
-      mark_pipe_ready(ictx->readypipes);
+      pthread_mutex_lock(&ictx->ilock);
+      mark_ready(ictx->readyfds);
+      pthread_mutex_unlock(&ictx->ilock);
       pthread_cond_broadcast(&ictx->icond);
     }
   }
@@ -2591,7 +2915,8 @@ static void*
 input_thread(void* vmarshall){
   setup_alt_sig_stack();
   inputctx* ictx = vmarshall;
-  if(prep_all_keys(ictx) || build_cflow_automaton(ictx)){
+  if(prep_all_keys(ictx) || build_cflow_automaton(ictx)
+      || compile_automaton(&ictx->amata)){
     ictx->failed = true;
     handoff_initial_responses_early(ictx);
     handoff_initial_responses_late(ictx);
@@ -2606,9 +2931,10 @@ input_thread(void* vmarshall){
 
 int init_inputlayer(tinfo* ti, FILE* infp, int lmargin, int tmargin,
                     int rmargin, int bmargin, ncsharedstats* stats,
-                    unsigned drain, int linesigs_enabled){
+                    unsigned drain, int linesigs_enabled, unsigned coalesce){
   inputctx* ictx = create_inputctx(ti, infp, lmargin, tmargin, rmargin,
-                                   bmargin, stats, drain, linesigs_enabled);
+                                   bmargin, stats, drain, linesigs_enabled,
+                                   coalesce);
   if(ictx == NULL){
     return -1;
   }
@@ -2640,7 +2966,7 @@ int stop_inputlayer(tinfo* ti){
 
 int inputready_fd(const inputctx* ictx){
 #ifndef __MINGW32__
-  return ictx->readypipes[0];
+  return ictx->readyfds[0];
 #else
   (void)ictx;
   logerror("readiness descriptor unavailable on windows");
@@ -2648,9 +2974,15 @@ int inputready_fd(const inputctx* ictx){
 #endif
 }
 
+// if |coalesced| is not NULL, it receives the number of events merged into
+// the one returned (0 if none was returned).
 static inline uint32_t
-internal_get(inputctx* ictx, const struct timespec* ts, ncinput* ni){
+internal_get(inputctx* ictx, const struct timespec* ts, ncinput* ni,
+             unsigned* coalesced){
   uint32_t id;
+  if(coalesced){
+    *coalesced = 0;
+  }
   if(ictx->drain){
     logerror("input is being drained");
     if(ni){
@@ -2691,6 +3023,9 @@ internal_get(inputctx* ictx, const struct timespec* ts, ncinput* ni){
     }
   }
   id = ictx->inputs[ictx->iread].id;
+  if(coalesced){
+    *coalesced = ictx->icoalesced[ictx->iread];
+  }
   if(ni){
     memcpy(ni, &ictx->inputs[ictx->iread], sizeof(*ni));
     if(notcurses_ucs32_to_utf8(&ni->id, 1, (unsigned char*)ni->utf8, sizeof(ni->utf8)) < 0){
@@ -2704,21 +3039,12 @@ internal_get(inputctx* ictx, const struct timespec* ts, ncinput* ni){
   bool sendsignal = false;
   if(ictx->ivalid-- == ictx->isize){
     sendsignal = true;
-  }else{
-    logtrace("draining event readiness pipe %d", ictx->ivalid);
-#ifndef __MINGW32__
-    char c;
-    while(read(ictx->readypipes[0], &c, sizeof(c)) == 1){
-      // FIXME accelerate?
-    }
-#else
-    // we ought be draining this, but it breaks everything, as we can't easily
-    // do nonblocking input from a pipe in windows, augh...
-    // Ne pleure pas, Alfred! J'ai besoin de tout mon courage pour mourir a vingt ans!
-    /*while(ReadFile(ictx->readypipes[0], &c, sizeof(c), NULL, NULL)){
-      // FIXME accelerate?
-    }*/
-#endif
+  }
+  // the readiness descriptor stays readable so long as there's input (or we
+  // hit EOF, which the client will want to see).
+  if(ictx->ivalid == 0 && !ictx->stdineof){
+    logtrace("draining event readiness fd");
+    drain_ready(ictx->readyfds);
   }
   pthread_mutex_unlock(&ictx->ilock);
   if(sendsignal){
@@ -2729,10 +3055,15 @@ internal_get(inputctx* ictx, const struct timespec* ts, ncinput* ni){
 
 // infp has already been set non-blocking
 uint32_t notcurses_get(notcurses* nc, const struct timespec* absdl, ncinput* ni){
-  uint32_t ret = internal_get(nc->tcache.ictx, absdl, ni);
+  uint32_t ret = internal_get(nc->tcache.ictx, absdl, ni, NULL);
   return ret;
 }
 
+uint32_t notcurses_get_coalesced(notcurses* nc, const struct timespec* absdl,
+                                 ncinput* ni, unsigned* coalesced){
+  return internal_get(nc->tcache.ictx, absdl, ni, coalesced);
+}
+
 // FIXME better performance if we move this within the locked area
 int notcurses_getvec(notcurses* n, const struct timespec* absdl,
                      ncinput* ni, int vcount){
@@ -2755,7 +3086,7 @@ uint32_t ncdirect_get(ncdirect* n, const struct timespec* absdl, ncinput* ni){
     logerror("already got EOF");
     return -1;
   }
-  uint32_t r = internal_get(n->tcache.ictx, absdl, ni);
+  uint32_t r = internal_get(n->tcache.ictx, absdl, ni, NULL);
   if(r == NCKEY_EOF){
     n->eof = 1;
   }
@@ -15,7 +15,7 @@ struct ncsharedstats;
 
 int init_inputlayer(struct tinfo* ti, FILE* infp, int lmargin, int tmargin,
                     int rmargin, int bmargin, struct ncsharedstats* stats,
-                    unsigned drain, int linesigs_enabled)
+                    unsigned drain, int linesigs_enabled, unsigned coalesce)
   __attribute__ ((nonnull (1, 2, 7)));
 
 int stop_inputlayer(struct tinfo* ti);
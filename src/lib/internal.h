@@ -70,11 +70,39 @@ struct ncvisual_details;
 // screen is resized, for example. Offscreen portions will not be rendered.
 // Accesses beyond the borders of a panel, however, are errors.
 //
+// A compact cell: an nccell with its channels interned into the plane's table
+// of channel pairs, and its stylemask narrowed to 8 bits. A zeroed compact
+// cell is equivalent to a zeroed nccell.
+typedef struct nccompact {
+  uint32_t gcluster;   // as in nccell
+  uint16_t pair;       // index into compactfb->pairs
+  uint8_t width;       // as in nccell
+  uint8_t stylemask;   // low 8 bits of nccell's stylemask
+} nccompact;
+
+// Storage for planes created with NCPLANE_OPTION_COMPACT, which have no 'fb'.
+// Cells are accessed through a single "hot" row expanded to full nccells,
+// written back to 'cells' whenever another row is wanted. Pointers to cells
+// of a compact plane are thus only valid until another row is accessed.
+typedef struct compactfb {
+  nccompact* cells;     // compact cells, laid out as 'fb' would be
+  uint64_t* pairs;      // interned channel pairs, pairs[0] is always 0
+  unsigned paircount;   // pairs in use
+  unsigned paircap;     // pairs allocated
+  uint16_t* pairhash;   // open-addressed indices into pairs, 0 is empty
+  unsigned hashcap;     // slots in pairhash, a power of 2
+  nccell* hotrow;       // the expansion of virtual row 'hoty'
+  int hoty;             // virtual row held in hotrow, -1 if none
+  bool hotdirty;        // has hotrow been written since it was expanded?
+} compactfb;
+
 // The framebuffer 'fb' is a set of rows. For scrolling, we interpret it as a
 // circular buffer of rows. 'logrow' is the index of the row at the logical top
 // of the plane. It only changes from 0 if the plane is scrollable.
 typedef struct ncplane {
   nccell* fb;            // "framebuffer" of character cells
+  compactfb* compact;    // replaces fb for NCPLANE_OPTION_COMPACT, else NULL
+  struct ncscrollback* scrollback; // rows scrolled off the top, or NULL
   int logrow;            // logical top row, starts at 0, add one for each scroll
   unsigned x, y;         // current cursor location within this plane
   // ncplane_yx() etc. use coordinates relative to the plane to which this
@@ -116,6 +144,7 @@ typedef struct ncplane {
   bool scrolling;        // is scrolling enabled? always disabled by default
   bool fixedbound;       // are we fixed relative to the parent's scrolling?
   bool autogrow;         // do we grow to accommodate output?
+  bool lowpriority;      // may updates be deferred when bandwidth is short?
 
   // we need to track any widget to which we are bound, so that (1) we don't
   // end up bound to two widgets and (2) we can clean them up on shutdown
@@ -162,6 +191,29 @@ typedef struct rasterstate {
   bool bgpalelidable;
   bool fgdefelidable;
   bool bgdefelidable;
+
+  // for each row, the first and last columns which the first glyph phase
+  // left damaged (because they were above a bitmap), so that the second
+  // glyph phase needn't revisit the entire frame. first > last if none were.
+  unsigned* deferred; // two per row
+  unsigned deferredrows; // capacity of deferred, in rows
+
+  struct timespec rasterdone; // when the last frame finished rasterizing
+
+  // large bitmap payloads aren't copied into f, but referenced from it, and
+  // gathered in with writev() when the frame is written. splices are only
+  // taken while splicing is set (during raster_and_write()).
+  fbufsplice* splices;
+  unsigned splicecount; // splices in use for the current frame
+  unsigned splicecap;   // capacity of splices
+  uint64_t splicedbytes; // total length of the current frame's splices
+  bool splicing;
+  // RGB colors may be emitted via nc->dynpal's registers in this frame
+  bool dynpal;
+
+  // set by ncpile_rasterize() when another pile is replacing the one on
+  // screen, so that its bitmaps are cleared at the start of the frame.
+  struct ncpile* leaving;
 } rasterstate;
 
 // Tablets are the toplevel entitites within an ncreel. Each corresponds to
@@ -199,6 +251,10 @@ typedef struct ncfdplane {
   ncplane* ncp;               // bound ncplane
   pthread_t tid;              // thread servicing this i/o
   bool destroyed;             // set in ncfdplane_destroy() in our own context
+  size_t bufsize;             // maximum bytes read per callback
+  uint64_t coalesce_ns;       // minimum interval between callbacks (0: none)
+  unsigned char carry[5];     // partial UTF-8 held by the built-in sink
+  unsigned carried;           // bytes in carry
 } ncfdplane;
 
 typedef struct ncsubproc {
@@ -256,6 +312,7 @@ typedef struct ncdirect {
   uint64_t flags;            // copied in ncdirect_init() from param
   ncsharedstats stats;       // stats! not as broadly used as in notcurses
   unsigned eof;              // have we seen EOF on stdin?
+  fbuf obuf;                 // escapes are built here, then moved to ttyfp
 } ncdirect;
 
 // Extracellular state for a cell during the render process. There is one
@@ -314,6 +371,9 @@ struct crender {
 //
 // at context start, there is one pile (the standard pile), containing one
 // plane (the standard plane). each ncplane holds a pointer to its pile.
+// number of framebuffer size classes retained by a pile's arena
+#define ARENA_FBCLASSES 17
+
 typedef struct ncpile {
   ncplane* top;               // topmost plane, never NULL
   ncplane* bottom;            // bottommost plane, never NULL
@@ -321,13 +381,63 @@ typedef struct ncpile {
   struct crender* crender;    // array (rows * cols crender objects)
   struct notcurses* nc;       // notcurses context
   struct ncpile *prev, *next; // circular list pointers
-  size_t crenderlen;          // size of crender vector
+  size_t crenderlen;          // capacity of crender vector, in crenders
   unsigned dimy, dimx;        // rows and cols at last render/creation
   unsigned cellpxx, cellpxy;  // cell-pixel geometry at last render/creation
   int scrolls;                // how many real lines need be scrolled at raster
   sprixel* sprixelcache;      // sorted list of sprixels, assembled during paint
+  sprixel* sprixelwork;       // sprixels not known to be QUIESCENT (unsorted)
+  unsigned sprixelcount;      // number of sprixels in sprixelcache
+  // plane structs and framebuffers retained for reuse, see arena.c
+  struct ncplane* shells;     // freed planes, linked through ->bnext
+  unsigned shellcount;        // number of planes in shells
+  nccell* fbfree[ARENA_FBCLASSES]; // freed framebuffers, by size class
+  unsigned fbcount[ARENA_FBCLASSES];
+  // with NCOPTION_RETAIN_PILE_BITMAPS, kitty graphics are left loaded in the
+  // terminal while their pile isn't displayed, subject to a global budget.
+  uint64_t parkedbytes;       // decoded bytes of such graphics, 0 if shown
+  uint64_t lastshown;         // nc->pileswitches when we were last hidden
 } ncpile;
 
+// dynamic palette state (see notcurses_set_dynamic_palette()). RGB colors
+// which are emitted often enough to pay for an initc are mapped onto the top
+// 'count' registers of the 256-color palette, and thereafter selected with
+// the shorter indexed SGR. the mapping is planned as each terminal-bound
+// frame is rasterized, using the counts gathered during the previous one.
+#define DYNPAL_MAXREGS 240  // the 16 ANSI colors are never touched
+#define DYNPAL_MAPSIZE 512  // rgb->register hash, a power of 2 > 2 * MAXREGS
+#define DYNPAL_CANDSIZE 4096 // unmapped color hash, a power of 2
+#define DYNPAL_MAXEVICT 16  // registers reprogrammed away from a color per frame
+
+typedef struct dynpalcand {
+  uint32_t rgb;
+  uint32_t hits;
+} dynpalcand;
+
+typedef struct dynpalette {
+  unsigned count;      // registers managed, 0 if disabled
+  unsigned initclen;   // bytes required to program a register, approximately
+  uint64_t frame;      // terminal-bound frames planned
+  unsigned lowreg;     // lowest register ever programmed, 256 if none
+  bool rebuild;        // count has changed; rebuild the map
+  // regs[i] is palette register 255 - i. registers beyond count retain their
+  // mapping, so that we know what they're displaying should count grow back.
+  struct {
+    uint32_t rgb;      // color programmed into the register, if mapped
+    uint64_t lastused; // frame in which we last emitted the register
+    bool mapped;
+    bool appowned;     // the application has programmed this register itself
+  } regs[DYNPAL_MAXREGS];
+  int16_t map[DYNPAL_MAPSIZE]; // rgb -> index into regs, -1 if empty
+  // RGB emissions of unmapped colors during the current frame. slots with no
+  // hits are empty. we stop adding new colors once half full.
+  dynpalcand cands[DYNPAL_CANDSIZE];
+  unsigned candcount;
+  // colors whose registers have been taken away, pending a damage pass
+  uint32_t gone[DYNPAL_MAXREGS];
+  unsigned gonecount;
+} dynpalette;
+
 // the standard pile can be reached through ->stdplane.
 typedef struct notcurses {
   ncplane* stdplane; // standard plane, covers screen
@@ -339,16 +449,21 @@ typedef struct notcurses {
   // notcurses_at_yx() and O(1) damage detection (at the cost of some memory).
   // FIXME why isn't this just an ncplane rather than ~10 different members?
   nccell* lastframe;// last rasterized framebuffer, NULL until first raster
-  // the last pile we rasterized. NULL until we've rasterized once. might
-  // be invalid due to the pile being destroyed; you are only allowed to
-  // evaluate it for equality to the pile being currently rasterized. when
-  // we switch piles, we need to clear all displayed sprixels, and
-  // invalidate the new pile's, pursuant to their display.
+  // the last pile we rasterized. NULL until we've rasterized once, following
+  // a refresh, and if that pile is destroyed. when we switch piles, we need
+  // to clear all displayed sprixels, and invalidate the new pile's, pursuant
+  // to their display.
   ncpile* last_pile;
+  uint64_t pileswitches; // times the displayed pile has changed
+  // ids of kitty graphics which destroyed piles left loaded in the terminal,
+  // to be deleted at the start of the next frame. guarded by pilelock.
+  uint32_t* orphans;
+  unsigned orphancount, orphancap;
   egcpool pool;   // egcpool for lastframe
 
   unsigned lfdimx; // dimensions of lastframe, unchanged by screen resize
   unsigned lfdimy; // lfdimx/lfdimy are 0 until first rasterization
+  size_t lfcap;    // cells allocated for lastframe (>= lfdimy * lfdimx)
 
   int cursory;    // desired cursor placement according to user.
   int cursorx;    // -1 is don't-care, otherwise moved here after each render.
@@ -366,9 +481,28 @@ typedef struct notcurses {
   ncpalette palette; // 256-indexed palette can be used instead of/with RGB
   bool palette_damage[NCPALETTESIZE];
   bool touched_palette; // have we ever changed a palette entry?
+  dynpalette* dynpal; // NULL until notcurses_set_dynamic_palette()
   uint64_t flags;  // copied from notcurses_options
+  struct ncsink* sinks; // output sinks, receiving each rasterized frame
+  bool sinkkeyframe;    // a sink needs resynchronizing; build it a keyframe
+  pthread_mutex_t sinklock; // guards sinks and sinkkeyframe
+
+  // bandwidth budgeting (see notcurses_set_bandwidth()). a token bucket of
+  // bwcredit bytes refills at bwbudget bytes per second, capped at one
+  // second's worth. the degradation level rises when a frame like the last
+  // can't be afforded, and falls once half the bucket is full.
+  uint64_t bwbudget;    // bytes per second, 0 for unlimited
+  int64_t bwcredit;     // bytes currently affordable
+  uint64_t bwlastns;    // CLOCK_MONOTONIC time of the last writeout
+  unsigned degrade;     // current degradation level, 0..NCDEGRADE_MAX
+  // while degraded, the undegraded channels of each cell as last solved, so
+  // that we can tell when degradation absorbed an update. NULL otherwise.
+  uint64_t* fidelity;
+  size_t fidelitylen;   // cells in fidelity
 } notcurses;
 
+#define NCDEGRADE_MAX 3
+
 typedef struct blitterargs {
   // FIXME begy/begx are really only of interest to scaling; they ought be
   // consumed there, and blitters ought always work with the scaled output.
@@ -444,6 +578,59 @@ ncplane_pile_const(const ncplane* n){
   return n->pile;
 }
 
+// link |s| onto the worklist of |p|, unless it's already on one.
+static inline void
+sprixel_work_link(ncpile* p, sprixel* s){
+  if(s->wprev == NULL){
+    if( (s->wnext = p->sprixelwork) ){
+      s->wnext->wprev = &s->wnext;
+    }
+    p->sprixelwork = s;
+    s->wprev = &p->sprixelwork;
+  }
+}
+
+// remove |s| from whatever worklist it's on, if any.
+static inline void
+sprixel_work_unlink(sprixel* s){
+  if(s->wprev){
+    if( (*s->wprev = s->wnext) ){
+      s->wnext->wprev = s->wprev;
+    }
+    s->wprev = NULL;
+    s->wnext = NULL;
+  }
+}
+
+// decoded bytes a parked kitty graphic occupies in the terminal. those with no
+// glyph to retransmit (kitty animation support drops it once drawn) can't be
+// evicted, and don't count.
+static inline uint64_t
+sprixel_parkedbytes(const sprixel* s){
+  return s->glyph.used ? (uint64_t)s->pixy * s->pixx * 4 : 0;
+}
+
+// all sprixel state transitions ought go through here. anything other than
+// SPRIXEL_QUIESCENT puts the sprixel on its pile's worklist; sprixels are
+// only dropped from the worklist following rasterization, once they've
+// settled. a sprixel without a plane (i.e. one being hidden) must already
+// be on the worklist.
+static inline void
+sprixel_set_state(sprixel* s, sprixel_e state){
+  ncpile* p = s->n ? ncplane_pile(s->n) : NULL;
+  // a hidden pile's graphic leaving LOADED no longer counts against the
+  // budget for parked graphics (the terminal might still hold it, but it'll
+  // be deleted or replaced when the pile returns, or is destroyed).
+  if(p && s->invalidated == SPRIXEL_LOADED && state != SPRIXEL_LOADED){
+    uint64_t parked = sprixel_parkedbytes(s);
+    p->parkedbytes = p->parkedbytes > parked ? p->parkedbytes - parked : 0;
+  }
+  s->invalidated = state;
+  if(state != SPRIXEL_QUIESCENT && p){
+    sprixel_work_link(p, s);
+  }
+}
+
 static inline ncplane*
 ncplane_stdplane(ncplane* n){
   return notcurses_stdplane(ncplane_notcurses(n));
@@ -490,6 +677,22 @@ logical_to_virtual(const ncplane* n, int y){
 
 int clear_and_home(notcurses* nc, tinfo* ti, fbuf* f);
 
+// copy a frame written to the terminal out to any output sinks. a keyframe
+// is self-contained, and is only offered to sinks which have dropped frames,
+// in order to resynchronize them; the terminal never sees it.
+int ncsinks_publish(notcurses* nc, const char* buf, size_t len, bool keyframe);
+
+// publish the frame made up of |f| following its first |moffset| bytes, and
+// the |count| splices of |s|, to any output sinks.
+int ncsinks_publish_spliced(notcurses* nc, const fbuf* f, size_t moffset,
+                            const fbufsplice* s, unsigned count);
+
+// destroy all output sinks, flushing their queues.
+int ncsinks_destroy(notcurses* nc);
+
+// does some sink need a keyframe? clears the request.
+bool ncsinks_take_keyframe(notcurses* nc);
+
 static inline int
 nfbcellidx(const ncplane* n, int row, int col){
   return fbcellidx(logical_to_virtual(n, row), n->lenx, col);
@@ -598,8 +801,59 @@ pool_extended_gcluster(const egcpool* pool, const nccell* c){
   return egcpool_extended_gcluster(pool, c);
 }
 
+// compact planes (see compact.c). compactfb_cell() writes back the hot row,
+// expands virtual row 'vrow', and returns its cell 'x'. it might convert the
+// plane to a full framebuffer, should its pair table overflow.
+nccell* compactfb_cell(ncplane* n, int vrow, unsigned x, bool write);
+int ncplane_compact_init(ncplane* n);
+void ncplane_compact_free(ncplane* n);
+// write back the hot row, if any, and release it.
+void ncplane_compact_flush(ncplane* n);
+void ncplane_compact_clear_row(ncplane* n, int vrow);
+void ncplane_compact_erase(ncplane* n);
+int ncplane_compact_resize(ncplane* n, int keepy, int keepx,
+                           unsigned keepleny, unsigned keeplenx,
+                           int yoff, int xoff, unsigned ylen, unsigned xlen);
+
+// scrollback stores (see scrollback.c). ncscrollback_push() appends row 'y'
+// of 'n', which is about to be scrolled away.
+int ncscrollback_push(ncplane* n, unsigned y);
+void ncscrollback_destroy(struct ncscrollback* sb);
+
+// bytes of framebuffer per cell
+static inline size_t
+ncplane_cellbytes(const ncplane* n){
+  return n->compact ? sizeof(nccompact) : sizeof(nccell);
+}
+
+static inline nccell*
+compact_cell(const ncplane* n, unsigned y, unsigned x, bool write){
+  compactfb* cfb = n->compact;
+  const int vrow = logical_to_virtual(n, y);
+  if(vrow != cfb->hoty){
+    return compactfb_cell((ncplane*)n, vrow, x, write);
+  }
+  cfb->hotdirty |= write;
+  return cfb->hotrow + x;
+}
+
+// reference a cell for writing. for a compact plane, the reference is only
+// good until another row is accessed.
 static inline nccell*
 ncplane_cell_ref_yx(const ncplane* n, unsigned y, unsigned x){
+  if(n->compact){
+    return compact_cell(n, y, x, true);
+  }
+  return &n->fb[nfbcellidx(n, y, x)];
+}
+
+// reference a cell for reading only. this needn't write back a compact
+// plane's hot row when it moves on.
+static inline const nccell*
+ncplane_cell_peek_yx(const ncplane* n, unsigned y, unsigned x){
+  if(n->compact){
+    return compact_cell(n, y, x, false);
+  }
   return &n->fb[nfbcellidx(n, y, x)];
 }
 
@@ -618,7 +872,7 @@ plane_debug(const ncplane* n, bool details){
   if(details){
     for(unsigned y = 0 ; y < 1 ; ++y){
       for(unsigned x = 0 ; x < 10 ; ++x){
-        const nccell* c = &n->fb[fbcellidx(y, dimx, x)];
+        const nccell* c = ncplane_cell_peek_yx(n, y, x);
         fprintf(stderr, "[%03d/%03d] ", y, x);
         cell_debug(&n->pool, c);
       }
@@ -769,17 +1023,17 @@ static inline void
 cleanup_tam(tament* tam, int ydim, int xdim){
   for(int y = 0 ; y < ydim ; ++y){
     for(int x = 0 ; x < xdim ; ++x){
-      free(tam[y * xdim + x].auxvector);
+      tam_auxvec_free(tam, tam[y * xdim + x].auxvector);
       tam[y * xdim + x].auxvector = NULL;
     }
   }
 }
 
+// the auxvecs go along with the slab, whatever our geometry
 static inline void
 destroy_tam(ncplane* p){
   if(p->tam){
-    cleanup_tam(p->tam, p->leny, p->lenx);
-    free(p->tam);
+    free_tam(p->tam);
     p->tam = NULL;
   }
 }
@@ -799,7 +1053,7 @@ sprite_rebuild(const notcurses* nc, sprixel* s, int ycell, int xcell){
     // sets the new state itself
     ret = nc->tcache.pixel_rebuild(s, ycell, xcell, auxvec);
     if(ret > 0){
-      free(auxvec);
+      tam_auxvec_free(s->n->tam, auxvec);
       s->n->tam[idx].auxvector = NULL;
     }
   }else{
@@ -810,7 +1064,7 @@ sprite_rebuild(const notcurses* nc, sprixel* s, int ycell, int xcell){
     if(s->n->tam[idx].state != SPRIXCELL_TRANSPARENT &&
        s->n->tam[idx].state != SPRIXCELL_ANNIHILATED &&
        s->n->tam[idx].state != SPRIXCELL_ANNIHILATED_TRANS){
-      s->invalidated = SPRIXEL_INVALIDATED;
+      sprixel_set_state(s, SPRIXEL_INVALIDATED);
     }
   }
   return ret;
@@ -1072,6 +1326,18 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n, const ncplane_options*
 
 void free_plane(ncplane* p);
 
+// per-pile recycling of plane structs and framebuffers. pile may be NULL,
+// in which case these fall through to the heap. framebuffers must be freed
+// with the same cell count with which they were allocated.
+nccell* ncpile_fb_alloc(ncpile* pile, size_t cells);
+void ncpile_fb_free(ncpile* pile, nccell* fb, size_t cells);
+nccell* ncpile_fb_realloc(ncpile* pile, nccell* fb, size_t oldcells,
+                          size_t newcells);
+ncplane* ncpile_plane_alloc(ncpile* pile);
+void ncpile_plane_free(ncpile* pile, ncplane* p);
+// free everything retained by the pile's arena
+void ncpile_arena_release(ncpile* pile);
+
 // heap-allocated formatted output
 ALLOC char* ncplane_vprintf_prep(const char* format, va_list ap);
 
@@ -1489,6 +1755,11 @@ cell_load_direct(ncplane* n, nccell* c, const char* gcluster, int bytes, int col
 // increment y by 1 and rotate the framebuffer up one line. x moves to 0.
 void scroll_down(ncplane* n);
 
+// write |len| bytes of printable ASCII at the cursor, without decoding them
+// as UTF-8. returns the number of columns written, or a non-positive number
+// (the negated columns written) on error.
+int ncplane_putascii(ncplane* n, const char* s, size_t len);
+
 static inline bool
 islinebreak(wchar_t wchar){
   // UC_LINE_SEPARATOR + UC_PARAGRAPH_SEPARATOR
@@ -1687,10 +1958,37 @@ ncdirect_bg_palindex_p(const ncdirect* nc){
 
 int ncdirect_set_fg_rgb_f(ncdirect* nc, unsigned rgb, fbuf* f);
 int ncdirect_set_bg_rgb_f(ncdirect* nc, unsigned rgb, fbuf* f);
+
+// write out whatever has been built up in nc->obuf, and reset it. if
+// |immediate| is set, this happens right away, following a flush of ttyfp
+// (so that our output follows anything already buffered there). otherwise,
+// or if we were initialized with NCDIRECT_OPTION_BUFFERED_OUTPUT, it is
+// appended to ttyfp's buffer, to go out when stdio decides (at a newline if
+// ttyfp is line-buffered, or when the buffer fills), or at ncdirect_flush().
+// either way, the obuf persists across calls, sparing us a map+unmap apiece.
+static inline int
+ncdirect_commit_obuf(ncdirect* nc, bool immediate){
+  if(immediate && !(nc->flags & NCDIRECT_OPTION_BUFFERED_OUTPUT)){
+    return fbuf_flush(&nc->obuf, nc->ttyfp);
+  }
+  int ret = 0;
+  if(nc->obuf.used){
+    if(fwrite(nc->obuf.buf, nc->obuf.used, 1, nc->ttyfp) != 1){
+      ret = -1;
+    }
+  }
+  fbuf_reset(&nc->obuf);
+  return ret;
+}
+
 int term_fg_rgb8(const tinfo* ti, fbuf* f, unsigned r, unsigned g, unsigned b);
 
 const struct blitset* lookup_blitset(const tinfo* tcache, ncblitter_e setid, bool may_degrade);
 
+// index of the inline EGC |gcluster| within |bset|'s 'egcs', or -1 if it is
+// not part of the set. the empty EGC maps to 0, like space.
+int blitset_egc_idx(const struct blitset* bset, uint32_t gcluster);
+
 static inline int
 rgba_blit_dispatch(ncplane* nc, const struct blitset* bset,
                    int linesize, const void* data,
@@ -266,7 +266,7 @@ int kitty_rebuild(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
 //fprintf(stderr, "CLEARED ROW, TARGY: %d\n", targy - 1);
         if(--targy == 0){
           s->n->tam[s->dimx * ycell + xcell].state = state;
-          s->invalidated = SPRIXEL_INVALIDATED;
+          sprixel_set_state(s, SPRIXEL_INVALIDATED);
           return 1;
         }
         thisrow = targx;
@@ -309,11 +309,11 @@ kitty_anim_auxvec_blitsource_p(const sprixel* s, const uint8_t* auxvec){
 // whether the null write originated in blitting or wiping, as that affects
 // our rebuild animation.
 static inline void*
-kitty_anim_auxvec(int dimy, int dimx, int posy, int posx,
+kitty_anim_auxvec(tament* tam, int dimy, int dimx, int posy, int posx,
                   int cellpxy, int cellpxx, const uint32_t* data,
                   int rowstride, uint8_t* existing, uint32_t transcolor){
   const size_t slen = 4 * cellpxy * cellpxx + 1;
-  uint32_t* a = existing ? existing : malloc(slen);
+  uint32_t* a = existing ? (uint32_t*)existing : tam_auxvec(tam, slen);
   if(a){
     for(int y = posy ; y < posy + cellpxy && y < dimy ; ++y){
       int pixels = cellpxx;
@@ -339,9 +339,9 @@ kitty_anim_auxvec(int dimy, int dimx, int posy, int posx,
   return a;
 }
 
-uint8_t* kitty_trans_auxvec(const ncpile* p){
+uint8_t* kitty_trans_auxvec(const ncpile* p, tament* tam){
   const size_t slen = p->cellpxy * p->cellpxx;
-  uint8_t* a = malloc(slen);
+  uint8_t* a = tam_auxvec(tam, slen);
   if(a){
     memset(a, 0, slen);
   }
@@ -403,7 +403,7 @@ int kitty_wipe_animation(sprixel* s, int ycell, int xcell){
   int tamidx = ycell * s->dimx + xcell;
   uint8_t* auxvec = s->n->tam[tamidx].auxvector;
   auxvec[ncplane_pile(s->n)->cellpxx * ncplane_pile(s->n)->cellpxy * 4] = 0;
-  s->invalidated = SPRIXEL_INVALIDATED;
+  sprixel_set_state(s, SPRIXEL_INVALIDATED);
   return 1;
 }
 
@@ -419,7 +419,7 @@ int kitty_wipe_selfref(sprixel* s, int ycell, int xcell){
   if(kitty_blit_wipe_selfref(s, f, ycell, xcell)){
     return -1;
   }
-  s->invalidated = SPRIXEL_INVALIDATED;
+  sprixel_set_state(s, SPRIXEL_INVALIDATED);
   memcpy(auxvec, &state, sizeof(state));
   return 1;
 }
@@ -438,7 +438,7 @@ sprixel* kitty_recycle(ncplane* n){
 static inline uint8_t*
 kitty_auxiliary_vector(const sprixel* s){
   int pixels = ncplane_pile(s->n)->cellpxy * ncplane_pile(s->n)->cellpxx;
-  uint8_t* ret = malloc(sizeof(*ret) * pixels);
+  uint8_t* ret = tam_auxvec(s->n->tam, sizeof(*ret) * pixels);
   if(ret){
     memset(ret, 0, sizeof(*ret) * pixels);
   }
@@ -508,7 +508,7 @@ int kitty_wipe(sprixel* s, int ycell, int xcell){
 //fprintf(stderr, "CLEARED ROW, TARGY: %d\n", targy - 1);
         if(--targy == 0){
           s->n->tam[s->dimx * ycell + xcell].auxvector = auxvec;
-          s->invalidated = SPRIXEL_INVALIDATED;
+          sprixel_set_state(s, SPRIXEL_INVALIDATED);
           return 1;
         }
         thisrow = targx;
@@ -527,7 +527,7 @@ int kitty_wipe(sprixel* s, int ycell, int xcell){
     }
     ++c;
   }
-  free(auxvec);
+  tam_auxvec_free(s->n->tam, auxvec);
   return -1;
 }
 
@@ -543,7 +543,7 @@ int kitty_commit(fbuf* f, sprixel* s, unsigned noscroll){
   if(i < 0){
     return -1;
   }
-  s->invalidated = SPRIXEL_QUIESCENT;
+  sprixel_set_state(s, SPRIXEL_QUIESCENT);
   return 0;
 }
 
@@ -831,7 +831,7 @@ write_kitty_data(fbuf* f, int linesize, int leny, int lenx, int cols,
         if(x % cdimx == 0 && y % cdimy == 0){
           if(level == NCPIXEL_KITTY_ANIMATED){
             uint8_t* tmp;
-            tmp = kitty_anim_auxvec(leny, lenx, y, x, cdimy, cdimx,
+            tmp = kitty_anim_auxvec(tam, leny, lenx, y, x, cdimy, cdimx,
                                     data, linesize, tam[tyx].auxvector,
                                     transcolor);
             if(tmp == NULL){
@@ -841,7 +841,7 @@ write_kitty_data(fbuf* f, int linesize, int leny, int lenx, int cols,
             tam[tyx].auxvector = tmp;
           }else if(level == NCPIXEL_KITTY_SELFREF){
             if(tam[tyx].auxvector == NULL){
-              tam[tyx].auxvector = malloc(sizeof(tam[tyx].state));
+              tam[tyx].auxvector = tam_auxvec(tam, sizeof(tam[tyx].state));
               if(tam[tyx].auxvector == NULL){
                 logerror("got a NULL auxvec at %d", tyx);
                 goto err;
@@ -965,7 +965,7 @@ int kitty_rebuild_selfref(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
               xlen, ylen, s->id);
   const int tyx = xcell + ycell * s->dimx;
   memcpy(&s->n->tam[tyx].state, auxvec, sizeof(s->n->tam[tyx].state));
-  s->invalidated = SPRIXEL_INVALIDATED;
+  sprixel_set_state(s, SPRIXEL_INVALIDATED);
   return 0;
 }
 
@@ -1067,7 +1067,7 @@ int kitty_rebuild_animation(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
     }
   }
 //fprintf(stderr, "EMERGED WITH TAM STATE %d\n", s->n->tam[tyx].state);
-  s->invalidated = SPRIXEL_INVALIDATED;
+  sprixel_set_state(s, SPRIXEL_INVALIDATED);
   return 0;
 }
 #undef RGBA_MAXLEN
@@ -1135,6 +1135,16 @@ int kitty_remove(int id, fbuf* f){
   return 0;
 }
 
+// deletes the graphic's placements, but leaves its image data loaded, so
+// that it can be displayed again with kitty_commit().
+int kitty_unplace(int id, fbuf* f){
+  loginfo("unplacing graphic %u", id);
+  if(fbuf_printf(f, "\e_Ga=d,d=i,i=%d\e\\", id) < 0){
+    return -1;
+  }
+  return 0;
+}
+
 // damages cells underneath the graphic which were OPAQUE
 int kitty_scrub(const ncpile* p, sprixel* s){
 //fprintf(stderr, "FROM: %d/%d state: %d s->n: %p\n", s->movedfromy, s->movedfromx, s->invalidated, s->n);
@@ -1170,23 +1180,15 @@ int kitty_scrub(const ncpile* p, sprixel* s){
 int kitty_draw(const tinfo* ti, const ncpile* p, sprixel* s, fbuf* f,
                int yoff, int xoff){
   (void)ti;
-  (void)p;
   bool animated = false;
   if(s->animating){ // active animation
     s->animating = false;
     animated = true;
   }
-  int ret = s->glyph.used;
   logdebug("dumping %" PRIu64 "b for %u at %d %d", s->glyph.used, s->id, yoff, xoff);
-  if(ret){
-    if(fbuf_putn(f, s->glyph.buf, s->glyph.used) < 0){
-      ret = -1;
-    }
-  }
-  if(animated){
-    fbuf_free(&s->glyph);
-  }
-  s->invalidated = SPRIXEL_LOADED;
+  // an animation's glyph is only needed for this one draw, so hand it off
+  int ret = sprite_emit_glyph(p, f, &s->glyph, animated);
+  sprixel_set_state(s, SPRIXEL_LOADED);
   return ret;
 }
 
@@ -1202,7 +1204,7 @@ int kitty_move(sprixel* s, fbuf* f, unsigned noscroll, int yoff, int xoff){
                        noscroll ? ",C=1" : "") < 0){
     ret = -1;
   }
-  s->invalidated = SPRIXEL_QUIESCENT;
+  sprixel_set_state(s, SPRIXEL_QUIESCENT);
   return ret;
 }
 
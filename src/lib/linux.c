@@ -6,7 +6,7 @@
 static inline uint8_t*
 fbcon_auxiliary_vector(const sprixel* s){
   int pixels = ncplane_pile(s->n)->cellpxy * ncplane_pile(s->n)->cellpxx;
-  uint8_t* ret = malloc(sizeof(*ret) * pixels);
+  uint8_t* ret = tam_auxvec(s->n->tam, sizeof(*ret) * pixels);
   if(ret){
     memset(ret, 0, sizeof(*ret) * pixels);
   }
@@ -99,6 +99,7 @@ int fbcon_blit(struct ncplane* n, int linesize, const void* data,
     }
   }
   scrub_tam_boundaries(n->tam, leny, lenx, cdimy, cdimx);
+  s->fbdrawn = false; // every pixel might have changed
   if(plane_blit_sixel(s, &s->glyph, leny, lenx, 0, n->tam, SPRIXEL_INVALIDATED) < 0){
     goto error;
   }
@@ -157,31 +158,136 @@ int fbcon_rebuild(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
     }
   }
   s->n->tam[s->dimx * ycell + xcell].state = state;
-  s->invalidated = SPRIXEL_INVALIDATED;
+  sprixel_set_state(s, SPRIXEL_INVALIDATED);
+  sprixel_damage(s, ycell, xcell);
   return 1;
 }
 
+// write |count| glyph pixels (stored B, G, R, A) to the framebuffer at |dst|.
+// when the framebuffer shares our layout, this is a single memcpy().
+static inline void
+fbcon_put_span(const tinfo* ti, uint8_t* dst, const uint8_t* src, unsigned count){
+  if(ti->linux_fb_native){
+    memcpy(dst, src, count * 4);
+    return;
+  }
+  for(unsigned c = 0 ; c < count ; ++c){
+    uint32_t v = ((uint32_t)(src[2] >> (8 - ti->linux_fb_rlen)) << ti->linux_fb_roff) |
+                 ((uint32_t)(src[1] >> (8 - ti->linux_fb_glen)) << ti->linux_fb_goff) |
+                 ((uint32_t)(src[0] >> (8 - ti->linux_fb_blen)) << ti->linux_fb_boff);
+    for(unsigned b = 0 ; b < ti->linux_fb_bpp ; ++b){
+      *dst++ = v >> (b * 8);
+    }
+    src += 4;
+  }
+}
+
+// write only those of |count| glyph pixels which aren't transparent (alpha
+// below 192, as in rgba_trans_p()). the alphas are tested four at a time, so
+// runs of wholly opaque or wholly transparent pixels cost a single branch.
+// returns the number of pixels written.
+static unsigned
+fbcon_put_masked(const tinfo* ti, uint8_t* dst, const uint8_t* src, unsigned count){
+  const unsigned bpp = ti->linux_fb_bpp;
+  unsigned wrote = 0;
+  unsigned c = 0;
+  for( ; c + 4 <= count ; c += 4){
+    const uint32_t a = (uint32_t)src[3] | ((uint32_t)src[7] << 8u) |
+                       ((uint32_t)src[11] << 16u) | ((uint32_t)src[15] << 24u);
+    if((a & 0xc0c0c0c0u) == 0xc0c0c0c0u){
+      fbcon_put_span(ti, dst, src, 4);
+      wrote += 4;
+    }else if(a & (a << 1u) & 0x80808080u){
+      for(unsigned p = 0 ; p < 4 ; ++p){
+        if(src[p * 4 + 3] >= 192){
+          fbcon_put_span(ti, dst + p * bpp, src + p * 4, 1);
+          ++wrote;
+        }
+      }
+    }
+    src += 16;
+    dst += 4 * bpp;
+  }
+  for( ; c < count ; ++c){
+    if(src[3] >= 192){
+      fbcon_put_span(ti, dst, src, 1);
+      ++wrote;
+    }
+    src += 4;
+    dst += bpp;
+  }
+  return wrote;
+}
+
+// if we're still where we were last drawn, only the cells in the damage
+// rectangle are redrawn (often none of them). otherwise, we draw the whole
+// sprixel. OPAQUE cells are copied a row at a time (merging horizontally
+// adjacent OPAQUE cells into one copy); MIXED cells test each pixel; other
+// cells are skipped, as they have nothing to draw.
 int fbcon_draw(const tinfo* ti, sprixel* s, int y, int x){
   logdebug("id %" PRIu32 " dest %d/%d", s->id, y, x);
   int wrote = 0;
   const int cellpxy = ncplane_pile(s->n) ? ncplane_pile(s->n)->cellpxy : ti->cellpxy;
   const int cellpxx = ncplane_pile(s->n) ? ncplane_pile(s->n)->cellpxx : ti->cellpxx;
-  for(unsigned l = 0 ; l < (unsigned)s->pixy && l + y * cellpxy < ti->pixy ; ++l){
-    // FIXME pixel size isn't necessarily 4B, line isn't necessarily psize*pixx
-    size_t offset = ((l + y * cellpxy) * ti->pixx + x * cellpxx) * 4;
-    uint8_t* tl = ti->linux_fbuffer + offset;
-    const char* src = (char*)s->glyph.buf + (l * s->pixx * 4);
-    for(unsigned c = 0 ; c < (unsigned)s->pixx && c < ti->pixx ; ++c){
-      uint32_t pixel;
-      memcpy(&pixel, src, 4);
-      if(!rgba_trans_p(pixel, 0)){
-        memcpy(tl, &pixel, 4);
-        wrote += 4;
+  const tament* tam = s->n ? s->n->tam : NULL;
+  unsigned y0 = 0, x0 = 0, y1 = s->dimy, x1 = s->dimx;
+  if(s->fbdrawn && s->invalidated != SPRIXEL_UNSEEN &&
+     s->fbdrawny == y && s->fbdrawnx == x){
+    if(s->dmgy0 >= s->dmgy1){
+      return 0;
+    }
+    y0 = s->dmgy0;
+    y1 = s->dmgy1 < s->dimy ? s->dmgy1 : s->dimy;
+    x0 = s->dmgx0;
+    x1 = s->dmgx1 < s->dimx ? s->dmgx1 : s->dimx;
+  }
+  const unsigned bpp = ti->linux_fb_bpp;
+  for(unsigned l = y0 * cellpxy ; l < y1 * cellpxy && l < (unsigned)s->pixy ; ++l){
+    const unsigned fby = l + y * cellpxy;
+    if(fby >= ti->pixy){
+      break;
+    }
+    uint8_t* tl = ti->linux_fbuffer + fby * ti->linux_fb_stride;
+    const uint8_t* src = (const uint8_t*)s->glyph.buf + l * s->pixx * 4;
+    const unsigned ycell = l / cellpxy;
+    unsigned xcell = x0;
+    while(xcell < x1){
+      const unsigned pxstart = xcell * cellpxx;
+      const unsigned fbx = pxstart + x * cellpxx;
+      if(pxstart >= (unsigned)s->pixx || fbx >= ti->pixx){
+        break;
       }
-      src += 4;
-      tl += 4;
+      sprixcell_e state = tam ? tam[ycell * s->dimx + xcell].state : SPRIXCELL_MIXED_SIXEL;
+      unsigned cells = 1;
+      if(state == SPRIXCELL_OPAQUE_SIXEL || state == SPRIXCELL_OPAQUE_KITTY){
+        while(xcell + cells < x1 &&
+              (tam[ycell * s->dimx + xcell + cells].state == SPRIXCELL_OPAQUE_SIXEL ||
+               tam[ycell * s->dimx + xcell + cells].state == SPRIXCELL_OPAQUE_KITTY)){
+          ++cells;
+        }
+      }
+      unsigned count = cells * cellpxx;
+      if(pxstart + count > (unsigned)s->pixx){
+        count = s->pixx - pxstart;
+      }
+      if(fbx + count > ti->pixx){
+        count = ti->pixx - fbx;
+      }
+      if(state == SPRIXCELL_OPAQUE_SIXEL || state == SPRIXCELL_OPAQUE_KITTY){
+        fbcon_put_span(ti, tl + fbx * bpp, src + pxstart * 4, count);
+        wrote += count * 4;
+      }else if(state == SPRIXCELL_MIXED_SIXEL || state == SPRIXCELL_MIXED_KITTY){
+        wrote += fbcon_put_masked(ti, tl + fbx * bpp, src + pxstart * 4, count) * 4;
+      }
+      xcell += cells;
     }
   }
+  s->fbdrawn = true;
+  s->fbdrawny = y;
+  s->fbdrawnx = x;
+  s->dmgy0 = s->dmgy1 = 0;
+  s->dmgx0 = s->dmgx1 = 0;
+  sprixel_set_state(s, SPRIXEL_QUIESCENT);
   return wrote;
 }
 
@@ -191,6 +297,9 @@ int fbcon_draw(const tinfo* ti, sprixel* s, int y, int x){
 // we're *clearing* N rows at the bottom. every pixel is written to once, and
 // they're written in order. if we're scrolling all rows, we're clearing the
 // entire space; we always clear something (we might not always move anything).
+// only the columns covered by the pile are touched. sprixels move along with
+// the pixels, so any drawn sprixel remaining wholly on-screen needn't be
+// redrawn; others must be drawn in full.
 void fbcon_scroll(const struct ncpile* p, tinfo* ti, int rows){
   const int cellpxy = p->cellpxy;
   const int cellpxx = p->cellpxx;
@@ -198,21 +307,48 @@ void fbcon_scroll(const struct ncpile* p, tinfo* ti, int rows){
     return;
   }
   logdebug("scrolling %d", rows);
-  const int rowbytes = cellpxx * p->dimx * 4;
-  const int totalrows = cellpxy * p->dimy;
-  int srows = rows * cellpxy; // number of pixel rows being scrolled
+  size_t rowbytes = cellpxx * p->dimx * ti->linux_fb_bpp;
+  if(rowbytes > ti->linux_fb_stride){
+    rowbytes = ti->linux_fb_stride;
+  }
+  unsigned totalrows = cellpxy * p->dimy;
+  if(totalrows > ti->pixy){
+    totalrows = ti->pixy;
+  }
+  unsigned srows = rows * cellpxy; // number of rows being scrolled
   if(srows > totalrows){
     srows = totalrows;
   }
+  const size_t stride = ti->linux_fb_stride;
   // srows is the number of rows we're *losing*
   uint8_t* targ = ti->linux_fbuffer;
-  uint8_t* src = ti->linux_fbuffer + srows * rowbytes;
-  unsigned tocopy = rowbytes * (totalrows - srows);
-  if(tocopy){
-    memmove(targ, src, tocopy);
+  const uint8_t* src = ti->linux_fbuffer + srows * stride;
+  if(rowbytes == stride){
+    const size_t tocopy = stride * (totalrows - srows);
+    if(tocopy){
+      memmove(targ, src, tocopy);
+    }
+    memset(targ + tocopy, 0, srows * stride);
+  }else{
+    for(unsigned l = 0 ; l < totalrows - srows ; ++l){
+      memcpy(targ + l * stride, src + l * stride, rowbytes);
+    }
+    for(unsigned l = totalrows - srows ; l < totalrows ; ++l){
+      memset(targ + l * stride, 0, rowbytes);
+    }
+  }
+  for(sprixel* s = p->sprixelcache ; s ; s = s->next){
+    if(s->fbdrawn){
+      if(s->fbdrawny < rows || (s->fbdrawny + s->dimy) * cellpxy > totalrows){
+        s->fbdrawn = false;
+        if(s->invalidated == SPRIXEL_QUIESCENT){
+          sprixel_set_state(s, SPRIXEL_INVALIDATED);
+        }
+      }else{
+        s->fbdrawny -= rows;
+      }
+    }
   }
-  targ += tocopy;
-  memset(targ, 0, (totalrows * rowbytes) - tocopy);
 }
 
 // each row is a contiguous set of bits, starting at the msb
@@ -740,10 +876,40 @@ int get_linux_fb_pixelgeom(tinfo* ti, unsigned* ypix, unsigned *xpix){
              ti->linux_fb_fd, strerror(errno));
     return -1;
   }
-  loginfo("linux %s geometry: %dx%d", ti->linux_fb_dev, fbi.yres, fbi.xres);
+  struct fb_fix_screeninfo ffi = {0};
+  if(ioctl(ti->linux_fb_fd, FBIOGET_FSCREENINFO, &ffi)){
+    logerror("no fixed framebuffer info from %s %d (%s?)", ti->linux_fb_dev,
+             ti->linux_fb_fd, strerror(errno));
+    return -1;
+  }
+  loginfo("linux %s geometry: %dx%d %dbpp stride %u", ti->linux_fb_dev,
+          fbi.yres, fbi.xres, fbi.bits_per_pixel, ffi.line_length);
+  if(fbi.bits_per_pixel % 8 || fbi.bits_per_pixel < 16 || fbi.bits_per_pixel > 32 ||
+     fbi.red.length > 8 || fbi.green.length > 8 || fbi.blue.length > 8 ||
+     fbi.red.offset + fbi.red.length > fbi.bits_per_pixel ||
+     fbi.green.offset + fbi.green.length > fbi.bits_per_pixel ||
+     fbi.blue.offset + fbi.blue.length > fbi.bits_per_pixel){
+    logerror("unsupported pixel format on %s (%dbpp)", ti->linux_fb_dev, fbi.bits_per_pixel);
+    return -1;
+  }
+  ti->linux_fb_bpp = fbi.bits_per_pixel / 8;
+  ti->linux_fb_stride = ffi.line_length;
+  if(ti->linux_fb_stride < fbi.xres * ti->linux_fb_bpp){
+    ti->linux_fb_stride = fbi.xres * ti->linux_fb_bpp;
+  }
+  ti->linux_fb_roff = fbi.red.offset;
+  ti->linux_fb_goff = fbi.green.offset;
+  ti->linux_fb_boff = fbi.blue.offset;
+  ti->linux_fb_rlen = fbi.red.length;
+  ti->linux_fb_glen = fbi.green.length;
+  ti->linux_fb_blen = fbi.blue.length;
+  ti->linux_fb_native = ti->linux_fb_bpp == 4 &&
+                        fbi.red.offset == 16 && fbi.red.length == 8 &&
+                        fbi.green.offset == 8 && fbi.green.length == 8 &&
+                        fbi.blue.offset == 0 && fbi.blue.length == 8;
   *ypix = fbi.yres;
   *xpix = fbi.xres;
-  size_t len = *ypix * *xpix * fbi.bits_per_pixel / 8;
+  size_t len = ti->linux_fb_stride * *ypix;
   if(ti->linux_fb_len != len){
     if(ti->linux_fbuffer != MAP_FAILED){
       munmap(ti->linux_fbuffer, ti->linux_fb_len);
@@ -129,7 +129,8 @@ notcurses_stop_minimal(void* vnc){
   // be sure to write the restoration sequences *prior* to running rmcup, as
   // they apply to the screen (alternate or otherwise) we're actually using.
   const char* esc;
-  ret |= reset_term_palette(&nc->tcache, f, nc->touched_palette);
+  ret |= reset_term_palette(&nc->tcache, f, nc->touched_palette ||
+                            (nc->dynpal && nc->dynpal->lowreg < 256));
   ret |= reset_term_attributes(&nc->tcache, f);
   if((esc = get_escape(&nc->tcache, ESCAPE_RMKX)) && fbuf_emit(f, esc)){
     ret = -1;
@@ -239,7 +240,7 @@ char* ncplane_at_yx(const ncplane* n, int y, int x, uint16_t* stylemask, uint64_
     }
     return strdup(n->sprite->glyph.buf);
   }
-  const nccell* yx = &n->fb[nfbcellidx(n, y, x)];
+  const nccell* yx = ncplane_cell_peek_yx(n, y, x);
   // if we're the right side of a wide glyph, we return the main glyph
   if(nccell_wide_right_p(yx)){
     return ncplane_at_yx(n, y, x - 1, stylemask, channels);
@@ -290,7 +291,7 @@ int ncplane_at_yx_cell(ncplane* n, int y, int x, nccell* c){
     logerror("invalid coordinates: %d/%d", y, x);
     return -1;
   }
-  nccell* targ = ncplane_cell_ref_yx(n, y, x);
+  const nccell* targ = ncplane_cell_peek_yx(n, y, x);
   if(nccell_duplicate(n, c, targ)){
     return -1;
   }
@@ -449,13 +450,53 @@ free_sprixels(ncpile* n){
   }
 }
 
+// a hidden pile might have left graphics loaded in the terminal: those with no
+// glyph to retransmit (which are only ever unplaced), and with
+// NCOPTION_RETAIN_PILE_BITMAPS, those which were parked, including any hidden
+// since. nothing will ever show them again, so queue their deletion for the
+// start of the next frame. we can't write to the terminal here, lest we race
+// against a rasterization.
+static void
+unpark_sprixels(ncpile* pile){
+  notcurses* nc = pile->nc;
+  if(nc->last_pile == pile || !nc->tcache.pixel_remove){
+    return;
+  }
+  const bool retain = nc->flags & NCOPTION_RETAIN_PILE_BITMAPS;
+  for(sprixel* s = pile->sprixelcache ; s ; s = s->next){
+    if(s->invalidated == SPRIXEL_UNSEEN){
+      continue;
+    }
+    if(s->glyph.used && !(retain && (s->invalidated == SPRIXEL_LOADED ||
+                                     s->invalidated == SPRIXEL_HIDE))){
+      continue;
+    }
+    if(nc->orphancount == nc->orphancap){
+      unsigned cap = nc->orphancap ? nc->orphancap * 2 : 16;
+      uint32_t* tmp = realloc(nc->orphans, sizeof(*tmp) * cap);
+      if(tmp == NULL){
+        logerror("couldn't queue deletion of bitmap %u", s->id);
+        continue;
+      }
+      nc->orphans = tmp;
+      nc->orphancap = cap;
+    }
+    nc->orphans[nc->orphancount++] = s->id;
+  }
+}
+
 // destroy an empty ncpile. only call with pilelock held.
 static void
 ncpile_destroy(ncpile* pile){
   if(pile){
     pile->prev->next = pile->next;
     pile->next->prev = pile->prev;
+    unpark_sprixels(pile);
+    if(pile->nc->last_pile == pile){
+      pile->nc->last_pile = NULL;
+    }
     free_sprixels(pile);
+    ncpile_arena_release(pile);
     free(pile->crender);
     free(pile);
   }
@@ -463,17 +504,21 @@ ncpile_destroy(ncpile* pile){
 
 void free_plane(ncplane* p){
   if(p){
+    // where we'll return our framebuffer and struct. a widget destructor
+    // might destroy the rest of our pile, so don't recycle widget planes.
+    ncpile* arena = p->widget ? NULL : ncplane_pile(p);
     // ncdirect fakes an ncplane with no ->pile
     if(ncplane_pile(p)){
       notcurses* nc = ncplane_notcurses(p);
       pthread_mutex_lock(&nc->stats.lock);
         --ncplane_notcurses(p)->stats.s.planes;
-        ncplane_notcurses(p)->stats.s.fbbytes -= sizeof(*p->fb) * p->leny * p->lenx;
+        ncplane_notcurses(p)->stats.s.fbbytes -= ncplane_cellbytes(p) * p->leny * p->lenx;
       pthread_mutex_unlock(&nc->stats.lock);
       if(p->above == NULL && p->below == NULL){
         pthread_mutex_lock(&nc->pilelock);
           ncpile_destroy(ncplane_pile(p));
         pthread_mutex_unlock(&nc->pilelock);
+        arena = NULL;
       }
     }
     if(p->widget){
@@ -491,8 +536,10 @@ void free_plane(ncplane* p){
     destroy_tam(p);
     egcpool_dump(&p->pool);
     free(p->name);
-    free(p->fb);
-    free(p);
+    ncplane_compact_free(p);
+    ncscrollback_destroy(p->scrollback);
+    ncpile_fb_free(arena, p->fb, (size_t)p->leny * p->lenx);
+    ncpile_plane_free(arena, p);
   }
 }
 
@@ -526,7 +573,15 @@ make_ncpile(notcurses* nc, ncplane* n){
     ret->crender = NULL;
     ret->crenderlen = 0;
     ret->sprixelcache = NULL;
+    ret->sprixelwork = NULL;
+    ret->sprixelcount = 0;
     ret->scrolls = 0;
+    ret->shells = NULL;
+    ret->shellcount = 0;
+    memset(ret->fbfree, 0, sizeof(ret->fbfree));
+    memset(ret->fbcount, 0, sizeof(ret->fbcount));
+    ret->parkedbytes = 0;
+    ret->lastshown = 0;
   }
   n->pile = ret;
   return ret;
@@ -570,7 +625,7 @@ static inline size_t  ncplane_sizeof_cellarray( unsigned rows, unsigned cols)
 // (as once more is n).
 ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
                               const ncplane_options* nopts){
-  if(nopts->flags >= (NCPLANE_OPTION_FIXED << 1u)){
+  if(nopts->flags >= (NCPLANE_OPTION_COMPACT << 1u)){
     logwarn("provided unsupported flags %016" PRIx64, nopts->flags);
   }
   if(nopts->flags & NCPLANE_OPTION_HORALIGNED || nopts->flags & NCPLANE_OPTION_VERALIGNED){
@@ -586,13 +641,16 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
       return NULL;
     }
   }
-  ncplane* p = malloc(sizeof(*p));
+  // child planes can reuse a shell and framebuffer from their pile
+  ncpile* arena = n ? ncplane_pile(n) : NULL;
+  ncplane* p = ncpile_plane_alloc(arena);
   if(p == NULL){
     return NULL;
   }
   p->scrolling = nopts->flags & NCPLANE_OPTION_VSCROLL;
   p->fixedbound = nopts->flags & NCPLANE_OPTION_FIXED;
   p->autogrow = nopts->flags & NCPLANE_OPTION_AUTOGROW;
+  p->lowpriority = nopts->flags & NCPLANE_OPTION_LOWPRIORITY;
   p->widget = NULL;
   p->wdestruct = NULL;
   if(nopts->flags & NCPLANE_OPTION_MARGINALIZED){
@@ -616,11 +674,25 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
   }
 
   size_t fbsize = ncplane_sizeof_cellarray( p->leny, p->lenx);
-  if( ! fbsize || (p->fb = calloc(1,fbsize)) == NULL){
-    logerror("error allocating cellmatrix (r=%u, c=%u)",
-             p->leny, p->lenx);
-    free(p);
-    return NULL;
+  p->compact = NULL;
+  p->scrollback = NULL;
+  if(nopts->flags & NCPLANE_OPTION_COMPACT){
+    p->fb = NULL;
+    if( ! fbsize || ncplane_compact_init(p)){
+      logerror("error allocating compact cellmatrix (r=%u, c=%u)",
+               p->leny, p->lenx);
+      free(p);
+      return NULL;
+    }
+    fbsize = fbsize / sizeof(nccell) * sizeof(nccompact);
+  }else{
+    if( ! fbsize || (p->fb = ncpile_fb_alloc(arena, fbsize / sizeof(nccell))) == NULL){
+      logerror("error allocating cellmatrix (r=%u, c=%u)",
+               p->leny, p->lenx);
+      free(p);
+      return NULL;
+    }
+    memset(p->fb, 0, fbsize);
   }
   p->x = p->y = 0;
   p->logrow = 0;
@@ -784,7 +856,7 @@ ncplane* ncplane_dup(const ncplane* n, void* opaque){
     .userptr = opaque,
     .name = n->name,
     .resizecb = ncplane_resizecb(n),
-    .flags = 0,
+    .flags = n->compact ? NCPLANE_OPTION_COMPACT : 0,
   };
   ncplane* newn = ncplane_create(n->boundto, &nopts);
   if(newn == NULL){
@@ -796,7 +868,15 @@ ncplane* ncplane_dup(const ncplane* n, void* opaque){
     ncplane_destroy(newn);
     return NULL;
   }
-  memmove(newn->fb, n->fb, fbsize);
+  if(n->compact || newn->compact){
+    for(int y = 0 ; y < dimy ; ++y){
+      for(int x = 0 ; x < dimx ; ++x){
+        *ncplane_cell_ref_yx(newn, y, x) = *ncplane_cell_peek_yx(n, y, x);
+      }
+    }
+  }else{
+    memmove(newn->fb, n->fb, fbsize);
+  }
   // don't use ncplane_cursor_move_yx() here; the cursor could be in an
   // invalid location, which will be disallowed, failing out.
   newn->y = n->y;
@@ -883,10 +963,38 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx,
   if(n->sprite){
     sprixel_hide(n->sprite);
   }
+  // compact planes are resized in compact form (they can't hold sprixels, so
+  // there's no TAM to worry about), unless writing back the hot row forced
+  // a full framebuffer upon us.
+  ncplane_compact_flush(n);
+  if(n->compact){
+    if(ncplane_compact_resize(n, keepy, keepx, keepleny, keeplenx,
+                              yoff, xoff, ylen, xlen)){
+      return -1;
+    }
+    if(n->y >= ylen){
+      n->y = ylen - 1;
+    }
+    if(n->x >= xlen){
+      n->x = xlen - 1;
+    }
+    pthread_mutex_lock(&nc->stats.lock);
+      nc->stats.s.fbbytes -= sizeof(nccompact) * (rows * cols);
+      nc->stats.s.fbbytes += sizeof(nccompact) * ylen * xlen;
+    pthread_mutex_unlock(&nc->stats.lock);
+    n->absy += keepy + yoff;
+    n->absx += keepx + xoff;
+    const bool resized = n->lenx != xlen || n->leny != ylen;
+    n->lenx = xlen;
+    n->leny = ylen;
+    if(!resized){
+      return 0;
+    }
+    return resize_callbacks_children(n);
+  }
   // we're good to resize. we'll need alloc up a new framebuffer, and copy in
   // those elements we're retaining, zeroing out the rest. alternatively, if
   // we've shrunk, we will be filling the new structure.
-  int oldarea = rows * cols;
   int keptarea = keepleny * keeplenx;
   int newarea = ylen * xlen;
   size_t fbsize = sizeof(nccell) * newarea;
@@ -919,29 +1027,26 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx,
         }
       }
     }
-    if((fb = realloc(n->fb, fbsize)) == NULL){
+    if((fb = ncpile_fb_realloc(ncplane_pile(n), n->fb, (size_t)rows * cols,
+                               newarea)) == NULL){
       return -1;
     }
     preserved = NULL;
   }else{
-    if((fb = malloc(fbsize)) == NULL){
+    if((fb = ncpile_fb_alloc(ncplane_pile(n), newarea)) == NULL){
       return -1;
     }
   }
   if(n->tam){
     loginfo("tam realloc to %d entries", newarea);
-    // FIXME first, free any disposed auxiliary vectors!
-    tament* tmptam = realloc(n->tam, sizeof(*tmptam) * newarea);
+    tament* tmptam = resize_tam(n->tam, newarea);
     if(tmptam == NULL){
       if(preserved){
-        free(fb);
+        ncpile_fb_free(ncplane_pile(n), fb, newarea);
       }
       return -1;
     }
     n->tam = tmptam;
-    if(newarea > oldarea){
-      memset(n->tam + oldarea, 0, sizeof(*n->tam) * (newarea - oldarea));
-    }
   }
   // update the cursor, if it would otherwise be off-plane
   if(n->y >= ylen){
@@ -1010,10 +1115,15 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx,
       }
     }
   }
+  const bool resized = n->lenx != xlen || n->leny != ylen;
   n->fb = fb;
   n->lenx = xlen;
   n->leny = ylen;
-  free(preserved);
+  ncpile_fb_free(ncplane_pile(n), preserved, (size_t)rows * cols);
+  // children are placed relative to us, so they needn't hear about a move
+  if(!resized){
+    return 0;
+  }
   return resize_callbacks_children(n);
 }
 
@@ -1192,7 +1302,7 @@ notcurses_early_init(const struct notcurses_options* opts, FILE* fp, unsigned* u
   }
   memset(ret, 0, sizeof(*ret));
   if(opts){
-    if(opts->flags >= (NCOPTION_SCROLLING << 1u)){
+    if(opts->flags >= (NCOPTION_RETAIN_PILE_BITMAPS << 1u)){
       fprintf(stderr, "warning: unknown Notcurses options %016" PRIu64, opts->flags);
     }
     if(opts->termtype){
@@ -1247,6 +1357,12 @@ notcurses_early_init(const struct notcurses_options* opts, FILE* fp, unsigned* u
     free(ret);
     return NULL;
   }
+  if(pthread_mutex_init(&ret->sinklock, NULL)){
+    pthread_mutex_destroy(&ret->stats.lock);
+    pthread_mutex_destroy(&ret->pilelock);
+    free(ret);
+    return NULL;
+  }
   if(utf8){
     ncmetric_use_utf8();
   }
@@ -1268,6 +1384,7 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
   if(fbuf_init(&ret->rstate.f)){
     pthread_mutex_destroy(&ret->pilelock);
     pthread_mutex_destroy(&ret->stats.lock);
+    pthread_mutex_destroy(&ret->sinklock);
     free(ret);
     return NULL;
   }
@@ -1277,6 +1394,7 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
     fbuf_free(&ret->rstate.f);
     pthread_mutex_destroy(&ret->pilelock);
     pthread_mutex_destroy(&ret->stats.lock);
+    pthread_mutex_destroy(&ret->sinklock);
     free(ret);
     return NULL;
   }
@@ -1298,10 +1416,12 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
                           cursory, cursorx, &ret->stats,
                           ret->margin_l, ret->margin_t,
                           ret->margin_r, ret->margin_b,
-                          ret->flags & NCOPTION_DRAIN_INPUT)){
+                          ret->flags & NCOPTION_DRAIN_INPUT,
+                          ret->flags & NCOPTION_COALESCE_INPUT)){
     fbuf_free(&ret->rstate.f);
     pthread_mutex_destroy(&ret->pilelock);
     pthread_mutex_destroy(&ret->stats.lock);
+    pthread_mutex_destroy(&ret->sinklock);
     drop_signals(ret);
     free(ret);
     return NULL;
@@ -1411,6 +1531,7 @@ err:
   del_curterm(cur_term);
   pthread_mutex_destroy(&ret->stats.lock);
   pthread_mutex_destroy(&ret->pilelock);
+  pthread_mutex_destroy(&ret->sinklock);
   free(ret);
   return NULL;
 }
@@ -1458,6 +1579,7 @@ int notcurses_stop(notcurses* nc){
 //notcurses_debug(nc, stderr);
   int ret = 0;
   if(nc){
+    ret |= ncsinks_destroy(nc);
     ret |= notcurses_stop_minimal(nc);
     // if we were not using the alternate screen, our cursor's wherever we last
     // wrote. move it to the furthest place to which it advanced.
@@ -1477,6 +1599,7 @@ int notcurses_stop(notcurses* nc){
     }
     egcpool_dump(&nc->pool);
     free(nc->lastframe);
+    free(nc->fidelity);
     free_terminfo_cache(&nc->tcache);
     // get any current stats loaded into stash_stats
     notcurses_stats_reset(nc, NULL);
@@ -1488,7 +1611,12 @@ int notcurses_stop(notcurses* nc){
 #endif
     ret |= pthread_mutex_destroy(&nc->stats.lock);
     ret |= pthread_mutex_destroy(&nc->pilelock);
+    ret |= pthread_mutex_destroy(&nc->sinklock);
     fbuf_free(&nc->rstate.f);
+    free(nc->rstate.deferred);
+    free(nc->rstate.splices);
+    free(nc->dynpal);
+    free(nc->orphans);
     free(nc);
   }
   return ret;
@@ -1760,6 +1888,71 @@ nccell_obliterate(ncplane* n, nccell* c){
   nccell_init(c);
 }
 
+// discard the top |r| rows of |n| (which must be at least 1), rotating the
+// framebuffer up by |r|. the departing rows are saved to any scrollback, and
+// the rows brought in at the bottom are cleared. non-fixed bound planes which
+// intersect |n| move up alongside it, until they no longer intersect.
+static void
+scroll_rows(ncplane* n, unsigned r){
+  // if this is the standard plane, that means "physical" scroll events are
+  // called for.
+  if(n == notcurses_stdplane(ncplane_notcurses(n))){
+    ncplane_pile(n)->scrolls += r;
+  }
+  // past the plane's height, we're only scrolling in blank rows
+  const unsigned clear = r > n->leny ? n->leny : r;
+  // the top rows are about to be lost; preserve them if we're keeping history
+  if(n->scrollback){
+    for(unsigned y = 0 ; y < clear ; ++y){
+      if(ncscrollback_push(n, y)){
+        logwarn("couldn't save row to scrollback");
+      }
+    }
+  }
+  const unsigned vtop = n->logrow;
+  n->logrow = (n->logrow + r % n->leny) % n->leny;
+  // the discarded rows become the new bottom rows. if nothing references the
+  // EGCpool, every cell is inline, and they needn't be released one by one.
+  const bool inline_only = !n->pool.poolused;
+  for(unsigned i = 0 ; i < clear ; ++i){
+    const unsigned vrow = (vtop + i) % n->leny;
+    if(n->compact){
+      ncplane_compact_clear_row(n, vrow);
+    }else{
+      nccell* row = n->fb + fbcellidx(vrow, n->lenx, 0);
+      if(!inline_only){
+        for(unsigned clearx = 0 ; clearx < n->lenx ; ++clearx){
+          nccell_release(n, &row[clearx]);
+        }
+      }
+      memset(row, 0, sizeof(*row) * n->lenx);
+    }
+  }
+  if(n->scrollback){
+    for(unsigned y = clear ; y < r ; ++y){
+      if(ncscrollback_push(n, 0)){
+        logwarn("couldn't save row to scrollback");
+      }
+    }
+  }
+  // a child moves once per scroll while it intersects us. moving up doesn't
+  // change horizontal overlap, so it stops once its bottom clears our top.
+  if(n->blist){
+    int ny = ncplane_abs_y(n);
+    for(struct ncplane* c = n->blist ; c ; c = c->bnext){
+      if(!c->fixedbound){
+        if(ncplanes_intersect_p(n, c)){
+          unsigned moves = ncplane_abs_y(c) + ncplane_dim_y(c) - ny;
+          if(moves > r){
+            moves = r;
+          }
+          ncplane_move_rel(c, -(int)moves, 0);
+        }
+      }
+    }
+  }
+}
+
 // increment y by 1 and rotate the framebuffer up one line. x moves to 0. any
 // non-fixed bound planes move up 1 line if they intersect the plane.
 void scroll_down(ncplane* n){
@@ -1773,29 +1966,14 @@ void scroll_down(ncplane* n){
       return;
     }
     // we'll actually be scrolling material up and out, and making a new line.
-    // if this is the standard plane, that means a "physical" scroll event is
-    // called for.
-    if(n == notcurses_stdplane(ncplane_notcurses(n))){
-      ncplane_pile(n)->scrolls++;
-    }
-    n->logrow = (n->logrow + 1) % n->leny;
-    nccell* row = n->fb + nfbcellidx(n, n->y, 0);
-    for(unsigned clearx = 0 ; clearx < n->lenx ; ++clearx){
-      nccell_release(n, &row[clearx]);
-    }
-    memset(row, 0, sizeof(*row) * n->lenx);
-    for(struct ncplane* c = n->blist ; c ; c = c->bnext){
-      if(!c->fixedbound){
-        if(ncplanes_intersect_p(n, c)){
-          ncplane_move_rel(c, -1, 0);
-        }
-      }
-    }
+    scroll_rows(n, 1);
   }else{
     ++n->y;
   }
 }
 
+// equivalent to calling scroll_down() |r| times, but rotates the framebuffer
+// and moves bound planes only once.
 int ncplane_scrollup(ncplane* n, int r){
   if(!ncplane_scrolling_p(n)){
     logerror("can't scroll %d on non-scrolling plane", r);
@@ -1805,8 +1983,22 @@ int ncplane_scrollup(ncplane* n, int r){
     logerror("can't scroll %d lines", r);
     return -1;
   }
-  while(r-- > 0){
-    scroll_down(n);
+  if(r > 0){
+    n->x = 0;
+    // first the cursor moves down to the last line
+    const unsigned descend = n->leny - 1 - n->y;
+    if((unsigned)r <= descend){
+      n->y += r;
+    }else{
+      n->y = n->leny - 1;
+      r -= descend;
+      if(n->autogrow){
+        ncplane_resize_simple(n, n->leny + r, n->lenx);
+        ncplane_cursor_move_yx(n, n->leny - 1, 0);
+      }else{
+        scroll_rows(n, r);
+      }
+    }
   }
   if(n == notcurses_stdplane(ncplane_notcurses(n))){
     notcurses_render(ncplane_notcurses(n));
@@ -1919,7 +2111,7 @@ ncplane_put(ncplane* n, int y, int x, const char* egc, int cols,
   int idx = n->x;
   nccell* lmc = targ;
   while(nccell_wide_right_p(lmc)){
-    nccell_obliterate(n, &n->fb[nfbcellidx(n, n->y, idx)]);
+    nccell_obliterate(n, ncplane_cell_ref_yx(n, n->y, idx));
     lmc = ncplane_cell_ref_yx(n, n->y, --idx);
   }
   // we're now on the leftmost cell of the target glyph.
@@ -1927,7 +2119,7 @@ ncplane_put(ncplane* n, int y, int x, const char* egc, int cols,
   nccell_release(n, lmc);
   twidth -= n->x - idx;
   while(--twidth > 0){
-    nccell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x + twidth)]);
+    nccell_obliterate(n, ncplane_cell_ref_yx(n, n->y, n->x + twidth));
   }
   targ->stylemask = stylemask;
   targ->channels = channels;
@@ -1958,11 +2150,11 @@ ncplane_put(ncplane* n, int y, int x, const char* egc, int cols,
     ++n->x;
     // if wide, set our right hand columns wide, and check for further damage
     for(int i = 1 ; i < cols ; ++i){
-      nccell* candidate = &n->fb[nfbcellidx(n, n->y, n->x)];
+      nccell* candidate = ncplane_cell_ref_yx(n, n->y, n->x);
       int off = nccell_cols(candidate);
-      nccell_release(n, &n->fb[nfbcellidx(n, n->y, n->x)]);
+      nccell_release(n, ncplane_cell_ref_yx(n, n->y, n->x));
       while(--off > 0){
-        nccell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x + off)]);
+        nccell_obliterate(n, ncplane_cell_ref_yx(n, n->y, n->x + off));
       }
       if(*egc != '\t'){
         candidate->channels = targ->channels;
@@ -1984,6 +2176,17 @@ ncplane_put(ncplane* n, int y, int x, const char* egc, int cols,
   return cols;
 }
 
+int ncplane_putascii(ncplane* n, const char* s, size_t len){
+  int ret = 0;
+  for(size_t i = 0 ; i < len ; ++i){
+    if(ncplane_put(n, -1, -1, s + i, 1, n->stylemask, n->channels, 1) < 0){
+      return -ret;
+    }
+    ++ret;
+  }
+  return ret;
+}
+
 int ncplane_putc_yx(ncplane* n, int y, int x, const nccell* c){
   const int cols = nccell_cols(c);
   // unfortunately, |c| comes from |n|. the act of writing |c| to |n| could
@@ -2015,7 +2218,7 @@ int ncplane_putegc_yx(ncplane* n, int y, int x, const char* gclust, size_t* sbyt
 int ncplane_putchar_stained(ncplane* n, char c){
   uint64_t channels = n->channels;
   uint16_t stylemask = n->stylemask;
-  const nccell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const nccell* targ = ncplane_cell_peek_yx(n, n->y, n->x);
   n->channels = targ->channels;
   n->stylemask = targ->stylemask;
   int ret = ncplane_putchar(n, c);
@@ -2027,7 +2230,7 @@ int ncplane_putchar_stained(ncplane* n, char c){
 int ncplane_putwegc_stained(ncplane* n, const wchar_t* gclust, size_t* sbytes){
   uint64_t channels = n->channels;
   uint16_t stylemask = n->stylemask;
-  const nccell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const nccell* targ = ncplane_cell_peek_yx(n, n->y, n->x);
   n->channels = targ->channels;
   n->stylemask = targ->stylemask;
   int ret = ncplane_putwegc(n, gclust, sbytes);
@@ -2039,7 +2242,7 @@ int ncplane_putwegc_stained(ncplane* n, const wchar_t* gclust, size_t* sbytes){
 int ncplane_putegc_stained(ncplane* n, const char* gclust, size_t* sbytes){
   uint64_t channels = n->channels;
   uint16_t stylemask = n->stylemask;
-  const nccell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const nccell* targ = ncplane_cell_peek_yx(n, n->y, n->x);
   n->channels = targ->channels;
   n->stylemask = targ->stylemask;
   int ret = ncplane_putegc(n, gclust, sbytes);
@@ -2052,7 +2255,7 @@ int ncplane_cursor_at(const ncplane* n, nccell* c, char** gclust){
   if(n->y >= n->leny || n->x >= n->lenx){
     return -1;
   }
-  const nccell* src = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const nccell* src = ncplane_cell_peek_yx(n, n->y, n->x);
   memcpy(c, src, sizeof(*src));
   if(cell_simple_p(c)){
     *gclust = NULL;
@@ -2472,7 +2675,11 @@ void ncplane_erase(ncplane* n){
   // wiped out by the egcpool_dump(). do a duplication (to get the stylemask
   // and channels), and then reload.
   char* egc = nccell_strdup(n, &n->basecell);
-  memset(n->fb, 0, sizeof(*n->fb) * n->leny * n->lenx);
+  if(n->compact){
+    ncplane_compact_erase(n);
+  }else{
+    memset(n->fb, 0, sizeof(*n->fb) * n->leny * n->lenx);
+  }
   egcpool_dump(&n->pool);
   egcpool_init(&n->pool);
   // we need to zero out the EGC before handing this off to nccell_load, but
@@ -2537,8 +2744,8 @@ int ncplane_erase_region(ncplane* n, int ystart, int xstart, int ylen, int xlen)
   loginfo("erasing %d/%d - %d/%d", ystart, xstart, ystart + ylen, xstart + xlen);
   for(int y = ystart ; y < ystart + ylen ; ++y){
     for(int x = xstart ; x < xstart + xlen ; ++x){
-      nccell_release(n, &n->fb[nfbcellidx(n, y, x)]);
-      nccell_init(&n->fb[nfbcellidx(n, y, x)]);
+      nccell_release(n, ncplane_cell_ref_yx(n, y, x));
+      nccell_init(ncplane_cell_ref_yx(n, y, x));
     }
   }
   return 0;
@@ -2876,6 +3083,8 @@ unsplice_sprixels_recursive(ncplane* n, sprixel* prev){
     if(s->next){
       s->next->prev = s->prev;
     }
+    --ncplane_pile(n)->sprixelcount;
+    sprixel_work_unlink(s);
     if( (s->prev = prev) ){
       prev->next = s;
     }
@@ -2986,7 +3195,14 @@ ncplane* ncplane_reparent_family(ncplane* n, ncplane* newparent){
   }
   if(s){ // must be on new plane, with sprixels to donate
     sprixel* lame = s;
-    while(lame->next){
+    while(1){
+      ++n->pile->sprixelcount;
+      if(lame->invalidated != SPRIXEL_QUIESCENT){
+        sprixel_work_link(n->pile, lame);
+      }
+      if(lame->next == NULL){
+        break;
+      }
       lame = lame->next;
     }
     if( (lame->next = n->pile->sprixelcache) ){
@@ -3103,36 +3319,6 @@ int ncdirect_inputready_fd(ncdirect* n){
   return inputready_fd(n->tcache.ictx);
 }
 
-// FIXME speed this up, PoC
-// given an egc, get its index in the blitter's EGC set
-static int
-get_blitter_egc_idx(const struct blitset* bset, const char* egc){
-  wchar_t wc;
-  mbstate_t mbs = {0};
-  size_t sret = mbrtowc(&wc, egc, strlen(egc), &mbs);
-  if(sret == (size_t)-1 || sret == (size_t)-2){
-    return -1;
-  }
-  wchar_t* wptr = wcsrchr(bset->egcs, wc);
-  if(wptr == NULL){
-//fprintf(stderr, "FAILED TO FIND [%s] (%lc) in [%ls]\n", egc, wc, bset->egcs);
-    return -1;
-  }
-//fprintf(stderr, "FOUND [%s] (%lc) in [%ls] (%zu)\n", egc, wc, bset->egcs, wptr - bset->egcs);
-  return wptr - bset->egcs;
-}
-
-static bool
-is_bg_p(int idx, int py, int px, int width){
-  // bit increases to the right, and down
-  const int bpos = py * width + px; // bit corresponding to pixel, 0..|egcs|-1
-  const unsigned mask = 1u << bpos;
-  if(idx & mask){
-    return false;
-  }
-  return true;
-}
-
 static inline uint32_t*
 ncplane_as_rgba_internal(const ncplane* nc, ncblitter_e blit,
                          int begy, int begx, unsigned leny, unsigned lenx,
@@ -3162,56 +3348,56 @@ ncplane_as_rgba_internal(const ncplane* nc, ncblitter_e blit,
   if(pxdimx){
     *pxdimx = lenx * bset->width;
   }
-  uint32_t* ret = malloc(sizeof(*ret) * lenx * bset->width * leny * bset->height);
+  if(nc->sprite){
+    logerror("can't reverse-blit a sprixel plane");
+    return NULL;
+  }
+  const unsigned linepx = lenx * bset->width;
+  uint32_t* ret = malloc(sizeof(*ret) * linepx * leny * bset->height);
 //fprintf(stderr, "GEOM: %d/%d %d/%d ret: %p\n", bset->height, bset->width, *pxdimy, *pxdimx, ret);
   if(ret){
     for(unsigned y = ystart, targy = 0 ; y < ystart + leny ; ++y, targy += bset->height){
       for(unsigned x = xstart, targx = 0 ; x < xstart + lenx ; ++x, targx += bset->width){
-        uint16_t stylemask;
-        uint64_t channels;
-        char* c = ncplane_at_yx(nc, y, x, &stylemask, &channels);
-        if(c == NULL){
-          free(ret);
-          return NULL;
+        // we read the framebuffer directly, rather than going through
+        // ncplane_at_yx(), which would hand us a heap copy of the EGC.
+        const nccell* c = ncplane_cell_peek_yx(nc, y, x);
+        // the right side of a wide glyph takes the glyph to its left
+        unsigned gx = x;
+        while(nccell_wide_right_p(c) && gx){
+          c = ncplane_cell_peek_yx(nc, y, --gx);
         }
-        int idx = get_blitter_egc_idx(bset, c);
+        const uint64_t channels = c->channels;
+        uint32_t gcluster = c->gcluster;
+        if(gcluster == 0){
+          gcluster = nc->basecell.gcluster;
+        }
+        int idx = blitset_egc_idx(bset, gcluster);
         if(idx < 0){
+          logerror("cell at %u/%u isn't part of blitter %s", y, x, bset->name);
           free(ret);
-          free(c);
           return NULL;
         }
-        unsigned fr, fg, fb, br, bg, bb, fa, ba;
-        ncchannels_fg_rgb8(channels, &fr, &fb, &fg);
-        fa = ncchannels_fg_alpha(channels);
-        ncchannels_bg_rgb8(channels, &br, &bb, &bg);
-        ba = ncchannels_bg_alpha(channels);
-        // handle each destination pixel from this cell
+        unsigned r, g, b;
+        uint32_t fgpx = 0, bgpx = 0;
+        if(!ncchannels_fg_alpha(channels)){
+          ncchannels_fg_rgb8(channels, &r, &g, &b);
+          fgpx = ncpixel(r, g, b);
+        }
+        if(!ncchannels_bg_alpha(channels)){
+          ncchannels_bg_rgb8(channels, &r, &g, &b);
+          bgpx = ncpixel(r, g, b);
+        }
+        // handle each destination pixel from this cell. bit increases to the
+        // right, and then down.
+        uint32_t* p = &ret[targy * linepx + targx];
+        unsigned bits = idx;
         for(unsigned py = 0 ; py < bset->height ; ++py){
           for(unsigned px = 0 ; px < bset->width ; ++px){
-            uint32_t* p = &ret[(targy + py) * (lenx * bset->width) + (targx + px)];
-            bool background = is_bg_p(idx, py, px, bset->width);
-            if(background){
-              if(ba){
-                *p = 0;
-              }else{
-                ncpixel_set_a(p, 0xff);
-                ncpixel_set_r(p, br);
-                ncpixel_set_g(p, bb);
-                ncpixel_set_b(p, bg);
-              }
-            }else{
-              if(fa){
-                *p = 0;
-              }else{
-                ncpixel_set_a(p, 0xff);
-                ncpixel_set_r(p, fr);
-                ncpixel_set_g(p, fb);
-                ncpixel_set_b(p, fg);
-              }
-            }
+            p[px] = (bits & 1u) ? fgpx : bgpx;
+            bits >>= 1;
           }
+          p += linepx;
         }
-        free(c);
       }
     }
   }
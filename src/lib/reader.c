@@ -94,8 +94,8 @@ ncreader_redraw(ncreader* n){
     const unsigned texty = y;
     for(unsigned x = 0 ; x < n->ncp->lenx ; ++x){
       const unsigned textx = x + n->xproject;
-      const nccell* src = &n->textarea->fb[nfbcellidx(n->textarea, texty, textx)];
-      nccell* dst = &n->ncp->fb[nfbcellidx(n->ncp, y, x)];
+      const nccell* src = ncplane_cell_peek_yx(n->textarea, texty, textx);
+      nccell* dst = ncplane_cell_ref_yx(n->ncp, y, x);
 //fprintf(stderr, "projecting %d/%d [%s] to %d/%d [%s]\n", texty, textx, cell_extended_gcluster(n->textarea, src), y, x, cell_extended_gcluster(n->ncp, dst));
       if(cellcmp_and_dupfar(&n->ncp->pool, dst, n->textarea, src) < 0){
         ret = -1;
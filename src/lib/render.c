@@ -7,48 +7,58 @@
 sig_atomic_t sigcont_seen_for_render = 0;
 
 // update for a new visual area of |rows|x|cols|, neither of which may be zero.
-// copies that area of the lastframe (damage map) which is shared between the
+// retains that area of the lastframe (damage map) which is shared between the
 // two. new areas are initialized to empty, just like a new plane. lost areas
-// have their egcpool entries purged.
-static nccell*
+// have their egcpool entries purged. the allocation only ever grows, to the
+// largest geometry seen, and the rows are restriped within it in place; a
+// window being dragged about thus doesn't hit the allocator.
+static int
 restripe_lastframe(notcurses* nc, unsigned rows, unsigned cols){
   assert(rows);
   assert(cols);
-  const size_t size = sizeof(*nc->lastframe) * (rows * cols);
-  nccell* tmp = malloc(size);
-  if(tmp == NULL){
-    return NULL;
-  }
-  size_t copycols = nc->lfdimx > cols ? cols : nc->lfdimx;
-  size_t maxlinecopy = sizeof(nccell) * copycols;
-  size_t minlineset = sizeof(nccell) * cols - maxlinecopy;
-  unsigned zorch = nc->lfdimx > cols ? nc->lfdimx - cols : 0;
-  for(unsigned y = 0 ; y < rows ; ++y){
-    if(y < nc->lfdimy){
-      if(maxlinecopy){
-        memcpy(&tmp[cols * y], &nc->lastframe[nc->lfdimx * y], maxlinecopy);
-      }
-      if(minlineset){
-        memset(&tmp[cols * y + copycols], 0, minlineset);
-      }
-      // excise any egcpool entries from the right of the new plane area
-      if(zorch){
-        for(unsigned x = copycols ; x < copycols + zorch ; ++x){
-          pool_release(&nc->pool, &nc->lastframe[fbcellidx(y, nc->lfdimx, x)]);
-        }
+  const size_t cells = (size_t)rows * cols;
+  if(cells > nc->lfcap){
+    nccell* tmp = realloc(nc->lastframe, sizeof(*tmp) * cells);
+    if(tmp == NULL){
+      return -1;
+    }
+    nc->lastframe = tmp;
+    nc->lfcap = cells;
+  }
+  nccell* lf = nc->lastframe;
+  const unsigned oldcols = nc->lfdimx;
+  const unsigned keptrows = nc->lfdimy > rows ? rows : nc->lfdimy;
+  // excise any egcpool entries from the right of the new area
+  if(oldcols > cols){
+    for(unsigned y = 0 ; y < keptrows ; ++y){
+      for(unsigned x = cols ; x < oldcols ; ++x){
+        pool_release(&nc->pool, &lf[fbcellidx(y, oldcols, x)]);
       }
-    }else{
-      memset(&tmp[cols * y], 0, sizeof(nccell) * cols);
     }
   }
-  // excise any egcpool entries from below the new plane area
+  // excise any egcpool entries from below the new area
   for(unsigned y = rows ; y < nc->lfdimy ; ++y){
-    for(unsigned x = 0 ; x < nc->lfdimx ; ++x){
-      pool_release(&nc->pool, &nc->lastframe[fbcellidx(y, nc->lfdimx, x)]);
+    for(unsigned x = 0 ; x < oldcols ; ++x){
+      pool_release(&nc->pool, &lf[fbcellidx(y, oldcols, x)]);
     }
   }
-  free(nc->lastframe);
-  nc->lastframe = tmp;
+  // narrowing moves each row towards the front, so walk forwards. widening
+  // moves each row towards the back, so walk backwards.
+  if(cols < oldcols){
+    for(unsigned y = 1 ; y < keptrows ; ++y){
+      memmove(&lf[y * cols], &lf[y * oldcols], sizeof(*lf) * cols);
+    }
+  }else if(cols > oldcols){
+    for(unsigned y = keptrows ; y-- > 0 ; ){
+      if(y){
+        memmove(&lf[y * cols], &lf[y * oldcols], sizeof(*lf) * oldcols);
+      }
+      memset(&lf[y * cols + oldcols], 0, sizeof(*lf) * (cols - oldcols));
+    }
+  }
+  if(rows > keptrows){
+    memset(&lf[keptrows * cols], 0, sizeof(*lf) * cols * (rows - keptrows));
+  }
   nc->lfdimy = rows;
   nc->lfdimx = cols;
   return 0;
@@ -275,6 +285,9 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
     // stick on the head of the running list: top sprixel is at end
     if(*sprixelstack){
       (*sprixelstack)->prev = p->sprite;
+      p->sprite->zorder = (*sprixelstack)->zorder + 1;
+    }else{
+      p->sprite->zorder = 0;
     }
     p->sprite->next = *sprixelstack;
     p->sprite->prev = NULL;
@@ -300,7 +313,7 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
       }
 
       if(nccell_fg_alpha(targc) > NCALPHA_OPAQUE){
-        const nccell* vis = &p->fb[nfbcellidx(p, y, x)];
+        const nccell* vis = ncplane_cell_peek_yx(p, y, x);
         if(nccell_fg_default_p(vis)){
           vis = &p->basecell;
         }
@@ -326,7 +339,7 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
       // background channel and balpha.
       // Evaluate the background first, in case we have HIGHCONTRAST fg text.
       if(nccell_bg_alpha(targc) > NCALPHA_OPAQUE){
-        const nccell* vis = &p->fb[nfbcellidx(p, y, x)];
+        const nccell* vis = ncplane_cell_peek_yx(p, y, x);
         // to be on the blitter stacking path, we need
         //  1) crender->s.blittedquads to be non-zero (we're below semigraphics)
         //  2) cell_blittedquadrants(vis) to be non-zero (we're semigraphics)
@@ -357,7 +370,7 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
       // still use a character we find here, but its color will come entirely
       // from cells underneath us.
       if(!crender->p){
-        const nccell* vis = &p->fb[nfbcellidx(p, y, x)];
+        const nccell* vis = ncplane_cell_peek_yx(p, y, x);
         if(vis->gcluster == 0 && !nccell_double_wide_p(vis)){
           vis = &p->basecell;
         }
@@ -441,16 +454,115 @@ lock_in_highcontrast(notcurses* nc, const tinfo* ti, nccell* targc, struct crend
   }
 }
 
+// reduce an RGB channel to |bits| bits per component, replicating the high
+// bits downwards so that full intensity survives.
+static inline uint32_t
+quantize_channel(uint32_t chan, unsigned bits){
+  if(!ncchannel_rgb_p(chan)){
+    return chan;
+  }
+  const unsigned mask = (0xffu << (8 - bits)) & 0xffu;
+  unsigned r, g, b;
+  ncchannel_rgb8(chan, &r, &g, &b);
+  r = (r & mask) | ((r & mask) >> bits);
+  g = (g & mask) | ((g & mask) >> bits);
+  b = (b & mask) | ((b & mask) >> bits);
+  ncchannel_set_rgb8(&chan, r, g, b);
+  return chan;
+}
+
+// xterm's 6x6x6 color cube uses levels of 0, 95, 135, 175, 215, and 255
+static inline unsigned
+cube_level(unsigned v){
+  return v < 48 ? 0 : v < 115 ? 1 : (v - 35) / 40;
+}
+
+// map an RGB channel onto the nearest entry of the 256-color palette's cube
+static inline uint32_t
+palettize_channel(uint32_t chan){
+  if(!ncchannel_rgb_p(chan)){
+    return chan;
+  }
+  unsigned r, g, b;
+  ncchannel_rgb8(chan, &r, &g, &b);
+  ncchannel_set_palindex(&chan, 16 + 36 * cube_level(r) + 6 * cube_level(g) + cube_level(b));
+  return chan;
+}
+
+// does the palette still hold the standard cube? the dynamic palette works
+// down from the top, through the greyscale ramp, before it reaches the cube.
+static inline bool
+palette_cube_p(const notcurses* nc){
+  if(nc->touched_palette){
+    return false;
+  }
+  return !nc->dynpal || nc->dynpal->lowreg >= 232;
+}
+
+// degrade the solved colors of |c| according to nc->degrade. the palette is
+// only used if it's big enough, and still holds the standard cube.
+static inline void
+degrade_cell(const notcurses* nc, nccell* c){
+  uint32_t fchan = cell_fchannel(c);
+  uint32_t bchan = cell_bchannel(c);
+  if(nc->degrade >= 2 && nc->tcache.caps.colors >= 256 && palette_cube_p(nc)){
+    fchan = palettize_channel(fchan);
+    bchan = palettize_channel(bchan);
+  }else{
+    const unsigned bits = nc->degrade >= 2 ? 4 : 5;
+    fchan = quantize_channel(fchan, bits);
+    bchan = quantize_channel(bchan, bits);
+  }
+  cell_set_fchannel(c, fchan);
+  cell_set_bchannel(c, bchan);
+}
+
+// does the solved cell differ from what was last rasterized?
+static inline bool
+cell_differs(const egcpool* pool, const nccell* prev, const ncplane* srcp,
+             const nccell* c){
+  if(prev->stylemask != c->stylemask || prev->channels != c->channels){
+    return true;
+  }
+  return strcmp(pool_extended_gcluster(pool, prev), nccell_extended_gcluster(srcp, c));
+}
+
 // Postpaint a single cell (multiple if it is a multicolumn EGC). This means
 // checking for and locking in high-contrast, checking for damage, and updating
-// 'lastframe' for any cells which are damaged.
+// 'lastframe' for any cells which are damaged. If |degrade| is set, colors are
+// degraded before checking for damage (which is thus more likely to be
+// absorbed), and low-priority cells might be left as they were.
 static inline void
 postpaint_cell(notcurses* nc, const tinfo* ti, nccell* lastframe, unsigned dimx,
-               struct crender* crender, egcpool* pool, unsigned y, unsigned* x){
+               struct crender* crender, egcpool* pool, unsigned y, unsigned* x,
+               unsigned degrade){
   nccell* targc = &crender->c;
   lock_in_highcontrast(nc, ti, targc, crender);
-  nccell* prevcell = &lastframe[fbcellidx(y, dimx, *x)];
-  if(cellcmp_and_dupfar(pool, prevcell, crender->p, targc) > 0){
+  const size_t idx = fbcellidx(y, dimx, *x);
+  nccell* prevcell = &lastframe[idx];
+  uint64_t exact = 0;
+  if(degrade){
+    if(degrade >= NCDEGRADE_MAX && crender->p && crender->p->lowpriority){
+      // leave lastframe stale, so the update goes out once we can afford it
+      if(cell_differs(pool, prevcell, crender->p, targc)){
+        ++nc->stats.s.degraded_cells;
+      }
+      if(targc->width > 1){
+        *x += targc->width - 1;
+      }
+      return;
+    }
+    exact = targc->channels;
+    degrade_cell(nc, targc);
+  }
+  const int changed = cellcmp_and_dupfar(pool, prevcell, crender->p, targc);
+  if(degrade){
+    if(!changed && exact != nc->fidelity[idx]){
+      ++nc->stats.s.degraded_cells;
+    }
+    nc->fidelity[idx] = exact;
+  }
+  if(changed > 0){
 //fprintf(stderr, "damaging due to cmp [%s] %d %d\n", nccell_extended_gcluster(crender->p, &crender->c), y, *x);
     if(crender->sprixel){
       sprixcell_e state = sprixel_state(crender->sprixel, y, *x);
@@ -488,24 +600,66 @@ postpaint_cell(notcurses* nc, const tinfo* ti, nccell* lastframe, unsigned dimx,
 }
 
 
-// iterate over the rendered frame, adjusting the foreground colors for any
-// cells marked NCALPHA_HIGHCONTRAST, and clearing any cell covered by a
-// wide glyph to its left.
+// postpaint row |y| of the rendered frame, adjusting the foreground colors
+// for any cells marked NCALPHA_HIGHCONTRAST, and clearing any cell covered by
+// a wide glyph to its left.
 //
-// FIXME this cannot be performed at render time (we don't yet know the
-//       lastframe, and thus can't compute damage), but we *could* unite it
-//       with rasterization--factor out the single cell iteration...
+// this cannot be performed at render time (we don't yet know the lastframe,
+// and thus can't compute damage). rasterization instead postpaints each row
+// just before emitting it, while the row is still in cache.
 // FIXME can we not do the blend a single time here, if we track sums in
 //       paint()? tried this before and didn't get a win...
+static inline void
+postpaint_row(notcurses* nc, const tinfo* ti, nccell* lastframe, unsigned y,
+              unsigned dimx, struct crender* rvec, egcpool* pool,
+              unsigned degrade){
+  struct crender* row = &rvec[fbcellidx(y, dimx, 0)];
+  for(unsigned x = 0 ; x < dimx ; ++x){
+    postpaint_cell(nc, ti, lastframe, dimx, &row[x], pool, y, &x, degrade);
+  }
+}
+
+// is row |y| of the rendered frame identical to lastframe? checked without
+// consulting any EGCpool: every cell must be inline, and match lastframe in
+// its gcluster, stylemask, and channels. cells needing highcontrast are never
+// clean, as lock-in isn't idempotent for them (it is otherwise, so matching
+// lastframe means postpainting would change nothing). differences are
+// accumulated without branching, checked once per chunk. if the row is clean,
+// |damaged| is set to whether any of its cells are already damaged.
+#define CLEANROW_CHUNK 16
+static inline bool
+row_clean_p(const struct crender* rvec, const nccell* lastframe, unsigned y,
+            unsigned dimx, bool* damaged){
+  const struct crender* row = &rvec[fbcellidx(y, dimx, 0)];
+  const nccell* lrow = &lastframe[fbcellidx(y, dimx, 0)];
+  unsigned dam = 0;
+  for(unsigned x = 0 ; x < dimx ; x += CLEANROW_CHUNK){
+    const unsigned end = dimx - x > CLEANROW_CHUNK ? x + CLEANROW_CHUNK : dimx;
+    uint64_t diff = 0;
+    for(unsigned xx = x ; xx < end ; ++xx){
+      const nccell* c = &row[xx].c;
+      const nccell* l = &lrow[xx];
+      diff |= (c->gcluster ^ l->gcluster) | (c->stylemask ^ l->stylemask)
+              | (c->channels ^ l->channels) | cell_extended_p(c)
+              | row[xx].s.highcontrast;
+      dam |= row[xx].s.damaged;
+    }
+    if(diff){
+      return false;
+    }
+  }
+  *damaged = dam;
+  return true;
+}
+#undef CLEANROW_CHUNK
+
+// postpaint the entire rendered frame.
 static void
-postpaint(notcurses* nc, const tinfo* ti, nccell* lastframe,
-          unsigned dimy, unsigned dimx, struct crender* rvec, egcpool* pool){
+postpaint(notcurses* nc, const tinfo* ti, nccell* lastframe, unsigned dimy,
+          unsigned dimx, struct crender* rvec, egcpool* pool, unsigned degrade){
 //fprintf(stderr, "POSTPAINT BEGINS! %zu %p %d/%d\n", sizeof(*rvec), rvec, dimy, dimx);
   for(unsigned y = 0 ; y < dimy ; ++y){
-    for(unsigned x = 0 ; x < dimx ; ++x){
-      struct crender* crender = &rvec[fbcellidx(y, dimx, x)];
-      postpaint_cell(nc, ti, lastframe, dimx, crender, pool, y, &x);
-    }
+    postpaint_row(nc, ti, lastframe, y, dimx, rvec, pool, degrade);
   }
 }
 
@@ -580,15 +734,16 @@ int ncplane_mergedown(ncplane* restrict src, ncplane* restrict dst,
     return -1;
   }
   const int totalcells = dst->leny * dst->lenx;
-  nccell* rendfb = calloc(sizeof(*rendfb), totalcells);
+  nccell* rendfb = ncpile_fb_alloc(ncplane_pile(dst), totalcells);
   const size_t crenderlen = sizeof(struct crender) * totalcells;
   struct crender* rvec = malloc(crenderlen);
   if(!rendfb || !rvec){
     logerror("error allocating render state for %ux%u", leny, lenx);
-    free(rendfb);
+    ncpile_fb_free(ncplane_pile(dst), rendfb, totalcells);
     free(rvec);
     return -1;
   }
+  memset(rendfb, 0, sizeof(*rendfb) * totalcells);
   init_rvec(rvec, totalcells);
   sprixel* s = NULL;
   paint(src, rvec, dst->leny, dst->lenx, dst->absy, dst->absx, &s, 0);
@@ -597,10 +752,19 @@ int ncplane_mergedown(ncplane* restrict src, ncplane* restrict dst,
   assert(NULL == s);
 //fprintf(stderr, "Postpaint start (%dx%d)\n", dst->leny, dst->lenx);
   const struct tinfo* ti = &ncplane_notcurses_const(dst)->tcache;
-  postpaint(ncplane_notcurses(dst), ti, rendfb, dst->leny, dst->lenx, rvec, &dst->pool);
+  postpaint(ncplane_notcurses(dst), ti, rendfb, dst->leny, dst->lenx, rvec, &dst->pool, 0);
 //fprintf(stderr, "Postpaint done (%dx%d)\n", dst->leny, dst->lenx);
-  free(dst->fb);
-  dst->fb = rendfb;
+  if(dst->compact){
+    for(unsigned y = 0 ; y < dst->leny ; ++y){
+      for(unsigned x = 0 ; x < dst->lenx ; ++x){
+        *ncplane_cell_ref_yx(dst, y, x) = rendfb[fbcellidx(y, dst->lenx, x)];
+      }
+    }
+    ncpile_fb_free(ncplane_pile(dst), rendfb, totalcells);
+  }else{
+    ncpile_fb_free(ncplane_pile(dst), dst->fb, totalcells);
+    dst->fb = rendfb;
+  }
   free(rvec);
   return 0;
 }
@@ -765,6 +929,90 @@ int term_fg_rgb8(const tinfo* ti, fbuf* f, unsigned r, unsigned g, unsigned b){
   return 0;
 }
 
+// is this frame bound for the terminal (as opposed to a buffer or file)?
+// only then can we splice bitmap payloads, or rely on dynamic registers.
+static inline bool
+raster_to_tty(const notcurses* nc, const fbuf* f){
+  return nc->rstate.splicing && f == &nc->rstate.f;
+}
+
+static inline unsigned
+dynpal_hash(uint32_t rgb, unsigned size){
+  return ((rgb * 2654435761u) >> 8u) & (size - 1);
+}
+
+// index into dp->regs of the register holding rgb, or -1
+static inline int
+dynpal_lookup(const dynpalette* dp, uint32_t rgb){
+  for(unsigned h = dynpal_hash(rgb, DYNPAL_MAPSIZE) ; ; h = (h + 1) & (DYNPAL_MAPSIZE - 1)){
+    const int i = dp->map[h];
+    if(i < 0 || dp->regs[i].rgb == rgb){
+      return i;
+    }
+  }
+}
+
+static void
+dynpal_rebuild(dynpalette* dp){
+  memset(dp->map, 0xff, sizeof(dp->map));
+  for(unsigned i = 0 ; i < dp->count ; ++i){
+    if(dp->regs[i].mapped && !dp->regs[i].appowned){
+      unsigned h = dynpal_hash(dp->regs[i].rgb, DYNPAL_MAPSIZE);
+      while(dp->map[h] >= 0){
+        h = (h + 1) & (DYNPAL_MAPSIZE - 1);
+      }
+      dp->map[h] = i;
+    }
+  }
+}
+
+// count an emission of an unmapped color towards its getting a register
+static inline void
+dynpal_count(dynpalette* dp, uint32_t rgb){
+  for(unsigned h = dynpal_hash(rgb, DYNPAL_CANDSIZE) ; ; h = (h + 1) & (DYNPAL_CANDSIZE - 1)){
+    if(dp->cands[h].hits == 0){
+      if(dp->candcount < DYNPAL_CANDSIZE / 2){
+        dp->cands[h].rgb = rgb;
+        dp->cands[h].hits = 1;
+        ++dp->candcount;
+      }
+      return;
+    }
+    if(dp->cands[h].rgb == rgb){
+      ++dp->cands[h].hits;
+      return;
+    }
+  }
+}
+
+static inline unsigned
+decdigits(unsigned v){
+  return v >= 100 ? 3 : v >= 10 ? 2 : 1;
+}
+
+// bytes in the RGB SGR written by term_esc_rgb()
+static inline unsigned
+rgb_sgr_len(uint32_t rgb){
+  return strlen("\x1b[38;2;;;m") + decdigits(rgb >> 16u) +
+         decdigits((rgb >> 8u) & 0xffu) + decdigits(rgb & 0xffu);
+}
+
+// the application has programmed a register in our range itself. it's no
+// longer ours to use, and anything we drew with it must be redrawn.
+static void
+dynpal_yield(dynpalette* dp, unsigned idx){
+  const unsigned i = 255 - idx;
+  if(dp->regs[i].appowned){
+    return;
+  }
+  dp->regs[i].appowned = true;
+  if(dp->regs[i].mapped){
+    dp->regs[i].mapped = false;
+    dp->gone[dp->gonecount++] = dp->regs[i].rgb;
+  }
+  dp->rebuild = true;
+}
+
 static inline int
 update_palette(notcurses* nc, fbuf* f){
   if(nc->tcache.caps.can_change_colors){
@@ -773,6 +1021,9 @@ update_palette(notcurses* nc, fbuf* f){
       unsigned r, g, b;
       if(nc->palette_damage[damageidx]){
         nc->touched_palette = true;
+        if(nc->dynpal && damageidx >= 256 - DYNPAL_MAXREGS){
+          dynpal_yield(nc->dynpal, damageidx);
+        }
         ncchannel_rgb8(nc->palette.chans[damageidx], &r, &g, &b);
         // Need convert RGB values [0..256) to [0..1000], ugh
         // FIXME need handle HSL case also
@@ -789,6 +1040,169 @@ update_palette(notcurses* nc, fbuf* f){
   return 0;
 }
 
+// program dp->regs[i] with rgb. the terminal's current colors might have been
+// set through the register, so they can no longer be elided.
+static int
+dynpal_program(notcurses* nc, fbuf* f, unsigned i, uint32_t rgb){
+  dynpalette* dp = nc->dynpal;
+  const char* initc = get_escape(&nc->tcache, ESCAPE_INITC);
+  const unsigned idx = 255 - i;
+  const size_t used = f->used;
+  if(fbuf_emit(f, tiparm(initc, idx, (rgb >> 16u) * 1000 / 255,
+                         ((rgb >> 8u) & 0xffu) * 1000 / 255,
+                         (rgb & 0xffu) * 1000 / 255)) < 0){
+    return -1;
+  }
+  nc->stats.s.dynpal_spent += f->used - used;
+  dp->regs[i].rgb = rgb;
+  dp->regs[i].mapped = true;
+  dp->regs[i].lastused = dp->frame;
+  if(idx < dp->lowreg){
+    dp->lowreg = idx;
+  }
+  nc->rstate.fgelidable = false;
+  nc->rstate.bgelidable = false;
+  return 0;
+}
+
+// damage every cell of the rendered frame which was displayed using one of the
+// colors in dp->gone, since the registers which held them have been changed.
+static void
+dynpal_damage(notcurses* nc, ncpile* p){
+  dynpalette* dp = nc->dynpal;
+  if(nc->lastframe && nc->lfdimy == p->dimy && nc->lfdimx == p->dimx){
+    const size_t cells = (size_t)p->dimy * p->dimx;
+    for(size_t c = 0 ; c < cells ; ++c){
+      struct crender* r = &p->crender[c];
+      if(r->sprixel || r->s.damaged){
+        continue;
+      }
+      const nccell* l = &nc->lastframe[c];
+      const bool fgrgb = !nccell_fg_default_p(l) && !nccell_fg_palindex_p(l);
+      const bool bgrgb = !nccell_bg_default_p(l) && !nccell_bg_palindex_p(l);
+      const uint32_t fg = nccell_fg_rgb(l);
+      const uint32_t bg = nccell_bg_rgb(l);
+      for(unsigned i = 0 ; i < dp->gonecount ; ++i){
+        if((fgrgb && fg == dp->gone[i]) || (bgrgb && bg == dp->gone[i])){
+          r->s.damaged = 1;
+          break;
+        }
+      }
+    }
+  }
+  dp->gonecount = 0;
+}
+
+static int
+dynpal_cand_cmp(const void* va, const void* vb){
+  const uint32_t a = ((const dynpalcand*)va)->hits;
+  const uint32_t b = ((const dynpalcand*)vb)->hits;
+  return a < b ? 1 : a > b ? -1 : 0;
+}
+
+// plan the dynamic palette for a terminal-bound frame, using the emissions
+// counted during the last one. colors which would have saved more than a
+// register's programming are given registers, free ones first, and then
+// those which have gone unused for a frame, least recently used first.
+static int
+dynpal_plan(notcurses* nc, ncpile* p, fbuf* f){
+  dynpalette* dp = nc->dynpal;
+  ++dp->frame;
+  // compact the worthwhile candidates to the front, replacing their hits
+  // with their estimated savings, and take them best first.
+  unsigned n = 0;
+  if(dp->candcount){
+    for(unsigned h = 0 ; h < DYNPAL_CANDSIZE ; ++h){
+      if(dp->cands[h].hits){
+        const uint32_t rgb = dp->cands[h].rgb;
+        // an indexed SGR for registers 100..255 is 11 bytes
+        const uint32_t saved = dp->cands[h].hits * (rgb_sgr_len(rgb) - 11);
+        if(saved > dp->initclen){
+          dp->cands[n].rgb = rgb;
+          dp->cands[n].hits = saved;
+          ++n;
+        }
+      }
+    }
+    qsort(dp->cands, n, sizeof(*dp->cands), dynpal_cand_cmp);
+  }
+  bool remap = dp->rebuild;
+  dp->rebuild = false;
+  unsigned evicted = 0;
+  for(unsigned c = 0 ; c < n ; ++c){
+    int freereg = -1;
+    int lru = -1;
+    for(unsigned i = 0 ; i < dp->count ; ++i){
+      if(dp->regs[i].appowned){
+        continue;
+      }
+      if(!dp->regs[i].mapped){
+        freereg = i;
+        break;
+      }
+      if(dp->regs[i].lastused + 1 < dp->frame){
+        if(lru < 0 || dp->regs[i].lastused < dp->regs[lru].lastused){
+          lru = i;
+        }
+      }
+    }
+    if(freereg < 0){
+      if(lru < 0 || evicted == DYNPAL_MAXEVICT){
+        break;
+      }
+      dp->gone[dp->gonecount++] = dp->regs[lru].rgb;
+      ++evicted;
+      freereg = lru;
+    }
+    if(dynpal_program(nc, f, freereg, dp->cands[c].rgb)){
+      return -1;
+    }
+    remap = true;
+  }
+  if(dp->candcount || n){
+    memset(dp->cands, 0, sizeof(dp->cands));
+    dp->candcount = 0;
+  }
+  if(dp->gonecount){
+    dynpal_damage(nc, p);
+  }
+  if(remap){
+    dynpal_rebuild(dp);
+  }
+  return 0;
+}
+
+// emit an RGB color, through a dynamic register if one holds it. otherwise,
+// count it towards getting one.
+static int
+emit_dynpal_rgb(notcurses* nc, fbuf* f, bool fg, unsigned r, unsigned g, unsigned b){
+  dynpalette* dp = nc->dynpal;
+  const uint32_t rgb = (r << 16u) | (g << 8u) | b;
+  if(!fg){
+    // leave the default background's collision handling to term_bg_rgb8()
+    const uint32_t coll = nc->tcache.bg_collides_default;
+    if((coll & 0xff000000) == 0x01000000 && (coll & 0xffffffu) == rgb){
+      return term_bg_rgb8(&nc->tcache, f, r, g, b);
+    }
+  }
+  const int i = dynpal_lookup(dp, rgb);
+  if(i < 0){
+    dynpal_count(dp, rgb);
+    return fg ? term_fg_rgb8(&nc->tcache, f, r, g, b)
+              : term_bg_rgb8(&nc->tcache, f, r, g, b);
+  }
+  const size_t used = f->used;
+  if(fg ? term_fg_palindex(nc, f, 255 - i) : term_bg_palindex(nc, f, 255 - i)){
+    return -1;
+  }
+  const size_t len = f->used - used;
+  if(len < rgb_sgr_len(rgb)){
+    nc->stats.s.dynpal_saved += rgb_sgr_len(rgb) - len;
+  }
+  dp->regs[i].lastused = dp->frame;
+  return 0;
+}
+
 // at least one of the foreground and background are the default. emit the
 // necessary return to default (if one is necessary), and update rstate.
 static inline int
@@ -871,6 +1285,187 @@ emit_bg_palindex(notcurses* nc, fbuf* f, const nccell* srccell){
   return 0;
 }
 
+// while maximally degraded, redraws of bitmaps already on the screen are
+// deferred. they remain INVALIDATED, and go out once the budget allows.
+static inline bool
+sprixel_deferred(const notcurses* nc, const sprixel* s){
+  return nc->degrade >= NCDEGRADE_MAX && s->invalidated == SPRIXEL_INVALIDATED;
+}
+
+// order the pile's worklist as the sprixelcache is ordered (deepest first),
+// so that overlapping sprixels are drawn from the bottom up. the worklist is
+// usually short and mostly sorted already, so we use an insertion sort which
+// resumes from the previous insertion point. returns the worklist's length.
+static unsigned
+sort_sprixelwork(ncpile* p){
+  sprixel* sorted = NULL;
+  sprixel* last = NULL;
+  unsigned count = 0;
+  sprixel* s = p->sprixelwork;
+  while(s){
+    sprixel* next = s->wnext;
+    sprixel** parent = &sorted;
+    if(last && last->zorder >= s->zorder){
+      parent = &last->wnext;
+    }
+    while(*parent && (*parent)->zorder >= s->zorder){
+      parent = &(*parent)->wnext;
+    }
+    s->wnext = *parent;
+    *parent = s;
+    last = s;
+    ++count;
+    s = next;
+  }
+  sprixel** wprev = &p->sprixelwork;
+  p->sprixelwork = sorted;
+  for(s = sorted ; s ; s = s->wnext){
+    s->wprev = wprev;
+    wprev = &s->wnext;
+  }
+  return count;
+}
+
+// drop any sprixels which have settled from the worklist, following
+// rasterization.
+static void
+prune_sprixelwork(ncpile* p){
+  sprixel* s = p->sprixelwork;
+  while(s){
+    sprixel* next = s->wnext;
+    if(s->invalidated == SPRIXEL_QUIESCENT){
+      sprixel_work_unlink(s);
+    }
+    s = next;
+  }
+}
+
+// remove a dead sprixel from the pile, and free it.
+static void
+sprixel_retire(ncpile* p, sprixel* s){
+  if(s->prev){
+    s->prev->next = s->next;
+  }else{
+    p->sprixelcache = s->next;
+  }
+  if(s->next){
+    s->next->prev = s->prev;
+  }
+  --p->sprixelcount;
+  sprixel_free(s);
+}
+
+// decoded bytes of kitty graphics we'll leave loaded on behalf of piles which
+// aren't being displayed (kitty's default storage quota is 320MiB).
+#define PARKED_BITMAP_MAX (256ull << 20)
+
+// delete the graphics which hidden pile |p| left loaded in the terminal. they
+// must be retransmitted should |p| be displayed again.
+static int
+evict_parked(notcurses* nc, ncpile* p, fbuf* f){
+  loginfo("evicting %" PRIu64 "B of bitmaps from pile %p", p->parkedbytes, p);
+  for(sprixel* s = p->sprixelcache ; s ; s = s->next){
+    if(s->invalidated == SPRIXEL_LOADED && s->glyph.used){
+      if(nc->tcache.pixel_remove(s->id, f) < 0){
+        return -1;
+      }
+      sprixel_set_state(s, SPRIXEL_UNSEEN);
+    }
+  }
+  p->parkedbytes = 0;
+  return 0;
+}
+
+// delete the graphics which destroyed piles left loaded in the terminal (see
+// unpark_sprixels()).
+static int
+delete_orphans(notcurses* nc, fbuf* f){
+  int ret = 0;
+  pthread_mutex_lock(&nc->pilelock);
+  for(unsigned i = 0 ; i < nc->orphancount ; ++i){
+    if(nc->tcache.pixel_remove(nc->orphans[i], f) < 0){
+      ret = -1;
+      break;
+    }
+  }
+  nc->orphancount = 0;
+  pthread_mutex_unlock(&nc->pilelock);
+  return ret;
+}
+
+// pile |old| is being replaced on screen by |p|. damage those cells of |p|
+// covered by |old|'s bitmaps, so that they're redrawn (obliterating sixels,
+// and restoring whatever was hidden beneath opaque graphics). kitty graphics
+// are deleted. with NCOPTION_RETAIN_PILE_BITMAPS, those which are up to date
+// are instead only unplaced, and marked LOADED, so that they're merely placed
+// anew should |old| return. those graphics we couldn't retransmit (an
+// animation's glyph is only its latest delta) are always kept loaded.
+static int
+leave_pile(notcurses* nc, ncpile* old, ncpile* p, fbuf* f){
+  const bool retain = nc->flags & NCOPTION_RETAIN_PILE_BITMAPS;
+  old->parkedbytes = 0;
+  old->lastshown = ++nc->pileswitches;
+  for(sprixel* s = old->sprixelcache ; s ; s = s->next){
+    if(s->invalidated == SPRIXEL_UNSEEN){
+      continue; // never made it to the screen
+    }
+    int y, x;
+    if(s->n && s->invalidated != SPRIXEL_MOVED){
+      ncplane_abs_yx(s->n, &y, &x);
+    }else{
+      y = s->movedfromy;
+      x = s->movedfromx;
+    }
+    for(int yy = y < 0 ? 0 : y ; yy < y + (int)s->dimy && yy < (int)p->dimy ; ++yy){
+      for(int xx = x < 0 ? 0 : x ; xx < x + (int)s->dimx && xx < (int)p->dimx ; ++xx){
+        struct crender* r = &p->crender[yy * p->dimx + xx];
+        if(!r->sprixel){
+          r->s.damaged = 1;
+        }
+      }
+    }
+    s->fbdrawn = false;
+    if(!nc->tcache.pixel_remove){
+      continue;
+    }
+    const bool current = s->invalidated == SPRIXEL_QUIESCENT ||
+                         s->invalidated == SPRIXEL_MOVED;
+    if((retain && current) || !s->glyph.used){
+      if(nc->tcache.pixel_unplace(s->id, f) < 0){
+        return -1;
+      }
+      if(current){
+        sprixel_set_state(s, SPRIXEL_LOADED);
+        old->parkedbytes += sprixel_parkedbytes(s);
+      }
+    }else if(nc->tcache.pixel_remove(s->id, f) < 0){
+      return -1;
+    }
+  }
+  // |p|'s own loaded graphics are about to be shown. if we're now over
+  // budget, evict the least recently displayed piles' graphics.
+  p->parkedbytes = 0;
+  for( ; ; ){
+    uint64_t parked = 0;
+    ncpile* lru = NULL;
+    for(ncpile* q = p->next ; q != p ; q = q->next){
+      if(q->parkedbytes){
+        parked += q->parkedbytes;
+        if(lru == NULL || q->lastshown < lru->lastshown){
+          lru = q;
+        }
+      }
+    }
+    if(parked <= PARKED_BITMAP_MAX){
+      break;
+    }
+    if(evict_parked(nc, lru, f)){
+      return -1;
+    }
+  }
+  return 0;
+}
+
 // this first phase of sprixel rasterization is responsible for:
 //  1) invalidating all QUIESCENT sprixels if the pile has changed (because
 //      it would have been destroyed when switching away from our pile).
@@ -883,32 +1478,45 @@ emit_bg_palindex(notcurses* nc, fbuf* f, const nccell* srccell){
 // by the end of this pass, all sixels are *complete*. all kitty graphics
 // are loaded, but old kitty graphics remain visible, and new/updated kitty
 // graphics are not yet visible, and they have not moved.
+//
+// only (1) requires visiting every sprixel; otherwise, we walk the worklist.
 static int64_t
 clean_sprixels(notcurses* nc, ncpile* p, fbuf* f, int scrolls){
-  sprixel* s;
-  sprixel** parent = &p->sprixelcache;
+  if(p != nc->last_pile){
+    for(sprixel* s = p->sprixelcache ; s ; s = s->next){
+      if(s->invalidated == SPRIXEL_QUIESCENT){
+        sprixel_set_state(s, SPRIXEL_UNSEEN);
+      }
+    }
+  }
+  // quiescent sprixels off the worklist are all elided
+  unsigned listed = sort_sprixelwork(p);
+  if(p->sprixelcount > listed){
+    nc->stats.s.sprixelelisions += p->sprixelcount - listed;
+  }
   int64_t bytesemitted = 0;
-  while( (s = *parent) ){
+  sprixel* s = p->sprixelwork;
+  while(s){
+    sprixel* next = s->wnext;
     loginfo("phase 1 sprixel %u state %d loc %d/%d", s->id,
             s->invalidated, s->n ? s->n->absy : -1, s->n ? s->n->absx : -1);
-    if(s->invalidated == SPRIXEL_QUIESCENT){
-      if(p != nc->last_pile){
-        s->invalidated = SPRIXEL_UNSEEN;
-      }
-    }else if(s->invalidated == SPRIXEL_HIDE){
+    if(s->invalidated == SPRIXEL_HIDE){
 //fprintf(stderr, "OUGHT HIDE %d [%dx%d] %p\n", s->id, s->dimy, s->dimx, s);
       int r = sprite_scrub(nc, p, s);
       if(r < 0){
         return -1;
       }else if(r > 0){
-        if( (*parent = s->next) ){
-          s->next->prev = s->prev;
-        }
-        sprixel_free(s);
+        sprixel_retire(p, s);
         // need to avoid the rest of the iteration, as s is dead
+        s = next;
         continue; // don't account as an elision
       }
     }
+    if(sprixel_deferred(nc, s)){
+      ++nc->stats.s.sprixelelisions;
+      s = next;
+      continue;
+    }
     if(s->invalidated == SPRIXEL_INVALIDATED && nc->tcache.pixel_refresh){
       nc->tcache.pixel_refresh(p, s);
     }else if(s->invalidated == SPRIXEL_MOVED ||
@@ -917,12 +1525,12 @@ clean_sprixels(notcurses* nc, ncpile* p, fbuf* f, int scrolls){
 //fprintf(stderr, "1 MOVING BITMAP %d STATE %d AT %d/%d for %p\n", s->id, s->invalidated, y + nc->margin_t, x + nc->margin_l, s->n);
       if(s->invalidated == SPRIXEL_MOVED){
         if(p != nc->last_pile){
-          s->invalidated = SPRIXEL_UNSEEN;
+          sprixel_set_state(s, SPRIXEL_UNSEEN);
         }else{
           if(s->n->absx == s->movedfromx){
             if(s->movedfromy - s->n->absy == scrolls){
-              s->invalidated = SPRIXEL_INVALIDATED;
-              continue;
+              sprixel_set_state(s, SPRIXEL_INVALIDATED);
+              continue; // reconsider s in its new state
             }
           }
         }
@@ -937,7 +1545,7 @@ clean_sprixels(notcurses* nc, ncpile* p, fbuf* f, int scrolls){
     }else{
       ++nc->stats.s.sprixelelisions;
     }
-    parent = &s->next;
+    s = next;
 //fprintf(stderr, "SPRIXEL STATE: %d\n", s->invalidated);
   }
   return bytesemitted;
@@ -1012,6 +1620,64 @@ rasterize_scrolls(const ncpile* p, fbuf* f){
   return emit_scrolls_track(p->nc, scrolls, f);
 }
 
+// payloads smaller than this are copied into the frame; they're not worth
+// an iovec of their own.
+#define MIN_SPLICE_SIZE 4096
+
+int sprite_emit_glyph(const ncpile* p, fbuf* f, fbuf* glyph, bool take){
+  const size_t len = glyph->used;
+  notcurses* nc = p ? p->nc : NULL;
+  if(!nc || !raster_to_tty(nc, f) || len < MIN_SPLICE_SIZE){
+    if(len && fbuf_putn(f, glyph->buf, len) < 0){
+      return -1;
+    }
+    if(nc){
+      nc->stats.s.sprixelcopied += len;
+    }
+    if(take){
+      fbuf_free(glyph);
+    }
+    return len;
+  }
+  rasterstate* rs = &nc->rstate;
+  if(rs->splicecount == rs->splicecap){
+    unsigned cap = rs->splicecap ? rs->splicecap * 2 : 8;
+    fbufsplice* tmp = realloc(rs->splices, sizeof(*tmp) * cap);
+    if(tmp == NULL){
+      return -1;
+    }
+    rs->splices = tmp;
+    rs->splicecap = cap;
+  }
+  fbufsplice* sp = &rs->splices[rs->splicecount++];
+  sp->off = f->used;
+  sp->buf = glyph->buf;
+  sp->len = len;
+  if(take){
+    sp->owned = *glyph;
+    glyph->buf = NULL;
+    glyph->size = 0;
+    glyph->used = 0;
+  }else{
+    sp->owned.buf = NULL;
+    sp->owned.size = 0;
+    sp->owned.used = 0;
+  }
+  rs->splicedbytes += len;
+  nc->stats.s.sprixelspliced += len;
+  return len;
+}
+
+// drop the current frame's splices, freeing any payloads they own.
+static void
+release_splices(rasterstate* rs){
+  for(unsigned i = 0 ; i < rs->splicecount ; ++i){
+    fbuf_free(&rs->splices[i].owned);
+  }
+  rs->splicecount = 0;
+  rs->splicedbytes = 0;
+}
+
 // second sprixel pass in rasterization. by this time, all sixels are handled
 // (and in the QUIESCENT state); only persistent kitty graphics still require
 // operation. responsibilities of this second pass include:
@@ -1024,11 +1690,13 @@ rasterize_scrolls(const ncpile* p, fbuf* f){
 static int64_t
 rasterize_sprixels(notcurses* nc, ncpile* p, fbuf* f){
   int64_t bytesemitted = 0;
-  sprixel* s;
-  sprixel** parent = &p->sprixelcache;
-  while( (s = *parent) ){
+  // glyph phase 1 might have invalidated further sprixels
+  sort_sprixelwork(p);
+  sprixel* s = p->sprixelwork;
+  while(s){
+    sprixel* next = s->wnext;
 //fprintf(stderr, "raster YARR HARR HARR SPIRXLE %u STATE %d\n", s->id, s->invalidated);
-    if(s->invalidated == SPRIXEL_INVALIDATED){
+    if(s->invalidated == SPRIXEL_INVALIDATED && !sprixel_deferred(nc, s)){
 //fprintf(stderr, "3 DRAWING BITMAP %d STATE %d AT %d/%d for %p\n", s->id, s->invalidated, nc->margin_t, nc->margin_l, s->n);
       int r = sprite_draw(&nc->tcache, p, s, f, nc->margin_t, nc->margin_l);
       if(r < 0){
@@ -1057,14 +1725,10 @@ rasterize_sprixels(notcurses* nc, ncpile* p, fbuf* f){
         if(nc->tcache.pixel_remove(s->id, f) < 0){
           return -1;
         }
-        if( (*parent = s->next) ){
-          s->next->prev = s->prev;
-        }
-        sprixel_free(s);
-        continue;
+        sprixel_retire(p, s);
       }
     }
-    parent = &s->next;
+    s = next;
   }
   return bytesemitted;
 }
@@ -1078,11 +1742,11 @@ rasterize_sprixels_post(notcurses* nc, ncpile* p){
     return 0;
   }
   int64_t bytesemitted = 0;
-  sprixel* s;
-  sprixel** parent = &p->sprixelcache;
-  while( (s = *parent) ){
+  sort_sprixelwork(p); // scrolling might have invalidated sprixels
+  for(sprixel* s = p->sprixelwork ; s ; s = s->wnext){
 //fprintf(stderr, "YARR HARR HARR SPIRXLE %u STATE %d\n", s->id, s->invalidated);
-    if(s->invalidated == SPRIXEL_INVALIDATED || s->invalidated == SPRIXEL_UNSEEN){
+    if((s->invalidated == SPRIXEL_INVALIDATED && !sprixel_deferred(nc, s)) ||
+       s->invalidated == SPRIXEL_UNSEEN){
       int offy, offx;
       ncplane_abs_yx(s->n, &offy, &offx);
 //fprintf(stderr, "5 DRAWING BITMAP %d STATE %d AT %d/%d for %p\n", s->id, s->invalidated, nc->margin_t + offy, nc->margin_l + offx, s->n);
@@ -1092,7 +1756,6 @@ rasterize_sprixels_post(notcurses* nc, ncpile* p){
       }
       bytesemitted += r;
     }
-    parent = &s->next;
   }
   return bytesemitted;
 }
@@ -1108,15 +1771,56 @@ rasterize_sprixels_post(notcurses* nc, ncpile* p){
 // should be an rvec entry for each cell, but only the 'damaged' field is used.
 // lastframe has *not yet been written to the screen*, i.e. it's only about to
 // *become* the last frame rasterized.
+//
+// if |postpaint| is non-negative, the first phase postpaints each row (at that
+// degradation level) immediately before emitting it, writing it to lastframe.
+// undegraded rows which are clean (see row_clean_p()) aren't postpainted, and
+// if they're also undamaged, they're elided wholesale. the first phase records
+// which cells it left damaged, and the second phase visits only those.
 static int
-rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
+rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase,
+               int postpaint){
   struct crender* rvec = p->crender;
+  unsigned* deferred = nc->rstate.deferred;
   // we only need to emit a coordinate if it was damaged. the damagemap is a
   // bit per coordinate, one per struct crender.
   for(unsigned y = nc->margin_t; y < p->dimy + nc->margin_t ; ++y){
     const int innery = y - nc->margin_t;
+    unsigned* span = &deferred[innery * 2];
+    unsigned startx = nc->margin_l;
+    unsigned endx = p->dimx + nc->margin_l;
+    if(phase == 0){
+      span[0] = p->dimx;
+      span[1] = 0;
+      if(postpaint >= 0){
+        bool damaged;
+        if(postpaint == 0 && row_clean_p(rvec, nc->lastframe, innery, p->dimx, &damaged)){
+          ++nc->stats.s.cleanrows;
+          if(!damaged){
+            // account for the elisions the loop below would have performed
+            const nccell* lrow = &nc->lastframe[fbcellidx(innery, p->dimx, 0)];
+            for(unsigned x = 0 ; x < p->dimx ; ++x){
+              ++nc->stats.s.cellelisions;
+              if(nccell_wide_left_p(&lrow[x])){
+                ++x;
+              }
+            }
+            continue;
+          }
+        }else{
+          postpaint_row(nc, &nc->tcache, nc->lastframe, innery, p->dimx, rvec,
+                        &nc->pool, postpaint);
+        }
+      }
+    }else{
+      if(span[0] > span[1]){
+        continue; // nothing remains damaged on this row
+      }
+      startx += span[0];
+      endx = span[1] + 1 + nc->margin_l;
+    }
     bool saw_linefeed = 0;
-    for(unsigned x = nc->margin_l ; x < p->dimx + nc->margin_l ; ++x){
+    for(unsigned x = startx ; x < endx ; ++x){
       const int innerx = x - nc->margin_l;
       const size_t damageidx = innery * nc->lfdimx + innerx;
       unsigned r, g, b, br, bg, bb;
@@ -1128,7 +1832,16 @@ rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
         if(nccell_wide_left_p(srccell)){
           ++x;
         }
-      }else if(phase != 0 || !rvec[damageidx].s.p_beats_sprixel){
+      }else if(phase == 0 && rvec[damageidx].s.p_beats_sprixel){
+        // leave it for the second phase, following the bitmaps
+        if(span[0] > (unsigned)innerx){
+          span[0] = innerx;
+        }
+        span[1] = innerx;
+        if(nccell_wide_left_p(srccell)){
+          ++x;
+        }
+      }else{
 //fprintf(stderr, "phase %u damaged at %d/%d %d\n", phase, innery, innerx, x);
         // in the first text phase, we draw only those glyphs where the glyph
         // was not above a sprixel (and the cell is damaged). in the second
@@ -1169,7 +1882,11 @@ rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
             ++nc->stats.s.fgelisions;
           }else{
             if(!rgbequal){ // if rgbequal, no need to set fg
-              if(term_fg_rgb8(&nc->tcache, f, r, g, b)){
+              if(nc->rstate.dynpal){
+                if(emit_dynpal_rgb(nc, f, true, r, g, b)){
+                  return -1;
+                }
+              }else if(term_fg_rgb8(&nc->tcache, f, r, g, b)){
                 return -1;
               }
               ++nc->stats.s.fgemissions;
@@ -1197,7 +1914,11 @@ rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
           if(nc->rstate.bgelidable && nc->rstate.lastbr == br && nc->rstate.lastbg == bg && nc->rstate.lastbb == bb){
             ++nc->stats.s.bgelisions;
           }else{
-            if(term_bg_rgb8(&nc->tcache, f, br, bg, bb)){
+            if(nc->rstate.dynpal){
+              if(emit_dynpal_rgb(nc, f, false, br, bg, bb)){
+                return -1;
+              }
+            }else if(term_bg_rgb8(&nc->tcache, f, br, bg, bb)){
               return -1;
             }
             ++nc->stats.s.bgemissions;
@@ -1271,13 +1992,39 @@ rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
 // (they are not, for instance, when rendering to a non-tty). on output,
 // assuming success, it is non-0 if application-synchronized updates are
 // desired; in this case, a SUM footer is present at the end of the buffer.
+// if |postpaint| is non-negative, the frame has yet to be postpainted, and is
+// postpainted at that degradation level during the first glyph phase.
 static int
-notcurses_rasterize_inner(notcurses* nc, ncpile* p, fbuf* f, unsigned* asu){
+notcurses_rasterize_inner(notcurses* nc, ncpile* p, fbuf* f, unsigned* asu,
+                          int postpaint){
   logdebug("pile %p ymax: %d xmax: %d", p, p->dimy + nc->margin_t, p->dimx + nc->margin_l);
+  if(p->dimy > nc->rstate.deferredrows){
+    unsigned* tmp = realloc(nc->rstate.deferred, sizeof(*tmp) * 2 * p->dimy);
+    if(tmp == NULL){
+      return -1;
+    }
+    nc->rstate.deferred = tmp;
+    nc->rstate.deferredrows = p->dimy;
+  }
+  if(nc->rstate.leaving){
+    ncpile* old = nc->rstate.leaving;
+    nc->rstate.leaving = NULL;
+    if(leave_pile(nc, old, p, f)){
+      return -1;
+    }
+  }
+  if(raster_to_tty(nc, f) && delete_orphans(nc, f)){
+    return -1;
+  }
   // don't write a clearscreen. we only update things that have been changed.
   // we explicitly move the cursor at the beginning of each output line, so no
   // need to home it expliticly.
   update_palette(nc, f);
+  const bool dynpal = nc->dynpal && raster_to_tty(nc, f);
+  if(dynpal && dynpal_plan(nc, p, f)){
+    return -1;
+  }
+  nc->rstate.dynpal = dynpal && nc->dynpal->count;
   int scrolls = p->scrolls;
   logdebug("sprixel phase 1");
   int64_t sprixelbytes = clean_sprixels(nc, p, f, scrolls);
@@ -1285,7 +2032,7 @@ notcurses_rasterize_inner(notcurses* nc, ncpile* p, fbuf* f, unsigned* asu){
     return -1;
   }
   logdebug("glyph phase 1");
-  if(rasterize_core(nc, p, f, 0)){
+  if(rasterize_core(nc, p, f, 0, postpaint)){
     return -1;
   }
   logdebug("sprixel phase 2");
@@ -1302,12 +2049,12 @@ notcurses_rasterize_inner(notcurses* nc, ncpile* p, fbuf* f, unsigned* asu){
     return -1;
   }
   p->scrolls = 0;
-  if(rasterize_core(nc, p, f, 1)){
+  if(rasterize_core(nc, p, f, 1, -1)){
     return -1;
   }
 #define MIN_SUMODE_SIZE BUFSIZ
   if(*asu){
-    if(nc->rstate.f.used >= MIN_SUMODE_SIZE){
+    if(nc->rstate.f.used + nc->rstate.splicedbytes >= MIN_SUMODE_SIZE){
       const char* endasu = get_escape(&nc->tcache, ESCAPE_ESUM);
       if(endasu){
         if(fbuf_puts(f, endasu) < 0){
@@ -1321,13 +2068,170 @@ notcurses_rasterize_inner(notcurses* nc, ncpile* p, fbuf* f, unsigned* asu){
     }
   }
 #undef MIN_SUMODE_SIZE
-  return nc->rstate.f.used;
+  return nc->rstate.f.used + nc->rstate.splicedbytes;
+}
+
+// how a frame written to the terminal is offered to the output sinks
+typedef enum {
+  SINKFRAME_NONE,  // not terminal output; the sinks don't see it
+  SINKFRAME_DELTA, // an ordinary frame, relative to its predecessors
+} sinkframe_e;
+
+// the parts of a channel which determine what color is displayed
+static inline uint32_t
+keyframe_channel(uint32_t channel){
+  if(ncchannel_default_p(channel)){
+    return 0;
+  }
+  return channel & (NC_BGDEFAULT_MASK | NC_BG_PALETTE | NC_BG_RGB_MASK);
+}
+
+static int
+keyframe_color(notcurses* nc, fbuf* f, bool fg, uint32_t channel){
+  if(ncchannel_palindex_p(channel)){
+    return fg ? term_fg_palindex(nc, f, ncchannel_palindex(channel))
+              : term_bg_palindex(nc, f, ncchannel_palindex(channel));
+  }
+  unsigned r, g, b;
+  ncchannel_rgb8(channel, &r, &g, &b);
+  return fg ? term_fg_rgb8(&nc->tcache, f, r, g, b)
+            : term_bg_rgb8(&nc->tcache, f, r, g, b);
+}
+
+static int
+keyframe_initc(fbuf* f, const char* initc, unsigned idx, unsigned r,
+               unsigned g, unsigned b){
+  return fbuf_emit(f, tiparm(initc, idx, r * 1000 / 255, g * 1000 / 255,
+                             b * 1000 / 255));
+}
+
+// write a keyframe, from which a sink which has dropped frames can be
+// resynchronized, to |f|. it is serialized from lastframe, and thus reflects
+// what the last rasterization left on the terminal, without redrawing it.
+// bitmaps are not included. the keyframe leaves the styles and the cursor
+// where the terminal has them, but the next delta can't know which colors it
+// left set, so we stop eliding colors until they're next emitted.
+static int
+write_sink_keyframe(notcurses* nc, fbuf* f){
+  const tinfo* ti = &nc->tcache;
+  const char* sgr0 = get_escape(ti, ESCAPE_SGR0);
+  const char* op = get_escape(ti, ESCAPE_OP);
+  const char* cup = get_escape(ti, ESCAPE_CUP);
+  const char* initc = get_escape(ti, ESCAPE_INITC);
+  if(sgr0 && fbuf_emit(f, sgr0) < 0){
+    return -1;
+  }
+  if(initc && ti->caps.can_change_colors){
+    unsigned r, g, b;
+    if(nc->touched_palette){
+      for(unsigned i = 0 ; i < sizeof(nc->palette.chans) / sizeof(*nc->palette.chans) ; ++i){
+        ncchannel_rgb8(nc->palette.chans[i], &r, &g, &b);
+        if(keyframe_initc(f, initc, i, r, g, b) < 0){
+          return -1;
+        }
+      }
+    }
+    if(nc->dynpal){
+      for(unsigned i = 0 ; i < DYNPAL_MAXREGS ; ++i){
+        const uint32_t rgb = nc->dynpal->regs[i].rgb;
+        if(nc->dynpal->regs[i].mapped && !nc->dynpal->regs[i].appowned){
+          if(keyframe_initc(f, initc, 255 - i, rgb >> 16u, (rgb >> 8u) & 0xffu,
+                            rgb & 0xffu) < 0){
+            return -1;
+          }
+        }
+      }
+    }
+  }
+  uint16_t curstyle = 0;
+  uint32_t curfg = 0; // sgr0 leaves us with the default colors
+  uint32_t curbg = 0;
+  for(unsigned y = 0 ; y < nc->lfdimy ; ++y){
+    if(fbuf_emit(f, tiparm(cup, y + nc->margin_t, nc->margin_l)) < 0){
+      return -1;
+    }
+    for(unsigned x = 0 ; x < nc->lfdimx ; ++x){
+      const nccell* c = &nc->lastframe[fbcellidx(y, nc->lfdimx, x)];
+      unsigned normalized;
+      if(coerce_styles(f, ti, &curstyle, nccell_styles(c), &normalized)){
+        return -1;
+      }
+      const uint32_t fg = keyframe_channel(nccell_fchannel(c));
+      const uint32_t bg = keyframe_channel(nccell_bchannel(c));
+      if(op && ((fg == 0 && curfg) || (bg == 0 && curbg))){
+        if(fbuf_emit(f, op) < 0){
+          return -1;
+        }
+        curfg = curbg = 0;
+      }
+      if(fg != curfg){
+        if(keyframe_color(nc, f, true, fg)){
+          return -1;
+        }
+        curfg = fg;
+      }
+      if(bg != curbg){
+        if(keyframe_color(nc, f, false, bg)){
+          return -1;
+        }
+        curbg = bg;
+      }
+      if(term_putc(f, &nc->pool, c)){
+        return -1;
+      }
+      if(c->width > 1){
+        x += c->width - 1;
+      }
+    }
+  }
+  if(sgr0 && fbuf_emit(f, sgr0) < 0){
+    return -1;
+  }
+  curstyle = 0;
+  unsigned normalized;
+  if(coerce_styles(f, ti, &curstyle, nc->rstate.curattr, &normalized)){
+    return -1;
+  }
+  if(nc->rstate.y >= 0 && nc->rstate.x >= 0){
+    if(fbuf_emit(f, tiparm(cup, nc->rstate.y, nc->rstate.x)) < 0){
+      return -1;
+    }
+  }
+  const char* cvis = get_escape(ti, nc->cursory >= 0 ? ESCAPE_CNORM : ESCAPE_CIVIS);
+  if(cvis && fbuf_emit(f, cvis) < 0){
+    return -1;
+  }
+  nc->rstate.fgelidable = false;
+  nc->rstate.bgelidable = false;
+  nc->rstate.fgpalelidable = false;
+  nc->rstate.bgpalelidable = false;
+  nc->rstate.fgdefelidable = false;
+  nc->rstate.bgdefelidable = false;
+  return 0;
+}
+
+// publish a keyframe to those sinks which need one. the terminal sees nothing.
+static int
+publish_sink_keyframe(notcurses* nc){
+  fbuf f = {0};
+  if(fbuf_init(&f)){
+    return -1;
+  }
+  int ret = write_sink_keyframe(nc, &f);
+  if(ret == 0){
+    ret = ncsinks_publish(nc, f.buf, f.used, true);
+  }
+  fbuf_free(&f);
+  return ret;
 }
 
 // rasterize the rendered frame, and blockingly write it out to the terminal.
+// see notcurses_rasterize_inner() regarding |postpaint|.
 static int
-raster_and_write(notcurses* nc, ncpile* p, fbuf* f){
+raster_and_write(notcurses* nc, ncpile* p, fbuf* f, sinkframe_e sinkframe,
+                 int postpaint){
   fbuf_reset(f);
+  release_splices(&nc->rstate);
   // will we be using application-synchronized updates? if this comes back as
   // non-zero, we are, and must emit the header. no SUM without a tty, and we
   // can't have the escape without being connected to one...
@@ -1340,9 +2244,14 @@ raster_and_write(notcurses* nc, ncpile* p, fbuf* f){
       return -1;
     }
   }
-  if(notcurses_rasterize_inner(nc, p, f, &useasu) < 0){
+  nc->rstate.splicing = true;
+  int r = notcurses_rasterize_inner(nc, p, f, &useasu, postpaint);
+  nc->rstate.splicing = false;
+  if(r < 0){
+    release_splices(&nc->rstate);
     return -1;
   }
+  clock_gettime(CLOCK_MONOTONIC, &nc->rstate.rasterdone);
   // if we loaded a BSU into the front, but don't actually want to use it,
   // we start printing after the BSU.
   size_t moffset = 0;
@@ -1356,17 +2265,24 @@ raster_and_write(notcurses* nc, ncpile* p, fbuf* f){
   int ret = 0;
   sigset_t oldmask;
   block_signals(&oldmask);
-  if(blocking_write(fileno(nc->ttyfp), nc->rstate.f.buf + moffset,
-                    nc->rstate.f.used - moffset)){
+  if(fbuf_writev(fileno(nc->ttyfp), &nc->rstate.f, moffset,
+                 nc->rstate.splices, nc->rstate.splicecount)){
     ret = -1;
   }
   unblock_signals(&oldmask);
+  if(sinkframe != SINKFRAME_NONE){
+    ncsinks_publish_spliced(nc, &nc->rstate.f, moffset, nc->rstate.splices,
+                            nc->rstate.splicecount);
+  }
+  const int64_t bytes = nc->rstate.f.used + nc->rstate.splicedbytes;
+  release_splices(&nc->rstate);
   rasterize_sprixels_post(nc, p);
+  prune_sprixelwork(p);
 //fprintf(stderr, "%lu/%lu %lu/%lu %lu/%lu %d\n", nc->stats.defaultelisions, nc->stats.defaultemissions, nc->stats.fgelisions, nc->stats.fgemissions, nc->stats.bgelisions, nc->stats.bgemissions, ret);
   if(ret < 0){
     return ret;
   }
-  return nc->rstate.f.used;
+  return bytes;
 }
 
 // if the cursor is enabled, store its location and disable it. then, once done
@@ -1374,18 +2290,20 @@ raster_and_write(notcurses* nc, ncpile* p, fbuf* f){
 // during rasterization, we'll get grotesque flicker. 'out' is a memstream
 // used to collect a buffer.
 static inline int
-notcurses_rasterize(notcurses* nc, ncpile* p, fbuf* f){
+notcurses_rasterize(notcurses* nc, ncpile* p, fbuf* f, sinkframe_e sinkframe,
+                    int postpaint){
   const int cursory = nc->cursory;
   const int cursorx = nc->cursorx;
   if(cursory >= 0){ // either both are good, or neither is
     notcurses_cursor_disable(nc);
   }
-  int ret = raster_and_write(nc, p, f);
+  int ret = raster_and_write(nc, p, f, sinkframe, postpaint);
   fbuf_reset(f);
   if(cursory >= 0){
     notcurses_cursor_enable(nc, cursory, cursorx);
   }else if(nc->rstate.logendy >= 0){
     goto_location(nc, f, nc->rstate.logendy, nc->rstate.logendx, nc->rstate.lastsrcp);
+    ncsinks_publish(nc, f->buf, f->used, false);
     if(fbuf_flush(f, nc->ttyfp)){
       ret = -1;
     }
@@ -1422,9 +2340,21 @@ int notcurses_refresh(notcurses* nc, unsigned* restrict dimy, unsigned* restrict
   if(clear_and_home(nc, &nc->tcache, &nc->rstate.f)){
     return -1;
   }
+  ncsinks_publish(nc, nc->rstate.f.buf, nc->rstate.f.used, false);
   if(fbuf_flush(&nc->rstate.f, nc->ttyfp)){
     return -1;
   }
+  // directly-drawn sprixels were just cleared along with everything else
+  if(nc->last_pile){
+    for(sprixel* s = nc->last_pile->sprixelcache ; s ; s = s->next){
+      if(s->fbdrawn){
+        s->fbdrawn = false;
+        if(s->invalidated == SPRIXEL_QUIESCENT){
+          sprixel_set_state(s, SPRIXEL_INVALIDATED);
+        }
+      }
+    }
+  }
   if(nc->lfdimx == 0 || nc->lfdimy == 0){
     return 0;
   }
@@ -1440,8 +2370,11 @@ int notcurses_refresh(notcurses* nc, unsigned* restrict dimy, unsigned* restrict
   for(int i = 0 ; i < count ; ++i){
     p.crender[i].s.damaged = 1;
   }
-  int ret = notcurses_rasterize(nc, &p, &nc->rstate.f);
+  int ret = notcurses_rasterize(nc, &p, &nc->rstate.f, SINKFRAME_DELTA, -1);
   free(p.crender);
+  // the screen was cleared, so no pile is displayed (and we mustn't retain
+  // a pointer to our temporary one). the next pile's bitmaps are all redrawn.
+  nc->last_pile = NULL;
   if(ret < 0){
     return -1;
   }
@@ -1470,7 +2403,7 @@ int ncpile_render_to_file(ncplane* n, FILE* fp){
   for(unsigned i = 0 ; i < count ; ++i){
     p->crender[i].s.damaged = 1;
   }
-  int ret = raster_and_write(nc, p, &f);
+  int ret = raster_and_write(nc, p, &f, SINKFRAME_NONE, -1);
   free(p->crender);
   if(ret > 0){
     if(fwrite(f.buf, f.used, 1, fp) == 1){
@@ -1514,21 +2447,150 @@ ncpile_render_internal(ncpile* p, unsigned pgeo_changed){
   }
 }
 
+int notcurses_set_bandwidth(notcurses* nc, uint64_t bps){
+  if(bps > INT64_MAX){
+    logerror("illegal budget %" PRIu64, bps);
+    return -1;
+  }
+  nc->bwbudget = bps;
+  nc->bwcredit = bps;
+  nc->bwlastns = clock_getns(CLOCK_MONOTONIC);
+  if(bps == 0){
+    nc->degrade = 0;
+  }
+  loginfo("bandwidth budget: %" PRIu64 "B/s", bps);
+  return 0;
+}
+
+int notcurses_set_dynamic_palette(notcurses* nc, unsigned registers){
+  if(registers > DYNPAL_MAXREGS){
+    logerror("illegal register count %u", registers);
+    return -1;
+  }
+  const tinfo* ti = &nc->tcache;
+  const char* initc = get_escape(ti, ESCAPE_INITC);
+  if(registers){
+    if(!ti->caps.rgb || !ti->caps.can_change_colors || ti->caps.colors < 256 ||
+       !initc || !get_escape(ti, ESCAPE_SETAF) || !get_escape(ti, ESCAPE_SETAB)){
+      logwarn("dynamic palette requires RGB and a programmable 256-color palette");
+      return -1;
+    }
+  }
+  if(nc->dynpal == NULL){
+    if(registers == 0){
+      return 0;
+    }
+    dynpalette* dp = malloc(sizeof(*dp));
+    if(dp == NULL){
+      return -1;
+    }
+    memset(dp, 0, sizeof(*dp));
+    memset(dp->map, 0xff, sizeof(dp->map));
+    dp->lowreg = 256;
+    dp->initclen = strlen(tiparm(initc, 255, 1000, 1000, 1000));
+    nc->dynpal = dp;
+  }
+  nc->dynpal->count = registers;
+  nc->dynpal->rebuild = true;
+  loginfo("dynamic palette registers: %u", registers);
+  return 0;
+}
+
+// prepare nc->fidelity for a degraded frame. it's seeded from the lastframe,
+// which was rasterized at full fidelity (or else fidelity would already be
+// seeded, unless the geometry changed, in which case everything is damaged).
+static int
+prep_fidelity(notcurses* nc, const ncpile* p){
+  const size_t cells = (size_t)p->dimy * p->dimx;
+  if(nc->fidelity && nc->fidelitylen == cells){
+    return 0;
+  }
+  uint64_t* tmp = realloc(nc->fidelity, sizeof(*tmp) * cells);
+  if(tmp == NULL){
+    return -1;
+  }
+  for(size_t i = 0 ; i < cells ; ++i){
+    tmp[i] = nc->lastframe[i].channels;
+  }
+  nc->fidelity = tmp;
+  nc->fidelitylen = cells;
+  return 0;
+}
+
+// refill the token bucket, charge it for the frame just written, and adjust
+// the degradation level. we degrade further if we couldn't afford another
+// frame like this one, and relax once half the bucket has refilled.
+static void
+update_degradation(notcurses* nc, int bytes){
+  const uint64_t now = clock_getns(CLOCK_MONOTONIC);
+  uint64_t elapsed = now - nc->bwlastns;
+  if(elapsed > NANOSECS_IN_SEC){
+    elapsed = NANOSECS_IN_SEC;
+  }
+  nc->bwlastns = now;
+  nc->bwcredit += elapsed * nc->bwbudget / NANOSECS_IN_SEC;
+  if(nc->bwcredit > (int64_t)nc->bwbudget){
+    nc->bwcredit = nc->bwbudget;
+  }
+  if(bytes > 0){
+    nc->bwcredit -= bytes;
+  }
+  if(nc->bwcredit < bytes){
+    if(nc->degrade < NCDEGRADE_MAX){
+      ++nc->degrade;
+      loginfo("degrading output to level %u", nc->degrade);
+    }
+  }else if(nc->degrade && nc->bwcredit >= (int64_t)(nc->bwbudget / 2)){
+    --nc->degrade;
+    loginfo("restoring output to level %u", nc->degrade);
+  }
+}
+
 int ncpile_rasterize(ncplane* n){
-  struct timespec start, rasterdone, writedone;
+  struct timespec start, writedone;
   clock_gettime(CLOCK_MONOTONIC, &start);
   ncpile* pile = ncplane_pile(n);
   struct notcurses* nc = ncpile_notcurses(pile);
-  const struct tinfo* ti = &ncplane_notcurses_const(n)->tcache;
-  postpaint(nc, ti, nc->lastframe, pile->dimy, pile->dimx, pile->crender, &nc->pool);
-  clock_gettime(CLOCK_MONOTONIC, &rasterdone);
-  int bytes = notcurses_rasterize(nc, pile, &nc->rstate.f);
+  unsigned degrade = nc->degrade;
+  if(degrade == 0){
+    free(nc->fidelity);
+    nc->fidelity = NULL;
+  }else if(prep_fidelity(nc, pile)){
+    degrade = 0;
+  }
+  const uint64_t degraded0 = nc->stats.s.degraded_cells;
+  const uint64_t emissions0 = nc->stats.s.cellemissions;
+  // a sink wanting a keyframe gets what's on the screen, before this frame's
+  // delta. lastframe hasn't yet been postpainted with this frame.
+  if(ncsinks_take_keyframe(nc)){
+    publish_sink_keyframe(nc);
+  }
+  if(nc->last_pile && nc->last_pile != pile){
+    nc->rstate.leaving = nc->last_pile;
+  }
+  // postpainting is fused into rasterization
+  nc->rstate.rasterdone = start;
+  int bytes = notcurses_rasterize(nc, pile, &nc->rstate.f, SINKFRAME_DELTA, degrade);
+  nc->rstate.leaving = NULL; // in case we failed before consuming it
   clock_gettime(CLOCK_MONOTONIC, &writedone);
+  if(nc->bwbudget){
+    update_degradation(nc, bytes);
+  }
   pthread_mutex_lock(&nc->stats.lock);
     // accepts negative |bytes| as an indication of failure
     update_raster_bytes(&nc->stats.s, bytes);
-    update_raster_stats(&rasterdone, &start, &nc->stats.s);
-    update_write_stats(&writedone, &rasterdone, &nc->stats.s, bytes);
+    update_raster_stats(&nc->rstate.rasterdone, &start, &nc->stats.s);
+    update_write_stats(&writedone, &nc->rstate.rasterdone, &nc->stats.s, bytes);
+    if(degrade && bytes > 0){
+      // estimate each absorbed update at the mean cost of an emitted cell
+      const uint64_t emitted = nc->stats.s.cellemissions - emissions0;
+      ++nc->stats.s.degraded_frames;
+      if(emitted){
+        nc->stats.s.degraded_bytes += (nc->stats.s.degraded_cells - degraded0)
+                                      * bytes / emitted;
+      }
+    }
+    nc->stats.s.degradation = nc->degrade;
   pthread_mutex_unlock(&nc->stats.lock);
   // we want to refresh if the screen geometry changed (or if we were just
   // woken up from SIGSTOP), but we mustn't do so until after rasterizing
@@ -1543,8 +2605,9 @@ int ncpile_rasterize(ncplane* n){
   return 0;
 }
 
-// ensure the crender vector of 'n' is properly sized for 'n'->dimy x 'n'->dimx,
-// and initialize the rvec afresh for a new render.
+// ensure the crender vector of 'n' is large enough for 'n'->dimy x 'n'->dimx,
+// and initialize the rvec afresh for a new render. the vector never shrinks,
+// so oscillating geometries don't hit the allocator.
 static int
 engorge_crender_vector(ncpile* p){
   if(p->dimy <= 0 || p->dimx <= 0){
@@ -1552,7 +2615,7 @@ engorge_crender_vector(ncpile* p){
   }
   const size_t crenderlen = p->dimy * p->dimx; // desired size
 //fprintf(stderr, "crlen: %d y: %d x:%d\n", crenderlen, dimy, dimx);
-  if(crenderlen != p->crenderlen){
+  if(crenderlen > p->crenderlen){
     loginfo("resizing rvec (%" PRIuPTR ") for %p to %" PRIuPTR,
             p->crenderlen, p, crenderlen);
     struct crender* tmp = realloc(p->crender, sizeof(*tmp) * crenderlen);
@@ -1599,7 +2662,7 @@ int ncpile_render_to_buffer(ncplane* p, char** buf, size_t* buflen){
   notcurses* nc = ncplane_notcurses(p);
   unsigned useasu = false; // no SUM with file
   fbuf_reset(&nc->rstate.f);
-  int bytes = notcurses_rasterize_inner(nc, ncplane_pile(p), &nc->rstate.f, &useasu);
+  int bytes = notcurses_rasterize_inner(nc, ncplane_pile(p), &nc->rstate.f, &useasu, -1);
   pthread_mutex_lock(&nc->stats.lock);
     update_raster_bytes(&nc->stats.s, bytes);
   pthread_mutex_unlock(&nc->stats.lock);
@@ -1665,18 +2728,11 @@ int ncdirect_set_bg_rgb_f(ncdirect* nc, unsigned rgb, fbuf* f){
 }
 
 int ncdirect_set_bg_rgb(ncdirect* nc, unsigned rgb){
-  fbuf f = {0};
-  if(fbuf_init_small(&f)){
-    return -1;
-  }
-  if(ncdirect_set_bg_rgb_f(nc, rgb, &f)){
-    fbuf_free(&f);
-    return -1;
-  }
-  if(fbuf_finalize(&f, nc->ttyfp) < 0){
+  if(ncdirect_set_bg_rgb_f(nc, rgb, &nc->obuf)){
+    fbuf_reset(&nc->obuf);
     return -1;
   }
-  return 0;
+  return ncdirect_commit_obuf(nc, true);
 }
 
 int ncdirect_set_fg_rgb_f(ncdirect* nc, unsigned rgb, fbuf* f){
@@ -1695,18 +2751,11 @@ int ncdirect_set_fg_rgb_f(ncdirect* nc, unsigned rgb, fbuf* f){
 }
 
 int ncdirect_set_fg_rgb(ncdirect* nc, unsigned rgb){
-  fbuf f = {0};
-  if(fbuf_init_small(&f)){
+  if(ncdirect_set_fg_rgb_f(nc, rgb, &nc->obuf)){
+    fbuf_reset(&nc->obuf);
     return -1;
   }
-  if(ncdirect_set_fg_rgb_f(nc, rgb, &f)){
-    fbuf_free(&f);
-    return -1;
-  }
-  if(fbuf_finalize(&f, nc->ttyfp) < 0){
-    return -1;
-  }
-  return 0;
+  return ncdirect_commit_obuf(nc, true);
 }
 
 int notcurses_default_foreground(const struct notcurses* nc, uint32_t* fg){
@@ -0,0 +1,472 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "internal.h"
+
+// rows scrolled off the top of a plane are encoded and appended to pages of
+// roughly SB_PAGE_BYTES. each row is
+//
+//   varint rowbytes (not including itself)
+//   varint cells (trailing zeroed cells are dropped)
+//   runs of: varint cells, varint stylemask, varint channels, glyphs
+//
+// a glyph is a single byte 0x01..0x7f for a one-column ASCII character, and
+// otherwise 0x80, varint width, varint bytes, and the EGC's bytes. ASCII text
+// thus costs about a byte per cell, plus a few bytes per change of attributes.
+// full pages are "sealed", and spilled to disk once more than maxresident
+// bytes of sealed pages are in memory.
+
+#define SB_PAGE_BYTES 65536u
+
+typedef struct sbpage {
+  unsigned char* data; // NULL if spilled
+  size_t len;          // bytes of encoded rows
+  off_t fileoff;       // offset within the spill file, if spilled
+  uint64_t firstrow;   // absolute index of the first row
+  unsigned rows;
+} sbpage;
+
+typedef struct ncscrollback {
+  sbpage* pages;       // oldest first. the last page is open for appending.
+  unsigned pagecount, pagecap;
+  uint64_t firstrow;   // absolute index of the oldest retained row
+  uint64_t nextrow;    // absolute index of the next row to be pushed
+  size_t resident;     // bytes of sealed pages in memory
+  unsigned maxrows;
+  size_t maxresident;
+  char* spilldir;
+  int spillfd;         // -1 until something is spilled
+  off_t spillend;      // next (page-aligned) free offset in the spill file
+  unsigned char* map;  // the one spilled page currently mapped, if any
+  size_t maplen;
+  off_t mapoff;
+  unsigned char* rowbuf; // scratch for encoding
+  size_t rowcap;
+} ncscrollback;
+
+static inline unsigned char*
+put_varint(unsigned char* p, uint64_t v){
+  while(v >= 0x80){
+    *p++ = (v & 0x7f) | 0x80;
+    v >>= 7;
+  }
+  *p++ = v;
+  return p;
+}
+
+static inline const unsigned char*
+get_varint(const unsigned char* p, uint64_t* v){
+  uint64_t r = 0;
+  unsigned shift = 0;
+  while(*p & 0x80){
+    r |= (uint64_t)(*p++ & 0x7f) << shift;
+    shift += 7;
+  }
+  *v = r | ((uint64_t)*p++ << shift);
+  return p;
+}
+
+static inline bool
+cell_zeroed_p(const nccell* c){
+  return !c->gcluster && !c->width && !c->stylemask && !c->channels;
+}
+
+// ensure the scratch row can take another 'need' bytes past 'p', returning
+// the (possibly moved) write pointer, or NULL on allocation failure.
+static unsigned char*
+rowbuf_reserve(ncscrollback* sb, unsigned char* p, size_t need){
+  size_t used = p - sb->rowbuf;
+  if(used + need <= sb->rowcap){
+    return p;
+  }
+  size_t cap = sb->rowcap * 2;
+  while(cap < used + need){
+    cap *= 2;
+  }
+  unsigned char* tmp = realloc(sb->rowbuf, cap);
+  if(tmp == NULL){
+    return NULL;
+  }
+  sb->rowbuf = tmp;
+  sb->rowcap = cap;
+  return tmp + used;
+}
+
+// encode row 'y' of 'n' into the scratch buffer, returning its length.
+static ssize_t
+encode_row(ncscrollback* sb, const ncplane* n, unsigned y){
+  unsigned cells = n->lenx;
+  while(cells && cell_zeroed_p(ncplane_cell_peek_yx(n, y, cells - 1))){
+    --cells;
+  }
+  // worst case for the counts; glyphs are reserved as we go
+  unsigned char* p = rowbuf_reserve(sb, sb->rowbuf, 10);
+  if(p == NULL){
+    return -1;
+  }
+  p = put_varint(p, cells);
+  unsigned x = 0;
+  while(x < cells){
+    const nccell* c = ncplane_cell_peek_yx(n, y, x);
+    const uint16_t stylemask = c->stylemask;
+    const uint64_t channels = c->channels;
+    unsigned run = 1;
+    while(x + run < cells){
+      c = ncplane_cell_peek_yx(n, y, x + run);
+      if(c->stylemask != stylemask || c->channels != channels){
+        break;
+      }
+      ++run;
+    }
+    if((p = rowbuf_reserve(sb, p, 30)) == NULL){
+      return -1;
+    }
+    p = put_varint(p, run);
+    p = put_varint(p, stylemask);
+    p = put_varint(p, channels);
+    for(unsigned i = 0 ; i < run ; ++i){
+      c = ncplane_cell_peek_yx(n, y, x + i);
+      const char* egc = nccell_extended_gcluster(n, c);
+      size_t len = cell_extended_p(c) ? strlen(egc) : strnlen(egc, 4);
+      if((p = rowbuf_reserve(sb, p, len + 21)) == NULL){
+        return -1;
+      }
+      if(len == 1 && c->width == 1 && *(const unsigned char*)egc < 0x80){
+        *p++ = *egc;
+      }else{
+        *p++ = 0x80;
+        p = put_varint(p, c->width);
+        p = put_varint(p, len);
+        memcpy(p, egc, len);
+        p += len;
+      }
+    }
+    x += run;
+  }
+  return p - sb->rowbuf;
+}
+
+static int
+spill_open(ncscrollback* sb){
+  const char* dir = sb->spilldir;
+  if(dir == NULL && (dir = getenv("TMPDIR")) == NULL){
+    dir = "/tmp";
+  }
+  size_t len = strlen(dir) + strlen("/ncscrollback-XXXXXX") + 1;
+  char* path = malloc(len);
+  if(path == NULL){
+    return -1;
+  }
+  snprintf(path, len, "%s/ncscrollback-XXXXXX", dir);
+  int fd = mkstemp(path);
+  if(fd < 0){
+    logerror("couldn't create spill file %s (%s)", path, strerror(errno));
+    free(path);
+    return -1;
+  }
+  // nobody else need ever see it
+  unlink(path);
+  loginfo("spilling scrollback to %s", path);
+  free(path);
+  sb->spillfd = fd;
+  sb->spillend = 0;
+  return 0;
+}
+
+static void
+unmap_page(ncscrollback* sb){
+  if(sb->map){
+    munmap(sb->map, sb->maplen);
+    sb->map = NULL;
+  }
+}
+
+// write a sealed page out to the spill file, and free its memory.
+static int
+spill_page(ncscrollback* sb, sbpage* pg){
+  if(sb->spillfd < 0 && spill_open(sb)){
+    return -1;
+  }
+  size_t written = 0;
+  while(written < pg->len){
+    ssize_t w = pwrite(sb->spillfd, pg->data + written, pg->len - written,
+                       sb->spillend + written);
+    if(w < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      logerror("error spilling scrollback (%s)", strerror(errno));
+      return -1;
+    }
+    written += w;
+  }
+  const size_t pgsize = sysconf(_SC_PAGESIZE);
+  pg->fileoff = sb->spillend;
+  sb->spillend += (pg->len + pgsize - 1) / pgsize * pgsize;
+  free(pg->data);
+  pg->data = NULL;
+  sb->resident -= pg->len;
+  return 0;
+}
+
+// return the encoded rows of page 'pg', mapping them in if necessary.
+static const unsigned char*
+page_data(ncscrollback* sb, const sbpage* pg){
+  if(pg->data){
+    return pg->data;
+  }
+  if(sb->map && sb->mapoff == pg->fileoff){
+    return sb->map;
+  }
+  unmap_page(sb);
+  void* map = mmap(NULL, pg->len, PROT_READ, MAP_SHARED, sb->spillfd, pg->fileoff);
+  if(map == MAP_FAILED){
+    logerror("couldn't map scrollback page (%s)", strerror(errno));
+    return NULL;
+  }
+  sb->map = map;
+  sb->maplen = pg->len;
+  sb->mapoff = pg->fileoff;
+  return sb->map;
+}
+
+static void
+drop_page(ncscrollback* sb){
+  sbpage* pg = &sb->pages[0];
+  if(pg->data){
+    sb->resident -= pg->len;
+    free(pg->data);
+  }else{
+    if(sb->map && sb->mapoff == pg->fileoff){
+      unmap_page(sb);
+    }
+#ifdef __linux__
+    // return the disk space; it's no disaster if we can't
+    fallocate(sb->spillfd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+              pg->fileoff, pg->len);
+#endif
+  }
+  sb->firstrow = sb->pages[1].firstrow;
+  memmove(sb->pages, sb->pages + 1, sizeof(*sb->pages) * --sb->pagecount);
+}
+
+// seal the open page and start a new one
+static int
+new_page(ncscrollback* sb){
+  if(sb->pagecount == sb->pagecap){
+    unsigned cap = sb->pagecap ? sb->pagecap * 2 : 8;
+    sbpage* tmp = realloc(sb->pages, sizeof(*tmp) * cap);
+    if(tmp == NULL){
+      return -1;
+    }
+    sb->pages = tmp;
+    sb->pagecap = cap;
+  }
+  unsigned char* data = malloc(SB_PAGE_BYTES);
+  if(data == NULL){
+    return -1;
+  }
+  if(sb->pagecount){
+    sbpage* sealed = &sb->pages[sb->pagecount - 1];
+    // shrink it to fit
+    unsigned char* tmp = realloc(sealed->data, sealed->len);
+    if(tmp){
+      sealed->data = tmp;
+    }
+    sb->resident += sealed->len;
+  }
+  sbpage* pg = &sb->pages[sb->pagecount++];
+  pg->data = data;
+  pg->len = 0;
+  pg->fileoff = 0;
+  pg->firstrow = sb->nextrow;
+  pg->rows = 0;
+  if(sb->maxresident){
+    for(unsigned i = 0 ; i + 1 < sb->pagecount && sb->resident > sb->maxresident ; ++i){
+      if(sb->pages[i].data && spill_page(sb, &sb->pages[i])){
+        break; // keep everything in memory, then
+      }
+    }
+  }
+  return 0;
+}
+
+int ncscrollback_push(ncplane* n, unsigned y){
+  ncscrollback* sb = n->scrollback;
+  ssize_t len = encode_row(sb, n, y);
+  if(len < 0){
+    return -1;
+  }
+  unsigned char hdr[10];
+  size_t hlen = put_varint(hdr, len) - hdr;
+  sbpage* pg = &sb->pages[sb->pagecount - 1];
+  if(pg->rows && pg->len + hlen + len > SB_PAGE_BYTES){
+    if(new_page(sb)){
+      return -1;
+    }
+    pg = &sb->pages[sb->pagecount - 1];
+  }
+  // a single row can exceed a page
+  if(hlen + len > SB_PAGE_BYTES){
+    unsigned char* tmp = realloc(pg->data, hlen + len);
+    if(tmp == NULL){
+      return -1;
+    }
+    pg->data = tmp;
+  }
+  memcpy(pg->data + pg->len, hdr, hlen);
+  memcpy(pg->data + pg->len + hlen, sb->rowbuf, len);
+  pg->len += hlen + len;
+  ++pg->rows;
+  ++sb->nextrow;
+  if(sb->maxrows){
+    while(sb->pagecount > 1 && sb->nextrow - sb->pages[1].firstrow >= sb->maxrows){
+      drop_page(sb);
+    }
+  }
+  return 0;
+}
+
+void ncscrollback_destroy(ncscrollback* sb){
+  if(sb){
+    for(unsigned i = 0 ; i < sb->pagecount ; ++i){
+      free(sb->pages[i].data);
+    }
+    free(sb->pages);
+    unmap_page(sb);
+    if(sb->spillfd >= 0){
+      close(sb->spillfd);
+    }
+    free(sb->spilldir);
+    free(sb->rowbuf);
+    free(sb);
+  }
+}
+
+int ncplane_set_scrollback(ncplane* n, const ncscrollback_options* opts){
+  if(opts == NULL){
+    ncscrollback_destroy(n->scrollback);
+    n->scrollback = NULL;
+    return 0;
+  }
+  if(opts->flags){
+    logwarn("provided unsupported flags %016" PRIx64, opts->flags);
+  }
+  ncscrollback* sb = malloc(sizeof(*sb));
+  if(sb == NULL){
+    return -1;
+  }
+  memset(sb, 0, sizeof(*sb));
+  sb->spillfd = -1;
+  sb->maxrows = opts->maxrows;
+  sb->maxresident = opts->maxresident;
+  sb->rowcap = 256;
+  if((sb->rowbuf = malloc(sb->rowcap)) == NULL){
+    goto err;
+  }
+  if(opts->spilldir && (sb->spilldir = strdup(opts->spilldir)) == NULL){
+    goto err;
+  }
+  if(new_page(sb)){
+    goto err;
+  }
+  ncscrollback_destroy(n->scrollback);
+  n->scrollback = sb;
+  return 0;
+
+err:
+  ncscrollback_destroy(sb);
+  return -1;
+}
+
+unsigned ncplane_scrollback_rows(const ncplane* n){
+  const ncscrollback* sb = n->scrollback;
+  return sb ? sb->nextrow - sb->firstrow : 0;
+}
+
+// decode the row at 'p' into row 'y' of 'dst', returning the following row.
+static const unsigned char*
+decode_row(const unsigned char* p, ncplane* dst, unsigned y){
+  uint64_t rowbytes, cells;
+  p = get_varint(p, &rowbytes);
+  const unsigned char* next = p + rowbytes;
+  p = get_varint(p, &cells);
+  unsigned x = 0;
+  while(x < cells){
+    uint64_t run, stylemask, channels;
+    p = get_varint(p, &run);
+    p = get_varint(p, &stylemask);
+    p = get_varint(p, &channels);
+    for(unsigned i = 0 ; i < run ; ++i, ++x){
+      const char* egc = (const char*)p;
+      uint64_t width = 1, len = 1;
+      if(*p++ & 0x80){
+        p = get_varint(p, &width);
+        p = get_varint(p, &len);
+        egc = (const char*)p;
+        p += len;
+      }
+      if(x < dst->lenx){
+        nccell* c = ncplane_cell_ref_yx(dst, y, x);
+        pool_blit_direct(&dst->pool, c, egc, len, width);
+        c->stylemask = stylemask;
+        c->channels = channels;
+      }
+    }
+  }
+  for( ; x < dst->lenx ; ++x){
+    nccell* c = ncplane_cell_ref_yx(dst, y, x);
+    nccell_release(dst, c);
+    nccell_init(c);
+  }
+  return next;
+}
+
+int ncplane_scrollback_window(ncplane* n, unsigned back, ncplane* dst){
+  if(dst == n){
+    logerror("can't draw scrollback onto its own plane");
+    return -1;
+  }
+  ncscrollback* sb = n->scrollback;
+  uint64_t row = sb ? sb->nextrow : 0;
+  if(sb){
+    row = back > sb->nextrow - sb->firstrow ? sb->firstrow : sb->nextrow - back;
+  }
+  unsigned y = 0;
+  if(sb && row < sb->nextrow){
+    // find the page holding our first row, and skip to it
+    unsigned pidx = sb->pagecount - 1;
+    while(sb->pages[pidx].firstrow > row){
+      --pidx;
+    }
+    const unsigned char* p = page_data(sb, &sb->pages[pidx]);
+    if(p == NULL){
+      return -1;
+    }
+    for(uint64_t r = sb->pages[pidx].firstrow ; r < row ; ++r){
+      uint64_t rowbytes;
+      p = get_varint(p, &rowbytes) + rowbytes;
+    }
+    while(y < dst->leny && row < sb->nextrow){
+      if(row == sb->pages[pidx].firstrow + sb->pages[pidx].rows){
+        if((p = page_data(sb, &sb->pages[++pidx])) == NULL){
+          return -1;
+        }
+      }
+      p = decode_row(p, dst, y++);
+      ++row;
+    }
+  }
+  const int fromsb = y;
+  for(unsigned ly = 0 ; y < dst->leny ; ++y, ++ly){
+    for(unsigned x = 0 ; x < dst->lenx ; ++x){
+      nccell* c = ncplane_cell_ref_yx(dst, y, x);
+      if(ly < n->leny && x < n->lenx){
+        cell_duplicate_far(&dst->pool, c, n, ncplane_cell_peek_yx(n, ly, x));
+      }else{
+        nccell_release(dst, c);
+        nccell_init(c);
+      }
+    }
+  }
+  return fromsb;
+}
@@ -0,0 +1,440 @@
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "internal.h"
+
+// output sinks. each frame written to the terminal is copied once into a
+// refcounted ncsinkframe, which is then queued (by reference) to every sink.
+// each sink has its own thread draining its queue, so a slow sink can delay
+// only itself, unless it asked for backpressure with NCSINK_OPTION_BLOCK.
+// the list of sinks is guarded by nc->sinklock, held across each publication
+// (including any NCSINK_OPTION_BLOCK wait), but not while a sink is joined.
+
+#define NCSINK_DEFAULT_MAXQUEUE (4u * 1024 * 1024)
+
+typedef struct ncsinkframe {
+  atomic_uint refs;     // one per queue holding us, plus one for the publisher
+  uint64_t ns;          // CLOCK_MONOTONIC time of rasterization
+  unsigned dimy, dimx;  // terminal geometry at rasterization
+  size_t len;
+  char buf[];
+} ncsinkframe;
+
+typedef struct ncsink {
+  notcurses* nc;
+  struct ncsink* next;          // list rooted at nc->sinks
+  int (*writer)(struct ncsink*, const ncsinkframe*);
+  ncsink_callback cb;           // user callback, or NULL
+  void* curry;
+  int fd;                       // target of the fd and asciicast writers
+  ncsinkframe** queue;          // ring of pending frames
+  unsigned qcap, qhead, qcount;
+  size_t queued;                // bytes pending in the queue
+  size_t maxqueue;              // bytes which may be pending
+  uint64_t dropped;             // frames discarded
+  bool block;                   // wait for space rather than dropping
+  bool needkey;                 // dropped a frame; skip to the next keyframe
+  bool stopping;                // set by ncsink_destroy()
+  bool failed;                  // writer failed; frames are now discarded
+  pthread_t tid;
+  pthread_mutex_t lock;         // guards the queue and the flags above
+  pthread_cond_t cond;          // signaled on enqueue, dequeue, and stop
+  // asciicast state
+  uint64_t startns;             // event times are relative to this
+  unsigned castdimy, castdimx;  // last geometry announced
+  fbuf json;                    // scratch for escaping each event
+} ncsink;
+
+static void
+ncsinkframe_release(ncsinkframe* f){
+  if(atomic_fetch_sub(&f->refs, 1) == 1){
+    free(f);
+  }
+}
+
+static int
+sink_write_fd(ncsink* s, const ncsinkframe* f){
+  return blocking_write(s->fd, f->buf, f->len);
+}
+
+static int
+sink_write_cb(ncsink* s, const ncsinkframe* f){
+  return s->cb(s, f->buf, f->len, f->ns, s->curry);
+}
+
+// append |len| bytes of |buf| as the body of a JSON string
+static int
+json_escape(fbuf* f, const char* buf, size_t len){
+  static const char hex[] = "0123456789abcdef";
+  for(size_t i = 0 ; i < len ; ++i){
+    unsigned char c = buf[i];
+    int r;
+    if(c == '"' || c == '\\'){
+      char esc[2] = { '\\', c };
+      r = fbuf_putn(f, esc, sizeof(esc));
+    }else if(c == '\n'){
+      r = fbuf_putn(f, "\\n", 2);
+    }else if(c == '\r'){
+      r = fbuf_putn(f, "\\r", 2);
+    }else if(c == '\t'){
+      r = fbuf_putn(f, "\\t", 2);
+    }else if(c < 0x20 || c == 0x7f){
+      char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4u], hex[c & 0xfu] };
+      r = fbuf_putn(f, esc, sizeof(esc));
+    }else{
+      r = fbuf_putc(f, c);
+    }
+    if(r < 0){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// one "o" event per frame, preceded by an "r" event if the geometry changed.
+static int
+sink_write_asciicast(ncsink* s, const ncsinkframe* f){
+  fbuf_reset(&s->json);
+  uint64_t rel = f->ns > s->startns ? f->ns - s->startns : 0;
+  unsigned secs = rel / NANOSECS_IN_SEC;
+  unsigned usecs = (rel % NANOSECS_IN_SEC) / 1000;
+  if(f->dimy != s->castdimy || f->dimx != s->castdimx){
+    if(fbuf_printf(&s->json, "[%u.%06u, \"r\", \"%ux%u\"]\n",
+                   secs, usecs, f->dimx, f->dimy) < 0){
+      return -1;
+    }
+    s->castdimy = f->dimy;
+    s->castdimx = f->dimx;
+  }
+  if(fbuf_printf(&s->json, "[%u.%06u, \"o\", \"", secs, usecs) < 0){
+    return -1;
+  }
+  if(json_escape(&s->json, f->buf, f->len)){
+    return -1;
+  }
+  if(fbuf_putn(&s->json, "\"]\n", 3) < 0){
+    return -1;
+  }
+  return blocking_write(s->fd, s->json.buf, s->json.used);
+}
+
+static void*
+sink_thread(void* vs){
+  ncsink* s = vs;
+  for(;;){
+    pthread_mutex_lock(&s->lock);
+    while(s->qcount == 0 && !s->stopping){
+      pthread_cond_wait(&s->cond, &s->lock);
+    }
+    if(s->qcount == 0){
+      pthread_mutex_unlock(&s->lock);
+      break;
+    }
+    ncsinkframe* f = s->queue[s->qhead];
+    s->qhead = (s->qhead + 1) % s->qcap;
+    --s->qcount;
+    s->queued -= f->len;
+    bool failed = s->failed;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+    if(!failed && s->writer(s, f)){
+      logerror("sink %p failed; discarding further output", s);
+      pthread_mutex_lock(&s->lock);
+      s->failed = true;
+      pthread_mutex_unlock(&s->lock);
+    }
+    ncsinkframe_release(f);
+  }
+  return NULL;
+}
+
+static ncsink*
+ncsink_create_internal(notcurses* nc, const ncsink_options* opts, int fd,
+                       ncsink_callback cbfxn){
+  ncsink_options zeroed = {0};
+  if(opts == NULL){
+    opts = &zeroed;
+  }
+  if(opts->flags > NCSINK_OPTION_BLOCK){
+    logwarn("provided unsupported flags %016" PRIx64, opts->flags);
+  }
+  if(cbfxn == NULL && fd < 0){
+    logerror("need a callback or an fd");
+    return NULL;
+  }
+  ncsink* s = malloc(sizeof(*s));
+  if(s == NULL){
+    return NULL;
+  }
+  memset(s, 0, sizeof(*s));
+  s->nc = nc;
+  s->cb = cbfxn;
+  s->curry = opts->curry;
+  s->fd = fd;
+  s->writer = cbfxn ? sink_write_cb : sink_write_fd;
+  s->maxqueue = opts->maxqueue ? opts->maxqueue : NCSINK_DEFAULT_MAXQUEUE;
+  s->block = opts->flags & NCSINK_OPTION_BLOCK;
+  s->qcap = 16;
+  if((s->queue = malloc(sizeof(*s->queue) * s->qcap)) == NULL){
+    free(s);
+    return NULL;
+  }
+  if(pthread_mutex_init(&s->lock, NULL)){
+    free(s->queue);
+    free(s);
+    return NULL;
+  }
+  if(pthread_cond_init(&s->cond, NULL)){
+    pthread_mutex_destroy(&s->lock);
+    free(s->queue);
+    free(s);
+    return NULL;
+  }
+  return s;
+}
+
+// start the thread and link the sink into |nc|'s list
+static ncsink*
+ncsink_launch(ncsink* s){
+  // a new sink knows nothing of what's on the screen
+  s->needkey = true;
+  if(pthread_create(&s->tid, NULL, sink_thread, s)){
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->lock);
+    fbuf_free(&s->json);
+    free(s->queue);
+    free(s);
+    return NULL;
+  }
+  pthread_mutex_lock(&s->nc->sinklock);
+  s->next = s->nc->sinks;
+  s->nc->sinks = s;
+  s->nc->sinkkeyframe = true;
+  pthread_mutex_unlock(&s->nc->sinklock);
+  loginfo("launched sink %p (maxqueue %zuB)", s, s->maxqueue);
+  return s;
+}
+
+ncsink* ncsink_create(notcurses* nc, const ncsink_options* opts, int fd,
+                      ncsink_callback cbfxn){
+  ncsink* s = ncsink_create_internal(nc, opts, fd, cbfxn);
+  if(s == NULL){
+    return NULL;
+  }
+  return ncsink_launch(s);
+}
+
+ncsink* ncsink_asciicast(notcurses* nc, const ncsink_options* opts, int fd){
+  ncsink* s = ncsink_create_internal(nc, opts, fd, NULL);
+  if(s == NULL){
+    return NULL;
+  }
+  s->writer = sink_write_asciicast;
+  s->startns = clock_getns(CLOCK_MONOTONIC);
+  notcurses_term_dim_yx(nc, &s->castdimy, &s->castdimx);
+  if(fbuf_init_small(&s->json) == 0){
+    if(fbuf_printf(&s->json, "{\"version\": 2, \"width\": %u, \"height\": %u, "
+                   "\"timestamp\": %lld}\n", s->castdimx, s->castdimy,
+                   (long long)time(NULL)) > 0){
+      if(blocking_write(fd, s->json.buf, s->json.used) == 0){
+        return ncsink_launch(s);
+      }
+    }
+  }
+  fbuf_free(&s->json);
+  pthread_cond_destroy(&s->cond);
+  pthread_mutex_destroy(&s->lock);
+  free(s->queue);
+  free(s);
+  return NULL;
+}
+
+uint64_t ncsink_dropped(ncsink* s){
+  pthread_mutex_lock(&s->lock);
+  uint64_t ret = s->dropped;
+  pthread_mutex_unlock(&s->lock);
+  return ret;
+}
+
+int ncsink_destroy(ncsink* s){
+  if(s == NULL){
+    return 0;
+  }
+  pthread_mutex_lock(&s->nc->sinklock);
+  for(ncsink** prev = &s->nc->sinks ; *prev ; prev = &(*prev)->next){
+    if(*prev == s){
+      *prev = s->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&s->nc->sinklock);
+  pthread_mutex_lock(&s->lock);
+  s->stopping = true;
+  pthread_cond_broadcast(&s->cond);
+  pthread_mutex_unlock(&s->lock);
+  int ret = pthread_join(s->tid, NULL) ? -1 : 0;
+  if(s->failed){
+    ret = -1;
+  }
+  pthread_cond_destroy(&s->cond);
+  pthread_mutex_destroy(&s->lock);
+  fbuf_free(&s->json);
+  free(s->queue);
+  free(s);
+  return ret;
+}
+
+int ncsinks_destroy(notcurses* nc){
+  int ret = 0;
+  ncsink* s;
+  do{
+    pthread_mutex_lock(&nc->sinklock);
+    s = nc->sinks;
+    pthread_mutex_unlock(&nc->sinklock);
+    ret |= ncsink_destroy(s);
+  }while(s);
+  return ret;
+}
+
+bool ncsinks_take_keyframe(notcurses* nc){
+  pthread_mutex_lock(&nc->sinklock);
+  bool ret = nc->sinkkeyframe;
+  nc->sinkkeyframe = false;
+  pthread_mutex_unlock(&nc->sinklock);
+  return ret;
+}
+
+// queue |f| to |s|, applying its backpressure policy. call with sinklock held.
+static void
+ncsink_enqueue(notcurses* nc, ncsink* s, ncsinkframe* f, bool keyframe){
+  pthread_mutex_lock(&s->lock);
+  if(keyframe && !s->needkey){
+    // keyframes are built only for resynchronization; this sink is in sync
+    pthread_mutex_unlock(&s->lock);
+    return;
+  }
+  if(s->needkey && !keyframe){
+    // the sink has lost frames, and deltas are useless until a keyframe
+    // resynchronizes it. ask for one once there's room to accept it.
+    ++s->dropped;
+    if(s->queued <= s->maxqueue / 2){
+      nc->sinkkeyframe = true;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return;
+  }
+  // an empty queue always accepts a frame, however large
+  while(s->queued && s->queued + f->len > s->maxqueue){
+    if(!s->block){
+      ++s->dropped;
+      s->needkey = true;
+      pthread_mutex_unlock(&s->lock);
+      return;
+    }
+    pthread_cond_wait(&s->cond, &s->lock);
+  }
+  if(s->qcount == s->qcap){
+    ncsinkframe** tmp = malloc(sizeof(*tmp) * s->qcap * 2);
+    if(tmp == NULL){
+      ++s->dropped;
+      s->needkey = true;
+      pthread_mutex_unlock(&s->lock);
+      return;
+    }
+    for(unsigned i = 0 ; i < s->qcount ; ++i){
+      tmp[i] = s->queue[(s->qhead + i) % s->qcap];
+    }
+    free(s->queue);
+    s->queue = tmp;
+    s->qhead = 0;
+    s->qcap *= 2;
+  }
+  atomic_fetch_add(&f->refs, 1);
+  s->queue[(s->qhead + s->qcount) % s->qcap] = f;
+  ++s->qcount;
+  s->queued += f->len;
+  s->needkey = false;
+  pthread_cond_broadcast(&s->cond);
+  pthread_mutex_unlock(&s->lock);
+}
+
+// allocate a sink frame of |len| bytes, to be filled in by the caller.
+static ncsinkframe*
+ncsinkframe_alloc(notcurses* nc, size_t len){
+  ncsinkframe* f = malloc(sizeof(*f) + len);
+  if(f == NULL){
+    return NULL;
+  }
+  atomic_init(&f->refs, 1);
+  f->ns = clock_getns(CLOCK_MONOTONIC);
+  f->dimy = nc->tcache.dimy;
+  f->dimx = nc->tcache.dimx;
+  f->len = len;
+  return f;
+}
+
+// hand a filled-in frame to each sink, dropping our reference. call with
+// sinklock held.
+static void
+ncsinks_enqueue_all(notcurses* nc, ncsinkframe* f, bool keyframe){
+  for(ncsink* s = nc->sinks ; s ; s = s->next){
+    ncsink_enqueue(nc, s, f, keyframe);
+  }
+  ncsinkframe_release(f);
+}
+
+int ncsinks_publish(notcurses* nc, const char* buf, size_t len, bool keyframe){
+  if(len == 0){
+    return 0;
+  }
+  pthread_mutex_lock(&nc->sinklock);
+  if(nc->sinks == NULL){
+    pthread_mutex_unlock(&nc->sinklock);
+    return 0;
+  }
+  ncsinkframe* f = ncsinkframe_alloc(nc, len);
+  if(f == NULL){
+    pthread_mutex_unlock(&nc->sinklock);
+    return -1;
+  }
+  memcpy(f->buf, buf, len);
+  ncsinks_enqueue_all(nc, f, keyframe);
+  pthread_mutex_unlock(&nc->sinklock);
+  return 0;
+}
+
+// sinks need a contiguous frame, so the splices are flattened here (but only
+// when there are sinks to see them).
+int ncsinks_publish_spliced(notcurses* nc, const fbuf* fb, size_t moffset,
+                            const fbufsplice* s, unsigned count){
+  size_t len = fb->used - moffset;
+  for(unsigned i = 0 ; i < count ; ++i){
+    len += s[i].len;
+  }
+  if(len == 0){
+    return 0;
+  }
+  pthread_mutex_lock(&nc->sinklock);
+  if(nc->sinks == NULL){
+    pthread_mutex_unlock(&nc->sinklock);
+    return 0;
+  }
+  ncsinkframe* f = ncsinkframe_alloc(nc, len);
+  if(f == NULL){
+    pthread_mutex_unlock(&nc->sinklock);
+    return -1;
+  }
+  size_t pos = moffset;
+  char* out = f->buf;
+  for(unsigned i = 0 ; i < count ; ++i){
+    memcpy(out, fb->buf + pos, s[i].off - pos);
+    out += s[i].off - pos;
+    pos = s[i].off;
+    memcpy(out, s[i].buf, s[i].len);
+    out += s[i].len;
+  }
+  memcpy(out, fb->buf + pos, fb->used - pos);
+  ncsinks_enqueue_all(nc, f, false);
+  pthread_mutex_unlock(&nc->sinklock);
+  return 0;
+}
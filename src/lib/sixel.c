@@ -654,7 +654,7 @@ wipe_band(sixelmap* smap, int band, int startx, int endx,
 // redrawn, it's redrawn using P2=1.
 int sixel_wipe(sprixel* s, int ycell, int xcell){
 //fprintf(stderr, "WIPING %d/%d\n", ycell, xcell);
-  uint8_t* auxvec = sixel_trans_auxvec(ncplane_pile(s->n));
+  uint8_t* auxvec = sixel_trans_auxvec(ncplane_pile(s->n), s->n->tam);
   if(auxvec == NULL){
     return -1;
   }
@@ -1107,11 +1107,11 @@ extract_cell_color_table(qstate* qs, long cellid){
     if(rgba_trans_p(*rgb, qs->bargs->transcolor)){
       update_rmatrix(rmatrix, cellid, tam);
       tam[cellid].state = SPRIXCELL_ANNIHILATED_TRANS;
-      free(tam[cellid].auxvector);
+      tam_auxvec_free(tam, tam[cellid].auxvector);
       tam[cellid].auxvector = NULL;
     }else{
       update_rmatrix(rmatrix, cellid, tam);
-      free(tam[cellid].auxvector);
+      tam_auxvec_free(tam, tam[cellid].auxvector);
       tam[cellid].auxvector = NULL;
     }
   }else{
@@ -1508,11 +1508,12 @@ int sixel_draw(const tinfo* ti, const ncpile* p, sprixel* s, fbuf* f,
       }
     }
   }
-  if(fbuf_putn(f, s->glyph.buf, s->glyph.used) < 0){
+  int ret = sprite_emit_glyph(p, f, &s->glyph, false);
+  if(ret < 0){
     return -1;
   }
-  s->invalidated = SPRIXEL_QUIESCENT;
-  return s->glyph.used;
+  sprixel_set_state(s, SPRIXEL_QUIESCENT);
+  return ret;
 }
 
 // a quantization worker.
@@ -1783,9 +1784,9 @@ void sixel_cleanup(tinfo* ti){
 // create an auxiliary vector suitable for a Sixel sprixcell, and zero it out.
 // there are two bytes per pixel in the cell: a palette index of up to 65534,
 // or 65535 to indicate transparency.
-uint8_t* sixel_trans_auxvec(const ncpile* p){
+uint8_t* sixel_trans_auxvec(const ncpile* p, tament* tam){
   const size_t slen = AUXVECELEMSIZE * p->cellpxy * p->cellpxx;
-  uint8_t* a = malloc(slen);
+  uint8_t* a = tam_auxvec(tam, slen);
   if(a){
     memset(a, 0xff, slen);
   }
@@ -1,5 +1,6 @@
 #include "internal.h"
 #include "visual-details.h"
+#include <stddef.h>
 #include <stdatomic.h>
 
 static atomic_uint_fast32_t sprixelid_nonce;
@@ -34,10 +35,11 @@ void sprixel_debug(const sprixel* s, FILE* out){
   }
 }
 
-// doesn't splice us out of any lists, just frees
+// doesn't splice us out of the sprixelcache, just the worklist, and frees
 void sprixel_free(sprixel* s){
   if(s){
     loginfo("destroying sprixel %u", s->id);
+    sprixel_work_unlink(s);
     if(s->n){
       s->n->sprite = NULL;
     }
@@ -48,6 +50,100 @@ void sprixel_free(sprixel* s){
   }
 }
 
+// chunks are prefixed with their link, padded to keep vectors aligned
+typedef union tamchunk {
+  void* next;
+  max_align_t align;
+} tamchunk;
+
+void* tam_auxvec(tament* tam, size_t len){
+  tamslab* slab = tam_slab(tam);
+  if(len > slab->veclen){
+    if(slab->outstanding){
+      logerror("auxvec of %zuB exceeds slab's %zuB", len, slab->veclen);
+      return NULL;
+    }
+    // nothing is outstanding, so we can reshape the slab
+    while(slab->chunks){
+      void* next = ((tamchunk*)slab->chunks)->next;
+      free(slab->chunks);
+      slab->chunks = next;
+    }
+    slab->freelist = NULL;
+    slab->chunkvecs = 0;
+    // the freelist link lives in the vector, which must stay aligned
+    const size_t a = sizeof(tamchunk);
+    slab->veclen = ((len > sizeof(void*) ? len : sizeof(void*)) + a - 1) / a * a;
+  }
+  if(slab->freelist == NULL){
+    unsigned vecs = slab->chunkvecs ? slab->chunkvecs * 2 : 16;
+    if(vecs > slab->cells){
+      vecs = slab->cells ? slab->cells : 1;
+    }
+    tamchunk* chunk = malloc(sizeof(*chunk) + slab->veclen * vecs);
+    if(chunk == NULL){
+      return NULL;
+    }
+    chunk->next = slab->chunks;
+    slab->chunks = chunk;
+    slab->chunkvecs = vecs;
+    char* v = (char*)(chunk + 1);
+    for(unsigned i = 0 ; i < vecs ; ++i){
+      *(void**)v = slab->freelist;
+      slab->freelist = v;
+      v += slab->veclen;
+    }
+  }
+  void* ret = slab->freelist;
+  slab->freelist = *(void**)ret;
+  ++slab->outstanding;
+  return ret;
+}
+
+void tam_auxvec_free(tament* tam, void* auxvec){
+  if(auxvec){
+    tamslab* slab = tam_slab(tam);
+    *(void**)auxvec = slab->freelist;
+    slab->freelist = auxvec;
+    --slab->outstanding;
+  }
+}
+
+tament* resize_tam(tament* tam, unsigned cells){
+  tamslab* slab = tam_slab(tam);
+  const unsigned oldcells = slab->cells;
+  if(cells <= oldcells){
+    // keep the allocation, but reclaim the vectors of lost entries
+    for(unsigned i = cells ; i < oldcells ; ++i){
+      tam_auxvec_free(tam, tam[i].auxvector);
+      tam[i].auxvector = NULL;
+    }
+    slab->cells = cells;
+    return tam;
+  }
+  tamslab* tmp = realloc(slab, sizeof(*slab) + sizeof(*tam) * cells);
+  if(tmp == NULL){
+    return NULL;
+  }
+  slab = tmp;
+  tam = (tament*)(slab + 1);
+  memset(tam + oldcells, 0, sizeof(*tam) * (cells - oldcells));
+  slab->cells = cells;
+  return tam;
+}
+
+void free_tam(tament* tam){
+  if(tam){
+    tamslab* slab = tam_slab(tam);
+    while(slab->chunks){
+      void* next = ((tamchunk*)slab->chunks)->next;
+      free(slab->chunks);
+      slab->chunks = next;
+    }
+    free(slab);
+  }
+}
+
 sprixel* sprixel_recycle(ncplane* n){
   assert(n->sprite);
   const notcurses* nc = ncplane_notcurses_const(n);
@@ -73,7 +169,7 @@ void sprixel_movefrom(sprixel* s, int y, int x){
     // what's there--you can't "write transparency"). this is probably
     // best done by conditionally reblitting the sixel(?).
 //fprintf(stderr, "SETTING TO MOVE: %d/%d was: %d\n", y, x, s->invalidated);
-      s->invalidated = SPRIXEL_MOVED;
+      sprixel_set_state(s, SPRIXEL_MOVED);
       s->movedfromy = y;
       s->movedfromx = x;
     }
@@ -88,7 +184,7 @@ void sprixel_hide(sprixel* s){
   // otherwise, it'll be killed in the next rendering cycle.
   if(s->invalidated != SPRIXEL_HIDE){
     loginfo("marking sprixel %u hidden", s->id);
-    s->invalidated = SPRIXEL_HIDE;
+    sprixel_set_state(s, SPRIXEL_HIDE);
     s->movedfromy = ncplane_abs_y(s->n);
     s->movedfromx = ncplane_abs_x(s->n);
     // guard; might have already been replaced
@@ -100,16 +196,22 @@ void sprixel_hide(sprixel* s){
 }
 
 // y and x are absolute coordinates.
+// an already-invalidated sprixel still records the cell in its damage
+// rectangle, for backends which redraw only damaged cells.
 void sprixel_invalidate(sprixel* s, int y, int x){
 //fprintf(stderr, "INVALIDATING AT %d/%d\n", y, x);
-  if(s->invalidated == SPRIXEL_QUIESCENT && s->n){
+  if((s->invalidated == SPRIXEL_QUIESCENT || s->invalidated == SPRIXEL_INVALIDATED) && s->n){
     int localy = y - s->n->absy;
     int localx = x - s->n->absx;
+    if(localy < 0 || localx < 0 || (unsigned)localy >= s->dimy || (unsigned)localx >= s->dimx){
+      return;
+    }
 //fprintf(stderr, "INVALIDATING AT %d/%d (%d/%d) TAM: %d\n", y, x, localy, localx, s->n->tam[localy * s->dimx + localx].state);
     if(s->n->tam[localy * s->dimx + localx].state != SPRIXCELL_TRANSPARENT &&
        s->n->tam[localy * s->dimx + localx].state != SPRIXCELL_ANNIHILATED &&
        s->n->tam[localy * s->dimx + localx].state != SPRIXCELL_ANNIHILATED_TRANS){
-      s->invalidated = SPRIXEL_INVALIDATED;
+      sprixel_set_state(s, SPRIXEL_INVALIDATED);
+      sprixel_damage(s, localy, localx);
     }
   }
 }
@@ -141,6 +243,7 @@ sprixel* sprixel_alloc(ncplane* n, int dimy, int dimx){
     }
     np->sprixelcache = ret;
     ret->prev = NULL;
+    ++np->sprixelcount;
 //fprintf(stderr, "%p %p %p\n", nc->sprixelcache, ret, nc->sprixelcache->next);
   }else{ // ncdirect case
     ret->next = ret->prev = NULL;
@@ -158,7 +261,7 @@ int sprixel_load(sprixel* spx, fbuf* f, unsigned pixy, unsigned pixx,
     fbuf_free(&spx->glyph);
     memcpy(&spx->glyph, f, sizeof(*f));
   }
-  spx->invalidated = state;
+  sprixel_set_state(spx, state);
   spx->pixx = pixx;
   spx->pixy = pixy;
   spx->parse_start = parse_start;
@@ -176,7 +279,7 @@ int sprite_wipe(const notcurses* nc, sprixel* s, int ycell, int xcell){
     // be entirely 0s coming from pixel_trans_auxvec().
     if(s->n->tam[idx].auxvector == NULL){
       if(nc->tcache.pixel_trans_auxvec){
-        s->n->tam[idx].auxvector = nc->tcache.pixel_trans_auxvec(ncplane_pile(s->n));
+        s->n->tam[idx].auxvector = nc->tcache.pixel_trans_auxvec(ncplane_pile(s->n), s->n->tam);
         if(s->n->tam[idx].auxvector == NULL){
           return -1;
         }
@@ -128,12 +128,40 @@ typedef struct tament {
   void* auxvector; // palette entries for sixel, alphas for kitty
 } tament;
 
+// auxiliary vectors are carved out of a slab belonging to the TAM, rather
+// than being individually allocated, so that wiping and rebuilding cells
+// needn't touch the general-purpose allocator. the slab header lives
+// immediately before the TAM array, and is reached via tam_slab(). a given
+// protocol and cell-pixel geometry always requests the same size, so the
+// vector length is fixed by the first request. chunks grow geometrically up
+// to a vector per cell of the TAM. released vectors go onto a freelist
+// threaded through their first word, and chunks are only returned to the
+// system along with the TAM itself (see free_tam()).
+typedef struct tamslab {
+  size_t veclen;        // bytes per vector, rounded up; 0 until first use
+  unsigned cells;       // entries in the TAM which follows us
+  unsigned chunkvecs;   // vectors in the most recently allocated chunk
+  unsigned outstanding; // vectors currently handed out
+  void* freelist;       // released vectors
+  void* chunks;         // chunks, linked through their first word
+} tamslab;
+
+static inline tamslab*
+tam_slab(tament* tam){
+  return (tamslab*)tam - 1;
+}
+
 // a sprixel represents a bitmap, using whatever local protocol is available.
-// there is a list of sprixels per ncpile. there ought never be very many
-// associated with a context (a dozen or so at max). with the kitty protocol,
-// we can register them, and then manipulate them by id. with the sixel
-// protocol, we just have to rewrite them. there's a doubly-linked list of
-// sprixels per ncpile, to which the pile keeps a head link.
+// with the kitty protocol, we can register them, and then manipulate them by
+// id. with the sixel protocol, we just have to rewrite them. there's a
+// doubly-linked list of all sprixels per ncpile, to which the pile keeps a
+// head link. there might be hundreds of them (think image grids), most of
+// them quiescent in any given frame, so each pile furthermore keeps a
+// worklist of those sprixels which are not known to be QUIESCENT. all state
+// transitions go through sprixel_set_state(), which maintains it; the
+// rasterizer then walks only the worklist. cell-to-sprixel lookups go
+// through the crender vector's per-cell sprixel links, and never walk
+// these lists.
 typedef struct sprixel {
   fbuf glyph;
   uint32_t id;          // embedded into gcluster field of nccell, 24 bits
@@ -143,6 +171,9 @@ typedef struct sprixel {
   sprixel_e invalidated;// sprixel invalidation state
   struct sprixel* next;
   struct sprixel* prev;
+  struct sprixel* wnext;  // pile worklist link, see sprixel_set_state()
+  struct sprixel** wprev; // worklist link back to us, NULL if not listed
+  unsigned zorder;      // depth at last paint (0 is topmost)
   unsigned dimy, dimx;  // cell geometry
   int pixy, pixx;       // pixel geometry (might be smaller than cell geo)
   // each tacache entry is one of 0 (standard opaque cell), 1 (cell with
@@ -157,18 +188,63 @@ typedef struct sprixel {
   struct sixelmap* smap;  // copy of palette indices + transparency bits
   bool wipes_outstanding; // do we need rebuild the sixel next render?
   bool animating;        // do we have an active animation?
+  // only used for framebuffer-based sprixels, which are drawn directly. if
+  // fbdrawn is set, we're on-screen at fbdrawny/fbdrawnx, and only the cells
+  // in the half-open damage rectangle [dmgy0, dmgy1) x [dmgx0, dmgx1) need
+  // be redrawn there. otherwise, the entire sprixel must be drawn.
+  bool fbdrawn;
+  int fbdrawny, fbdrawnx;
+  unsigned dmgy0, dmgx0, dmgy1, dmgx1;
 } sprixel;
 
+// grow the damage rectangle of |s| to include the cell at |y|/|x| (relative
+// to the sprixel).
+static inline void
+sprixel_damage(sprixel* s, unsigned y, unsigned x){
+  if(s->dmgy0 >= s->dmgy1){
+    s->dmgy0 = y;
+    s->dmgy1 = y + 1;
+    s->dmgx0 = x;
+    s->dmgx1 = x + 1;
+    return;
+  }
+  if(y < s->dmgy0){
+    s->dmgy0 = y;
+  }else if(y >= s->dmgy1){
+    s->dmgy1 = y + 1;
+  }
+  if(x < s->dmgx0){
+    s->dmgx0 = x;
+  }else if(x >= s->dmgx1){
+    s->dmgx1 = x + 1;
+  }
+}
+
 static inline tament*
 create_tam(int rows, int cols){
+  const size_t len = sizeof(tamslab) + sizeof(tament) * rows * cols;
   // need cast for c++ callers
-  tament* tam = (tament*)malloc(sizeof(*tam) * rows * cols);
-  if(tam){
-    memset(tam, 0, sizeof(*tam) * rows * cols);
+  tamslab* slab = (tamslab*)malloc(len);
+  if(slab == NULL){
+    return NULL;
   }
-  return tam;
+  memset(slab, 0, len);
+  slab->cells = rows * cols;
+  return (tament*)(slab + 1);
 }
 
+// returns an uninitialized auxiliary vector of |len| bytes from |tam|'s
+// slab, or NULL on failure.
+void* tam_auxvec(tament* tam, size_t len);
+// returns |auxvec| (which may be NULL) to |tam|'s slab.
+void tam_auxvec_free(tament* tam, void* auxvec);
+// resizes |tam| to |cells| entries, preserving the slab and any entries
+// which remain. new entries are zeroed. returns NULL on failure, in which
+// case |tam| is unchanged.
+tament* resize_tam(tament* tam, unsigned cells);
+// frees the TAM and its slab. auxvectors needn't have been released.
+void free_tam(tament* tam);
+
 int sprite_init(struct tinfo* t, int fd);
 int sixel_wipe(sprixel* s, int ycell, int xcell);
 // nulls out a cell from a kitty bitmap via changing the alpha value
@@ -191,16 +267,21 @@ int sixel_draw(const struct tinfo* ti, const struct ncpile *p, sprixel* s,
 int kitty_draw(const struct tinfo* ti, const struct ncpile *p, sprixel* s,
                fbuf* f, int yoff, int xoff);
 int kitty_move(sprixel* s, fbuf* f, unsigned noscroll, int yoff, int xoff);
+// emit the encoded payload |glyph| to |f|, by reference if |f| is |p|'s
+// rasterization buffer and the payload is large. if |take| is set, |glyph|
+// is handed off (and zeroed). returns the number of bytes emitted.
+int sprite_emit_glyph(const struct ncpile* p, fbuf* f, fbuf* glyph, bool take);
 int sixel_scrub(const struct ncpile* p, sprixel* s);
 int kitty_scrub(const struct ncpile* p, sprixel* s);
 int fbcon_scrub(const struct ncpile* p, sprixel* s);
 int kitty_remove(int id, fbuf* f);
+int kitty_unplace(int id, fbuf* f);
 int kitty_clear_all(fbuf* f);
 int sixel_init_forcesdm(struct tinfo* ti, int fd);
 int sixel_init_inverted(struct tinfo* ti, int fd);
 int sixel_init(struct tinfo* ti, int fd);
-uint8_t* sixel_trans_auxvec(const struct ncpile* p);
-uint8_t* kitty_trans_auxvec(const struct ncpile* p);
+uint8_t* sixel_trans_auxvec(const struct ncpile* p, tament* tam);
+uint8_t* kitty_trans_auxvec(const struct ncpile* p, tament* tam);
 int kitty_commit(fbuf* f, sprixel* s, unsigned noscroll);
 int sixel_blit(struct ncplane* nc, int linesize, const void* data,
                int leny, int lenx, const struct blitterargs* bargs);
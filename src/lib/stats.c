@@ -74,6 +74,7 @@ void update_raster_stats(const struct timespec* time1, const struct timespec* ti
 void reset_stats(ncstats* stats){
   uint64_t fbbytes = stats->fbbytes;
   unsigned planes = stats->planes;
+  unsigned degradation = stats->degradation;
   memset(stats, 0, sizeof(*stats));
   stats->render_min_ns = 1ull << 62u;
   stats->raster_min_bytes = 1ull << 62u;
@@ -81,6 +82,7 @@ void reset_stats(ncstats* stats){
   stats->writeout_min_ns = 1ull << 62u;
   stats->fbbytes = fbbytes;
   stats->planes = planes;
+  stats->degradation = degradation;
 }
 
 void notcurses_stats(notcurses* nc, ncstats* stats){
@@ -155,9 +157,18 @@ void notcurses_stats_reset(notcurses* nc, ncstats* stats){
     stash->hpa_gratuitous += nc->stats.s.hpa_gratuitous;
     stash->cell_geo_changes += nc->stats.s.cell_geo_changes;
     stash->pixel_geo_changes += nc->stats.s.pixel_geo_changes;
+    stash->degraded_frames += nc->stats.s.degraded_frames;
+    stash->degraded_cells += nc->stats.s.degraded_cells;
+    stash->degraded_bytes += nc->stats.s.degraded_bytes;
+    stash->cleanrows += nc->stats.s.cleanrows;
+    stash->sprixelcopied += nc->stats.s.sprixelcopied;
+    stash->sprixelspliced += nc->stats.s.sprixelspliced;
+    stash->dynpal_saved += nc->stats.s.dynpal_saved;
+    stash->dynpal_spent += nc->stats.s.dynpal_spent;
 
     stash->fbbytes = nc->stats.s.fbbytes;
     stash->planes = nc->stats.s.planes;
+    stash->degradation = nc->stats.s.degradation;
     reset_stats(&nc->stats.s);
   pthread_mutex_unlock(&nc->stats.lock);
 }
@@ -242,8 +253,25 @@ void summarize_stats(notcurses* nc){
           stats->raster_bytes ? (stats->sprixelbytes * 100.0) / stats->raster_bytes : 0,
           stats->appsync_updates,
           stats->writeouts ? stats->appsync_updates * 100.0 / stats->writeouts : 0);
+  if(stats->sprixelcopied || stats->sprixelspliced){
+    char splicebuf[NCBPREFIXSTRLEN + 1];
+    ncbprefix(stats->sprixelcopied, 1, totalbuf, 1);
+    ncbprefix(stats->sprixelspliced, 1, splicebuf, 1);
+    fprintf(stderr, "Bmap bytes copied: %sB spliced: %sB" NL, totalbuf, splicebuf);
+  }
   if(stats->cell_geo_changes || stats->pixel_geo_changes){
     fprintf(stderr,"Screen/cell geometry changes: %"PRIu64"/%"PRIu64 NL,
             stats->cell_geo_changes, stats->pixel_geo_changes);
   }
+  if(stats->dynpal_saved || stats->dynpal_spent){
+    char spentbuf[NCBPREFIXSTRLEN + 1];
+    ncbprefix(stats->dynpal_saved, 1, totalbuf, 1);
+    ncbprefix(stats->dynpal_spent, 1, spentbuf, 1);
+    fprintf(stderr, "Dynamic palette saved: %sB spent: %sB" NL, totalbuf, spentbuf);
+  }
+  if(stats->degraded_frames){
+    ncbprefix(stats->degraded_bytes, 1, totalbuf, 1);
+    fprintf(stderr, "Degraded frames: %"PRIu64" cells: %"PRIu64" saved: ~%sB" NL,
+            stats->degraded_frames, stats->degraded_cells, totalbuf);
+  }
 }
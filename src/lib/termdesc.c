@@ -62,6 +62,7 @@ setup_sixel_bitmaps(tinfo* ti, int fd, unsigned forcesdm, unsigned invert80){
   }
   ti->pixel_scrub = sixel_scrub;
   ti->pixel_remove = NULL;
+  ti->pixel_unplace = NULL;
   ti->pixel_draw = sixel_draw;
   ti->pixel_refresh = sixel_refresh;
   ti->pixel_draw_late = NULL;
@@ -86,6 +87,7 @@ static inline void
 setup_kitty_bitmaps(tinfo* ti, int fd, ncpixelimpl_e level){
   ti->pixel_scrub = kitty_scrub;
   ti->pixel_remove = kitty_remove;
+  ti->pixel_unplace = kitty_unplace;
   ti->pixel_draw = kitty_draw;
   ti->pixel_draw_late = NULL;
   ti->pixel_refresh = NULL;
@@ -123,6 +125,7 @@ static inline void
 setup_fbcon_bitmaps(tinfo* ti, int fd){
   ti->pixel_scrub = fbcon_scrub;
   ti->pixel_remove = NULL;
+  ti->pixel_unplace = NULL;
   ti->pixel_draw = NULL;
   ti->pixel_draw_late = fbcon_draw;
   ti->pixel_commit = NULL;
@@ -1257,7 +1260,7 @@ int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
                          unsigned noaltscreen, unsigned nocbreak, unsigned nonewfonts,
                          int* cursor_y, int* cursor_x, ncsharedstats* stats,
                          int lmargin, int tmargin, int rmargin, int bmargin,
-                         unsigned draininput){
+                         unsigned draininput, unsigned coalesceinput){
   // if a specified termtype was provided in the notcurses_options, it was
   // loaded into our environment at TERM.
   const char* termtype = getenv("TERM");
@@ -1342,7 +1345,7 @@ int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
     }
   }
   if(init_inputlayer(ti, stdin, lmargin, tmargin, rmargin, bmargin,
-                     stats, draininput, linesigs_enabled)){
+                     stats, draininput, linesigs_enabled, coalesceinput)){
     goto err;
   }
   ti->sprixel_scale_height = 1;
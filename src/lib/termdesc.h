@@ -27,6 +27,7 @@ extern "C" {
 #define XTMODKEYSUNDO "\x1b[>2m\x1b[>4m"
 
 struct ncpile;
+struct tament;
 struct sprixel;
 struct notcurses;
 struct ncsharedstats;
@@ -143,6 +144,7 @@ typedef struct tinfo {
   // it leaves the sprixel in INVALIDATED so that it's drawn in phase 2.
   void (*pixel_refresh)(const struct ncpile* p, struct sprixel* s);
   int (*pixel_remove)(int id, fbuf* f); // kitty only, issue actual delete command
+  int (*pixel_unplace)(int id, fbuf* f); // kitty only, delete but keep loaded
   int (*pixel_init)(struct tinfo* ti, int fd); // called when support is detected
   int (*pixel_draw)(const struct tinfo*, const struct ncpile* p,
                     struct sprixel* s, fbuf* f, int y, int x);
@@ -156,7 +158,7 @@ typedef struct tinfo {
   // scroll all graphics up. only used with fbcon.
   void (*pixel_scroll)(const struct ncpile* p, struct tinfo*, int rows);
   void (*pixel_cleanup)(struct tinfo*); // called at shutdown
-  uint8_t* (*pixel_trans_auxvec)(const struct ncpile* p); // create tranparent auxvec
+  uint8_t* (*pixel_trans_auxvec)(const struct ncpile* p, struct tament* tam); // create tranparent auxvec
   // sprixel parameters. there are several different sprixel protocols, of
   // which we support sixel and kitty. the kitty protocol is used based
   // on TERM heuristics. otherwise, we attempt to detect sixel support, and
@@ -200,6 +202,13 @@ typedef struct tinfo {
   char* linux_fb_dev;        // device corresponding to linux_fb_dev
   uint8_t* linux_fbuffer;    // mmap()ed framebuffer
   size_t linux_fb_len;       // size of map
+  size_t linux_fb_stride;    // bytes per line of the map
+  unsigned linux_fb_bpp;     // bytes per pixel of the map
+  // bit offsets and lengths of the color components within a pixel. if the
+  // pixel is 4B, laid out as 0x00RRGGBB, our glyph data is copied verbatim.
+  uint8_t linux_fb_roff, linux_fb_goff, linux_fb_boff;
+  uint8_t linux_fb_rlen, linux_fb_glen, linux_fb_blen;
+  bool linux_fb_native;
 #elif defined(__MINGW32__)
   HANDLE inhandle;
   HANDLE outhandle;
@@ -236,13 +245,15 @@ term_supported_styles(const tinfo* ti){
 
 // prepare |ti| from the terminfo database and other sources. set |utf8| if
 // we've verified UTF8 output encoding. set |noaltscreen| to inhibit alternate
-// screen detection. |stats| may be NULL; either way, it will be handed to the
+// screen detection. set |coalesceinput| to merge runs of motion and resize
+// events in the input layer. |stats| may be NULL; either way, it will be handed to the
 // input layer so that its stats can be recorded.
 int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
                          unsigned noaltscreen, unsigned nocbreak,
                          unsigned nonewfonts, int* cursor_y, int* cursor_x,
                          struct ncsharedstats* stats, int lmargin, int tmargin,
-                         int rmargin, int bmargin, unsigned draininput)
+                         int rmargin, int bmargin, unsigned draininput,
+                         unsigned coalesceinput)
   __attribute__ ((nonnull (1, 2, 9)));
 
 void free_terminfo_cache(tinfo* ti);
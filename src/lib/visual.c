@@ -701,6 +701,194 @@ rotate_bounding_box(double stheta, double ctheta, int* leny, int* lenx,
   return *leny * *lenx;
 }
 
+// rotation works backwards from the destination: each destination pixel is
+// mapped through the inverse rotation into the source, and bilinearly
+// sampled there, so that the output has no holes. coordinates are 16.16
+// fixed point, stepped by constant increments along each row.
+#define ROTATE_FRAC 16
+// bilinear weights are taken from the top 8 fractional bits, so that the
+// alpha-weighted accumulators fit in 32 bits, and a channel times a weight
+// fits in 16.
+#define ROTATE_WBITS 8
+// below this many destination pixels, we don't bother spinning up threads
+#define ROTATE_MT_PIXELS (512 * 512)
+#define ROTATE_MAX_THREADS 8
+
+typedef struct rotatejob {
+  const uint32_t* src;  // source pixels, |stride| pixels per row
+  int srcy, srcx;       // source geometry
+  int stride;
+  uint32_t* dst;        // destination, |dstx| pixels per row
+  int dstx;
+  int starty, endy;     // half-open range of destination rows
+  int64_t s, c;         // fixed-point sine and cosine
+  int offy, offx;       // destination origin, relative to the center
+  int centy, centx;     // source center
+} rotatejob;
+
+// spread a pixel's four channels into the four 16-bit lanes of a uint64_t,
+// so that they can all be scaled by an 8-bit weight with one multiply. every
+// channel is treated alike, so byte order doesn't matter.
+static inline uint64_t
+rotate_spread(uint32_t p){
+  return (p & 0x00ff00ffull) | ((p & 0xff00ff00ull) << 24);
+}
+
+static inline uint32_t
+rotate_gather(uint64_t p){
+  return (uint32_t)(p | (p >> 24));
+}
+
+// blend two spread pixels, |w| / 256ths of the way from |a| to |b|
+static inline uint64_t
+rotate_lerp(uint64_t a, uint64_t b, unsigned w){
+  const uint64_t lanes = 0x00ff00ff00ff00ffull;
+  return ((a * ((1u << ROTATE_WBITS) - w) + b * w) >> ROTATE_WBITS) & lanes;
+}
+
+// alpha-weighted bilinear blend of the (up to) four source pixels around
+// fixed-point |sy|/|sx|. pixels outside the source are transparent.
+static inline uint32_t
+rotate_sample(const rotatejob* rj, int64_t sy, int64_t sx){
+  const int y0 = (int)(sy >> ROTATE_FRAC);
+  const int x0 = (int)(sx >> ROTATE_FRAC);
+  const unsigned one = 1u << ROTATE_WBITS;
+  const unsigned wy = (sy >> (ROTATE_FRAC - ROTATE_WBITS)) & (one - 1);
+  const unsigned wx = (sx >> (ROTATE_FRAC - ROTATE_WBITS)) & (one - 1);
+  // the common case: all four neighbors exist, and share an alpha (usually
+  // they're all opaque). the alpha weighting then cancels out, and we can
+  // lerp packed pixels directly.
+  if(y0 >= 0 && x0 >= 0 && y0 + 1 < rj->srcy && x0 + 1 < rj->srcx){
+    const uint32_t* p = rj->src + (size_t)y0 * rj->stride + x0;
+    const uint32_t amask = htole(0xff000000u);
+    const uint32_t ul = p[0], ur = p[1];
+    const uint32_t ll = p[rj->stride], lr = p[rj->stride + 1];
+    if((((ul ^ ur) | (ul ^ ll) | (ul ^ lr)) & amask) == 0){
+      const uint64_t top = rotate_lerp(rotate_spread(ul), rotate_spread(ur), wx);
+      const uint64_t bot = rotate_lerp(rotate_spread(ll), rotate_spread(lr), wx);
+      return rotate_gather(rotate_lerp(top, bot, wy));
+    }
+  }
+  const unsigned weights[4] = {
+    (one - wy) * (one - wx), (one - wy) * wx, wy * (one - wx), wy * wx,
+  };
+  uint32_t acc[3] = { 0, 0, 0 };
+  uint32_t alpha = 0;
+  for(int i = 0 ; i < 4 ; ++i){
+    const int y = y0 + (i >> 1);
+    const int x = x0 + (i & 1);
+    if(weights[i] == 0 || y < 0 || x < 0 || y >= rj->srcy || x >= rj->srcx){
+      continue;
+    }
+    // pixels are R, G, B, A in memory, whatever our endianness
+    const uint8_t* p = (const uint8_t*)&rj->src[y * rj->stride + x];
+    const uint32_t wa = weights[i] * p[3];
+    acc[0] += wa * p[0];
+    acc[1] += wa * p[1];
+    acc[2] += wa * p[2];
+    alpha += wa;
+  }
+  uint32_t ret = 0;
+  if(alpha){
+    uint8_t* r = (uint8_t*)&ret;
+    r[0] = acc[0] / alpha;
+    r[1] = acc[1] / alpha;
+    r[2] = acc[2] / alpha;
+    r[3] = (alpha + one * one / 2) >> (ROTATE_WBITS * 2);
+  }
+  return ret;
+}
+
+// fill one tile's worth of destination row |dy|, columns [startx, endx).
+static inline void
+rotate_span(const rotatejob* rj, int dy, int startx, int endx){
+  const int64_t ty = dy + rj->offy;
+  const int64_t tx = startx + rj->offx;
+  // inverse rotation: x = tx * c + ty * s, y = ty * c - tx * s. the
+  // span's origin is computed directly; we thereafter just step.
+  int64_t sx = tx * rj->c + ty * rj->s + ((int64_t)rj->centx << ROTATE_FRAC);
+  int64_t sy = ty * rj->c - tx * rj->s + ((int64_t)rj->centy << ROTATE_FRAC);
+  uint32_t* out = rj->dst + (size_t)dy * rj->dstx;
+  for(int dx = startx ; dx < endx ; ++dx){
+    // skip samples wholly outside the source; they stay transparent
+    const int64_t x0 = sx >> ROTATE_FRAC;
+    const int64_t y0 = sy >> ROTATE_FRAC;
+    if(x0 >= -1 && y0 >= -1 && x0 < rj->srcx && y0 < rj->srcy){
+      out[dx] = rotate_sample(rj, sy, sx);
+    }
+    sx += rj->c;
+    sy -= rj->s;
+  }
+}
+
+// a destination row walks a diagonal through the source, touching a new
+// source row every pixel or two. we work in square tiles, so that the source
+// rows a tile touches are still in cache for the tile's next row.
+#define ROTATE_TILE 64
+
+static void
+rotate_rows(const rotatejob* rj){
+  for(int ty = rj->starty ; ty < rj->endy ; ty += ROTATE_TILE){
+    const int endy = ty + ROTATE_TILE < rj->endy ? ty + ROTATE_TILE : rj->endy;
+    for(int tx = 0 ; tx < rj->dstx ; tx += ROTATE_TILE){
+      const int endx = tx + ROTATE_TILE < rj->dstx ? tx + ROTATE_TILE : rj->dstx;
+      for(int dy = ty ; dy < endy ; ++dy){
+        rotate_span(rj, dy, tx, endx);
+      }
+    }
+  }
+}
+
+static void*
+rotate_thread(void* vrj){
+  rotate_rows(vrj);
+  return NULL;
+}
+
+// split the destination rows among up to ROTATE_MAX_THREADS threads (we run
+// one band ourselves). should a thread fail to launch, we do its rows too.
+static void
+rotate_parallel(rotatejob* rj){
+  const int64_t pixels = (int64_t)rj->endy * rj->dstx;
+  long threads = 1;
+  if(pixels >= ROTATE_MT_PIXELS){
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if(threads > ROTATE_MAX_THREADS){
+      threads = ROTATE_MAX_THREADS;
+    }
+    if(threads > rj->endy){
+      threads = rj->endy;
+    }
+  }
+  if(threads <= 1){
+    rotate_rows(rj);
+    return;
+  }
+  pthread_t tids[ROTATE_MAX_THREADS];
+  rotatejob jobs[ROTATE_MAX_THREADS];
+  bool launched[ROTATE_MAX_THREADS];
+  const int rows = rj->endy;
+  for(long t = 0 ; t < threads ; ++t){
+    jobs[t] = *rj;
+    jobs[t].starty = rows * t / threads;
+    jobs[t].endy = rows * (t + 1) / threads;
+    launched[t] = false;
+    if(t && pthread_create(&tids[t], NULL, rotate_thread, &jobs[t]) == 0){
+      launched[t] = true;
+    }
+  }
+  for(long t = 0 ; t < threads ; ++t){
+    if(!launched[t]){
+      rotate_rows(&jobs[t]);
+    }
+  }
+  for(long t = 1 ; t < threads ; ++t){
+    if(launched[t]){
+      pthread_join(tids[t], NULL);
+    }
+  }
+}
+
 int ncvisual_rotate(ncvisual* ncv, double rads){
   assert(ncv->rowstride / 4 >= ncv->pixx);
   rads = -rads; // we're a left-handed Cartesian
@@ -726,8 +914,6 @@ int ncvisual_rotate(ncvisual* ncv, double rads){
     logerror("couldn't rotate the visual (%d, %d, %d, %d)", bby, bbx, bboffy, bboffx);
     return -1;
   }
-  int bbcentx = bbx, bbcenty = bby;
-  center_box(&bbcenty, &bbcentx);
 //fprintf(stderr, "stride: %d height: %d width: %d\n", ncv->rowstride, ncv->pixy, ncv->pixx);
   assert(ncv->rowstride / 4 >= ncv->pixx);
   uint32_t* data = malloc(bbarea * 4);
@@ -735,22 +921,24 @@ int ncvisual_rotate(ncvisual* ncv, double rads){
     return -1;
   }
   memset(data, 0, bbarea * 4);
-//fprintf(stderr, "bbarea: %d bby: %d bbx: %d centy: %d centx: %d bbcenty: %d bbcentx: %d\n", bbarea, bby, bbx, centy, centx, bbcenty, bbcentx);
-  for(unsigned y = 0 ; y < ncv->pixy ; ++y){
-      for(unsigned x = 0 ; x < ncv->pixx ; ++x){
-      int targx = x, targy = y;
-      rotate_point(&targy, &targx, stheta, ctheta, centy, centx);
-      if(targx > bboffx && targy > bboffy){
-        const int deconvx = targx - bboffx;
-        const int deconvy = targy - bboffy;
-        if(deconvy < bby && deconvx < bbx){
-          data[deconvy * bbx + deconvx] = ncv->data[y * (ncv->rowstride / 4) + x];
-        }
-      }
-//fprintf(stderr, "CW: %d/%d (%08x) -> %d/%d (stride: %d)\n", y, x, ncv->data[y * (ncv->rowstride / 4) + x], targy, targx, ncv->rowstride);
-//fprintf(stderr, "wrote %08x to %d (%d)\n", data[targy * ncv->pixy + targx], targy * ncv->pixy + targx, (targy * ncv->pixy + targx) * 4);
-    }
-  }
+  rotatejob rj = {
+    .src = ncv->data,
+    .srcy = ncv->pixy,
+    .srcx = ncv->pixx,
+    .stride = ncv->rowstride / 4,
+    .dst = data,
+    .dstx = bbx,
+    .starty = 0,
+    .endy = bby,
+    .s = llround(stheta * (1 << ROTATE_FRAC)),
+    .c = llround(ctheta * (1 << ROTATE_FRAC)),
+    .offy = bboffy,
+    .offx = bboffx,
+    .centy = centy,
+    .centx = centx,
+  };
+//fprintf(stderr, "bbarea: %d bby: %d bbx: %d centy: %d centx: %d\n", bbarea, bby, bbx, centy, centx);
+  rotate_parallel(&rj);
   ncvisual_set_data(ncv, data, true);
   ncv->pixx = bbx;
   ncv->pixy = bby;
@@ -1122,8 +1310,7 @@ ncplane* ncvisual_render_pixels(notcurses* nc, ncvisual* ncv, const struct blits
     // if we blow up here, then we've got a TAM sized to the sprixel, rather
     // than the plane. running it through destroy_tam() via ncplane_destroy()
     // will use incorrect bounds for scrubbing said TAM. do it manually here.
-    cleanup_tam(n->tam, geom->rcelly, geom->rcellx);
-    free(n->tam);
+    free_tam(n->tam);
     n->tam = NULL;
     sprixel_hide(bargs.u.pixel.spx);
     return NULL;
@@ -1153,6 +1340,11 @@ ncplane* ncvisual_blit(notcurses* nc, ncvisual* ncv, const struct ncvisual_optio
     return NULL;
   }
   ncplane* n = vopts->n;
+  if(geom.blitter == NCBLIT_PIXEL && n && n->compact &&
+     !(vopts->flags & NCVISUAL_OPTION_CHILDPLANE)){
+    logerror("can't blit bitmaps onto compact planes");
+    return NULL;
+  }
   uint32_t transcolor = 0;
   if(vopts->flags & NCVISUAL_OPTION_ADDALPHA){
     transcolor = 0x1000000ull | vopts->transcolor;
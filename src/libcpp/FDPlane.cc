@@ -6,4 +6,6 @@ ncfdplane_options FDPlane::default_options = {
 	nullptr, // curry
 	false,	 // follow
 	0,			 // flags
+	0,			 // bufsize
+	0,			 // coalesce_ns
 };
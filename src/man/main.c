@@ -1,5 +1,6 @@
 #include <fcntl.h>
 #include <errno.h>
+#include <limits.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <getopt.h>
@@ -311,18 +312,130 @@ putpara(struct ncplane* p, const char* text){
   return 0;
 }
 
+// the pagedom is laid out in document order as a sequence of units, one per
+// drawn node. we lay out only those units near the viewport, each into its
+// own offscreen plane, and compose the visible rows from them. a unit's
+// line breaks depend only on the width, so we remember its height for the
+// last few widths seen; resizing back and forth needn't lay anything out.
+#define LAYOUT_WIDTHS 4
+
+typedef struct unitmetrics {
+  unsigned width;   // 0 for an unused slot
+  unsigned advance; // rows the cursor moved while drawing
+  unsigned rows;    // rows the unit touched
+} unitmetrics;
+
+typedef struct layunit {
+  const pagenode* node;
+  unsigned wrotetext;  // drawing state upon entering the unit
+  unsigned insubsec;
+  int section;         // docstructure index, or -1
+  struct ncplane* n;   // laid out at the pageman's width, or NULL
+  unitmetrics metrics[LAYOUT_WIDTHS];
+  unsigned nextmetric; // slot to replace next
+} layunit;
+
+typedef struct pageman {
+  pagedom* dom;
+  struct ncplane* page;    // the viewport
+  struct ncplane* scratch; // offscreen pile root; parent of unit planes
+  layunit* units;
+  unsigned ucount;
+  unsigned* secunits;      // unit index of each docstructure section
+  unsigned seccount;
+  unsigned width;          // width at which we're laying out
+  int* starts;             // document row of each measured unit, plus one
+  unsigned measured;       // units [0..measured) have known starts
+  unsigned docrows;        // rows touched by measured units
+  int pagey;               // document row r is shown at viewport row pagey + r
+} pageman;
+
+static int
+add_unit(pageman* pm, const pagenode* n, unsigned wrotetext, unsigned insubsec,
+         const char* section){
+  layunit* tmp = realloc(pm->units, sizeof(*pm->units) * (pm->ucount + 1));
+  if(tmp == NULL){
+    return -1;
+  }
+  pm->units = tmp;
+  layunit* u = &pm->units[pm->ucount];
+  memset(u, 0, sizeof(*u));
+  u->node = n;
+  u->wrotetext = wrotetext;
+  u->insubsec = insubsec;
+  u->section = -1;
+  if(section){
+    unsigned* stmp = realloc(pm->secunits, sizeof(*pm->secunits) * (pm->seccount + 1));
+    if(stmp == NULL){
+      return -1;
+    }
+    pm->secunits = stmp;
+    if(docstructure_add(pm->dom->ds, section, INT_MAX)){
+      return -1;
+    }
+    u->section = pm->seccount;
+    pm->secunits[pm->seccount++] = pm->ucount;
+  }
+  ++pm->ucount;
+  return 0;
+}
+
+// walk the pagedom in drawing order, recording the drawing state each unit
+// will begin with. this state doesn't depend on the geometry.
 static int
-draw_domnode(struct ncplane* p, const pagedom* dom, const pagenode* n,
-             unsigned* wrotetext, unsigned* insubsec){
+flatten_domnode(pageman* pm, const pagenode* n, unsigned* wrotetext,
+                unsigned* insubsec){
+  const pagedom* dom = pm->dom;
+  const unsigned entrywrote = *wrotetext;
+  const unsigned entrysubsec = *insubsec;
+  const char* section = NULL;
+  switch(n->ttype->ltype){
+    case LINE_TH:
+      section = dom->title;
+      break;
+    case LINE_SH: // section heading
+      section = n->text;
+      if(strcmp(n->text, "NAME")){
+        *wrotetext = true;
+      }
+      break;
+    case LINE_SS: // subsection heading
+      section = n->text;
+      *wrotetext = true;
+      *insubsec = true;
+      break;
+    case LINE_PP: // paragraph
+    case LINE_TP: // tagged paragraph
+    case LINE_IP: // indented paragraph
+      if(*wrotetext && n->text){
+        *insubsec = false;
+      }
+      *wrotetext = true;
+      break;
+    default:
+      fprintf(stderr, "unhandled ltype %d\n", n->ttype->ltype);
+      return 0; // FIXME
+  }
+  if(add_unit(pm, n, entrywrote, entrysubsec, section)){
+    return -1;
+  }
+  for(unsigned z = 0 ; z < n->subcount ; ++z){
+    if(flatten_domnode(pm, &n->subs[z], wrotetext, insubsec)){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// draw a single unit onto |p|, starting from its origin.
+static void
+draw_unit(struct ncplane* p, const layunit* u){
+  const pagenode* n = u->node;
+  unsigned insubsec = u->insubsec;
   ncplane_set_fg_rgb(p, ncchannel_rgb(n->ttype->channel));
   size_t b = 0;
-  unsigned y;
-  ncplane_cursor_yx(p, &y, NULL);
   switch(n->ttype->ltype){
     case LINE_TH:
-      if(docstructure_add(dom->ds, dom->title, y)){
-        return -1;
-      }
       /*
       ncplane_set_styles(p, NCSTYLE_UNDERLINE);
       ncplane_printf_aligned(p, 0, NCALIGN_LEFT, "%s(%s)", dom->title, dom->section);
@@ -330,39 +443,29 @@ draw_domnode(struct ncplane* p, const pagedom* dom, const pagenode* n,
       ncplane_set_styles(p, NCSTYLE_NONE);
       */break;
     case LINE_SH: // section heading
-      if(docstructure_add(dom->ds, n->text, y)){
-        return -1;
-      }
       if(strcmp(n->text, "NAME")){
         ncplane_puttext(p, -1, NCALIGN_LEFT, "\n\n", &b);
         ncplane_set_styles(p, NCSTYLE_BOLD | NCSTYLE_UNDERLINE);
         ncplane_putstr_aligned(p, -1, NCALIGN_CENTER, n->text);
         ncplane_set_styles(p, NCSTYLE_NONE);
         ncplane_cursor_move_yx(p, -1, 0);
-        *wrotetext = true;
       }
       break;
     case LINE_SS: // subsection heading
-      if(docstructure_add(dom->ds, n->text, y)){
-        return -1;
-      }
       ncplane_puttext(p, -1, NCALIGN_LEFT, "\n\n", &b);
       ncplane_set_styles(p, NCSTYLE_ITALIC | NCSTYLE_UNDERLINE);
       ncplane_putstr_aligned(p, -1, NCALIGN_CENTER, n->text);
       ncplane_set_styles(p, NCSTYLE_NONE);
       ncplane_cursor_move_yx(p, -1, 0);
-      *wrotetext = true;
-      *insubsec = true;
       break;
     case LINE_PP: // paragraph
     case LINE_TP: // tagged paragraph
     case LINE_IP: // indented paragraph
-      if(*wrotetext){
+      if(u->wrotetext){
         if(n->text){
           ncplane_set_fg_rgb(p, 0xe0f0ff);
-          if(*insubsec){
+          if(insubsec){
             ncplane_puttext(p, -1, NCALIGN_LEFT, "\n", &b);
-            *insubsec = false;
           }else{
             ncplane_puttext(p, -1, NCALIGN_LEFT, "\n\n", &b);
           }
@@ -378,74 +481,238 @@ draw_domnode(struct ncplane* p, const pagedom* dom, const pagenode* n,
           ncplane_set_styles(p, NCSTYLE_NONE);
         }
       }
-      *wrotetext = true;
       break;
     default:
-      fprintf(stderr, "unhandled ltype %d\n", n->ttype->ltype);
-      return 0; // FIXME
+      break;
   }
-  for(unsigned z = 0 ; z < n->subcount ; ++z){
-    if(draw_domnode(p, dom, &n->subs[z], wrotetext, insubsec)){
+}
+
+static const unitmetrics*
+unit_metrics(const layunit* u, unsigned width){
+  for(unsigned i = 0 ; i < LAYOUT_WIDTHS ; ++i){
+    if(u->metrics[i].width == width){
+      return &u->metrics[i];
+    }
+  }
+  return NULL;
+}
+
+// lay the unit out into its own plane at the current width, if it isn't
+// already, and remember its geometry.
+static const unitmetrics*
+layout_unit(pageman* pm, layunit* u){
+  if(u->n == NULL){
+    struct ncplane_options nopts = {
+      .rows = 1,
+      .cols = pm->width,
+      .flags = NCPLANE_OPTION_AUTOGROW | NCPLANE_OPTION_VSCROLL,
+    };
+    if((u->n = ncplane_create(pm->scratch, &nopts)) == NULL){
+      return NULL;
+    }
+    draw_unit(u->n, u);
+    const unitmetrics* um = unit_metrics(u, pm->width);
+    if(um == NULL){
+      unitmetrics* slot = &u->metrics[u->nextmetric];
+      u->nextmetric = (u->nextmetric + 1) % LAYOUT_WIDTHS;
+      slot->width = pm->width;
+      slot->advance = ncplane_cursor_y(u->n);
+      slot->rows = ncplane_dim_y(u->n);
+    }
+  }
+  return unit_metrics(u, pm->width);
+}
+
+// measure units until we know where every unit touching document rows up
+// through |row| begins, or we run out of units.
+static int
+measure_through_row(pageman* pm, int row){
+  while(pm->measured < pm->ucount && pm->starts[pm->measured] <= row){
+    layunit* u = &pm->units[pm->measured];
+    const unitmetrics* um = unit_metrics(u, pm->width);
+    if(um == NULL && (um = layout_unit(pm, u)) == NULL){
       return -1;
     }
+    const int start = pm->starts[pm->measured];
+    if(u->section >= 0){
+      docstructure_sety(pm->dom->ds, u->section, start);
+    }
+    if(start + um->rows > pm->docrows){
+      pm->docrows = start + um->rows;
+    }
+    pm->starts[++pm->measured] = start + um->advance;
   }
   return 0;
 }
 
-// for now, we draw the entire thing, resizing as necessary, and we'll
-// scroll the entire plane. higher memory cost, longer initial latency,
-// very fast moves.
 static int
-draw_content(struct ncplane* stdn, struct ncplane* p){
-  pagedom* dom = ncplane_userptr(p);
-  unsigned wrotetext = 0; // unused by us
-  unsigned insubsec = 0;
-  docstructure_free(dom->ds);
-  dom->ds = docstructure_create(stdn);
-  if(dom->ds == NULL){
+measure_through_unit(pageman* pm, unsigned idx){
+  while(pm->measured <= idx && pm->measured < pm->ucount){
+    if(measure_through_row(pm, pm->starts[pm->measured])){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// the document's height as far as it's known, never shorter than the view.
+static unsigned
+pageman_rows(const pageman* pm){
+  unsigned minrows = ncplane_dim_y(pm->page) - 1;
+  return pm->docrows > minrows ? pm->docrows : minrows;
+}
+
+static void
+copy_unit_row(struct ncplane* dst, int dsty, struct ncplane* src, int srcy){
+  for(unsigned x = 0 ; x < ncplane_dim_x(src) ; ++x){
+    nccell c = NCCELL_TRIVIAL_INITIALIZER;
+    if(ncplane_at_yx_cell(src, srcy, x, &c) > 0 && !nccell_wide_right_p(&c)){
+      ncplane_set_channels(dst, c.channels);
+      ncplane_set_styles(dst, c.stylemask);
+      ncplane_putegc_yx(dst, dsty, x, nccell_extended_gcluster(src, &c), NULL);
+    }
+    nccell_release(src, &c);
+  }
+}
+
+// redraw the viewport from the units it shows, laying out any which aren't
+// yet, and releasing the planes of those which have moved well out of view.
+static int
+draw_content(pageman* pm){
+  const int viewrows = ncplane_dim_y(pm->page);
+  const int top = -pm->pagey;
+  const int bottom = top + viewrows; // exclusive
+  if(measure_through_row(pm, bottom)){
     return -1;
   }
-  return draw_domnode(p, dom, dom->root, &wrotetext, &insubsec);
+  ncplane_erase(pm->page);
+  for(unsigned i = 0 ; i < pm->measured ; ++i){
+    layunit* u = &pm->units[i];
+    const unitmetrics* um = unit_metrics(u, pm->width);
+    const int start = pm->starts[i];
+    const int end = start + um->rows; // exclusive
+    if(end < top - viewrows || start >= bottom + viewrows){
+      if(u->n){
+        ncplane_destroy(u->n);
+        u->n = NULL;
+      }
+      continue;
+    }
+    if(end <= top || start >= bottom){
+      continue;
+    }
+    if(layout_unit(pm, u) == NULL){
+      return -1;
+    }
+    for(int r = start > top ? start : top ; r < end && r < bottom ; ++r){
+      copy_unit_row(pm->page, r - top, u->n, r - start);
+    }
+  }
+  return 0;
+}
+
+// forget all layout done at the old width.
+static void
+pageman_relayout(pageman* pm, unsigned width){
+  for(unsigned i = 0 ; i < pm->ucount ; ++i){
+    if(pm->units[i].n){
+      ncplane_destroy(pm->units[i].n);
+      pm->units[i].n = NULL;
+    }
+  }
+  for(unsigned s = 0 ; s < pm->seccount ; ++s){
+    docstructure_sety(pm->dom->ds, s, INT_MAX);
+  }
+  pm->width = width;
+  pm->measured = 0;
+  pm->docrows = 0;
 }
 
+// keep the unit which was at the top of the view there across the resize.
 static int
 resize_pman(struct ncplane* pman){
+  pageman* pm = ncplane_userptr(pman);
   unsigned dimy, dimx;
   ncplane_dim_yx(ncplane_parent_const(pman), &dimy, &dimx);
   ncplane_resize_simple(pman, dimy - 1, dimx);
-  ncplane_erase(pman);
-  struct ncplane* stdn = notcurses_stdplane(ncplane_notcurses(pman));
-  int r = draw_content(stdn, pman);
-  ncplane_move_yx(pman, 0, 0);
-  return r;
+  if(dimx != pm->width){
+    unsigned topunit = 0;
+    while(topunit + 1 < pm->measured && pm->starts[topunit + 1] <= -pm->pagey){
+      ++topunit;
+    }
+    const bool attop = pm->pagey > 0;
+    pageman_relayout(pm, dimx);
+    if(measure_through_unit(pm, topunit)){
+      return -1;
+    }
+    if(!attop){
+      pm->pagey = -pm->starts[topunit];
+    }
+  }
+  return draw_content(pm);
 }
 
-// we create a plane sized appropriately for the troff data. all we do
-// after that is move the plane up and down.
+static void
+pageman_destroy(pageman* pm){
+  for(unsigned i = 0 ; i < pm->ucount ; ++i){
+    ncplane_destroy(pm->units[i].n);
+  }
+  ncplane_destroy(pm->scratch);
+  free(pm->units);
+  free(pm->secunits);
+  free(pm->starts);
+}
+
+// we create a plane the size of the viewport, and lay out only as much of
+// the troff data as is needed to fill it.
 static struct ncplane*
 render_troff(struct notcurses* nc, const unsigned char* map, size_t mlen,
-             pagedom* dom){
+             pagedom* dom, pageman* pm){
   unsigned dimy, dimx;
   struct ncplane* stdn = notcurses_stddim_yx(nc, &dimy, &dimx);
-  // this is just an estimate
   if(troff_parse(map, mlen, dom)){
     return NULL;
   }
-  // this is just an estimate
+  struct ncplane_options sopts = {
+    .rows = 1,
+    .cols = 1,
+  };
+  if((pm->scratch = ncpile_create(nc, &sopts)) == NULL){
+    return NULL;
+  }
   struct ncplane_options popts = {
-    .rows = dimy - 2,
+    .rows = dimy - 1,
     .cols = dimx,
-    .y = 1,
-    .userptr = dom,
+    .userptr = pm,
     .resizecb = resize_pman,
-    .flags = NCPLANE_OPTION_AUTOGROW | NCPLANE_OPTION_VSCROLL,
   };
   struct ncplane* pman = ncplane_create(stdn, &popts);
   if(pman == NULL){
     return NULL;
   }
   ncplane_set_base(pman, " ", 0, 0);
-  if(draw_content(stdn, pman)){
+  pm->page = pman;
+  // the structure bar must be created after the page, so that it's on top
+  dom->ds = docstructure_create(stdn);
+  if(dom->ds == NULL){
+    ncplane_destroy(pman);
+    return NULL;
+  }
+  pm->dom = dom;
+  unsigned wrotetext = 0;
+  unsigned insubsec = 0;
+  if(flatten_domnode(pm, dom->root, &wrotetext, &insubsec)){
+    ncplane_destroy(pman);
+    return NULL;
+  }
+  if((pm->starts = malloc(sizeof(*pm->starts) * (pm->ucount + 1))) == NULL){
+    ncplane_destroy(pman);
+    return NULL;
+  }
+  pm->starts[0] = 0;
+  pm->width = dimx;
+  pm->pagey = 1;
+  if(draw_content(pm)){
     ncplane_destroy(pman);
     return NULL;
   }
@@ -548,6 +815,7 @@ manloop(struct notcurses* nc, const char* arg, unsigned noui){
   struct ncplane* page = NULL;
   struct ncplane* bar = NULL;
   pagedom dom = {0};
+  pageman pm = {0};
   size_t len;
   unsigned char* buf = get_troff_data(arg, &len);
   if(buf == NULL){
@@ -557,7 +825,7 @@ manloop(struct notcurses* nc, const char* arg, unsigned noui){
   if(dom.trie == NULL){
     goto done;
   }
-  page = render_troff(nc, buf, len, &dom);
+  page = render_troff(nc, buf, len, &dom, &pm);
   if(page == NULL){
     goto done;
   }
@@ -575,7 +843,7 @@ manloop(struct notcurses* nc, const char* arg, unsigned noui){
   uint32_t key;
   do{
     bool movedown = false;
-    int newy = ncplane_y(page);
+    int newy = pm.pagey;
     ncinput ni;
     key = notcurses_get(nc, NULL, &ni);
     if(ni.evtype == NCTYPE_RELEASE){
@@ -594,22 +862,27 @@ manloop(struct notcurses* nc, const char* arg, unsigned noui){
         newy = docstructure_prev(dom.ds);
         break;
       case 'l': case NCKEY_RIGHT:
+        if(docstructure_current(dom.ds) + 1 < pm.seccount){
+          if(measure_through_unit(&pm, pm.secunits[docstructure_current(dom.ds) + 1])){
+            goto done;
+          }
+        }
         newy = docstructure_next(dom.ds);
         movedown = true;
         break;
       case 'k': case NCKEY_UP:
-        newy = ncplane_y(page) + 1;
+        newy = pm.pagey + 1;
         break;
       // we can move down iff our last line is beyond the visible area
       case 'j': case NCKEY_DOWN:
-        newy = ncplane_y(page) - 1;
+        newy = pm.pagey - 1;
         movedown = true;
         break;
       case 'b': case NCKEY_PGUP:{
-        newy = ncplane_y(page) + (int)ncplane_dim_y(stdn);
+        newy = pm.pagey + (int)ncplane_dim_y(stdn);
         break;
       }case 'f': case NCKEY_PGDOWN:{
-        newy = ncplane_y(page) - (int)ncplane_dim_y(stdn) + 1;
+        newy = pm.pagey - (int)ncplane_dim_y(stdn) + 1;
         movedown = true;
         break;
       case 'g': case NCKEY_HOME:
@@ -622,11 +895,19 @@ manloop(struct notcurses* nc, const char* arg, unsigned noui){
     if(newy > 1){
       newy = 1;
     }
-    if(newy + (int)ncplane_dim_y(page) < (int)ncplane_dim_y(stdn)){
-      newy += (int)ncplane_dim_y(stdn) - (newy + (int)ncplane_dim_y(page)) - 1;
+    // we only know the document's end once we've measured through it
+    if(measure_through_row(&pm, (int)ncplane_dim_y(stdn) - newy)){
+      goto done;
+    }
+    const int docrows = pageman_rows(&pm);
+    if(newy + docrows < (int)ncplane_dim_y(stdn)){
+      newy += (int)ncplane_dim_y(stdn) - (newy + docrows) - 1;
     }
-    if(newy != ncplane_y(page)){
-      ncplane_move_yx(page, newy, 0);
+    if(newy != pm.pagey){
+      pm.pagey = newy;
+      if(draw_content(&pm)){
+        goto done;
+      }
       docstructure_move(dom.ds, newy, movedown);
       if(notcurses_render(nc)){
         goto done;
@@ -638,6 +919,7 @@ done:
   if(page){
     ncplane_destroy(page);
   }
+  pageman_destroy(&pm);
   ncplane_destroy(bar);
   if(buf){
     munmap(buf, len);
@@ -148,6 +148,16 @@ int docstructure_add(docstructure* ds, const char* title, int y){
   return 0;
 }
 
+void docstructure_sety(docstructure* ds, unsigned idx, int y){
+  if(idx < ds->count){
+    ds->nodes[idx]->y = -y;
+  }
+}
+
+unsigned docstructure_current(const docstructure* ds){
+  return ds->curnode;
+}
+
 // returns corresponding y
 int docstructure_prev(docstructure* ds){
   if(ds->curnode){
@@ -13,9 +13,17 @@ void docstructure_free(struct docstructure* ds);
 
 void docstructure_toggle(struct ncplane* p, struct ncplane* b, struct docstructure *ds);
 
-// add the specified [sub]section to the document strucure.
+// add the specified [sub]section to the document strucure. sections which
+// haven't yet been laid out ought be added with a |y| of INT_MAX, and later
+// placed with docstructure_sety().
 int docstructure_add(struct docstructure* ds, const char* title, int y);
 
+// set the row of the |idx|th section added.
+void docstructure_sety(struct docstructure* ds, unsigned idx, int y);
+
+// index of the current section.
+unsigned docstructure_current(const struct docstructure* ds);
+
 // update the docstructure browser based off a move of the page plane from to |newy|.
 // |movedown| ought be non-zero iff the move was down.
 int docstructure_move(struct docstructure* ds, int newy, unsigned movedown);
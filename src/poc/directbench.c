@@ -0,0 +1,139 @@
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <locale.h>
+#include <inttypes.h>
+#include <notcurses/direct.h>
+#include <notcurses/notcurses.h>
+
+// colorize a large report using direct mode, once flushing after each color
+// or style change (the default), and once with NCDIRECT_OPTION_BUFFERED_OUTPUT.
+// then dump a 200x60 half-block image a number of times. timings are written
+// to stderr, so redirect stdout to see them clearly.
+
+#define IMGROWS 60
+#define IMGCOLS 200
+#define IMGREPS 20
+
+static uint64_t
+nowns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int
+report(struct ncdirect* n, int lines){
+  int ret = 0;
+  for(int i = 0 ; i < lines ; ++i){
+    ret |= ncdirect_set_fg_rgb(n, 0x808080);
+    printf("%6d ", i);
+    ret |= ncdirect_set_fg_rgb(n, (i * 0x010305) & 0xffffff);
+    ret |= ncdirect_on_styles(n, NCSTYLE_BOLD);
+    printf("%-24s", i % 3 ? "nominal" : "degraded");
+    ret |= ncdirect_off_styles(n, NCSTYLE_BOLD);
+    ret |= ncdirect_set_fg_default(n);
+    printf(" %08x\n", i * 2654435761u);
+  }
+  ret |= ncdirect_flush(n);
+  return ret;
+}
+
+static int
+timed_report(uint64_t flags, int lines, uint64_t* ns){
+  struct ncdirect* n = ncdirect_core_init(NULL, stdout, flags);
+  if(n == NULL){
+    return -1;
+  }
+  uint64_t start = nowns();
+  int ret = report(n, lines);
+  *ns = nowns() - start;
+  return ncdirect_stop(n) | ret;
+}
+
+// a gradient of IMGROWSxIMGCOLS cells, each holding two vertical pixels
+static ncdirectf*
+make_image(void){
+  const int pixy = IMGROWS * 2;
+  const int pixx = IMGCOLS;
+  uint32_t* rgba = malloc(sizeof(*rgba) * pixy * pixx);
+  if(rgba == NULL){
+    return NULL;
+  }
+  for(int y = 0 ; y < pixy ; ++y){
+    for(int x = 0 ; x < pixx ; ++x){
+      uint32_t* px = &rgba[y * pixx + x];
+      ncpixel_set_a(px, 0xff);
+      ncpixel_set_r(px, y * 255 / pixy);
+      ncpixel_set_g(px, x * 255 / pixx);
+      ncpixel_set_b(px, (x + y) % 256);
+    }
+  }
+  ncdirectf* img = ncvisual_from_rgba(rgba, pixy, pixx * sizeof(*rgba), pixx);
+  free(rgba);
+  return img;
+}
+
+static int
+timed_image(int reps, uint64_t* ns){
+  struct ncdirect* n = ncdirect_core_init(NULL, stdout, 0);
+  if(n == NULL){
+    return -1;
+  }
+  ncdirectf* img = make_image();
+  if(img == NULL){
+    ncdirect_stop(n);
+    return -1;
+  }
+  struct ncvisual_options vopts = {
+    .blitter = NCBLIT_2x1,
+    .flags = NCVISUAL_OPTION_NODEGRADE,
+  };
+  int ret = 0;
+  *ns = 0;
+  for(int i = 0 ; i < reps && !ret ; ++i){
+    ncdirectv* v = ncdirectf_render(n, img, &vopts);
+    if(v == NULL){
+      ret = -1;
+      break;
+    }
+    uint64_t start = nowns();
+    ret |= ncdirect_raster_frame(n, v, NCALIGN_LEFT);
+    *ns += nowns() - start;
+  }
+  ncdirectf_free(img);
+  return ncdirect_stop(n) | ret;
+}
+
+int main(int argc, char** argv){
+  if(!setlocale(LC_ALL, "")){
+    fprintf(stderr, "couldn't set locale\n");
+    return EXIT_FAILURE;
+  }
+  int lines = 10000;
+  if(argc > 1){
+    lines = atoi(argv[1]);
+    if(lines <= 0){
+      fprintf(stderr, "usage: %s [ lines ]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  uint64_t flushed, buffered;
+  if(timed_report(0, lines, &flushed)){
+    return EXIT_FAILURE;
+  }
+  if(timed_report(NCDIRECT_OPTION_BUFFERED_OUTPUT, lines, &buffered)){
+    return EXIT_FAILURE;
+  }
+  uint64_t imaged;
+  if(timed_image(IMGREPS, &imaged)){
+    return EXIT_FAILURE;
+  }
+  fprintf(stderr, "%d lines: %.3fs flushing, %.3fs buffered (%.1fx)\n",
+          lines, flushed / 1e9, buffered / 1e9,
+          buffered ? (double)flushed / buffered : 0);
+  fprintf(stderr, "%d %dx%d images: %.3fs (%.2fms each)\n", IMGREPS,
+          IMGCOLS, IMGROWS, imaged / 1e9, imaged / 1e6 / IMGREPS);
+  return EXIT_SUCCESS;
+}
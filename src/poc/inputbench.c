@@ -0,0 +1,251 @@
+#define _GNU_SOURCE // memmem(3)
+#include <time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/ioctl.h>
+#include <notcurses/notcurses.h>
+
+// we're done once input has been quiet for this long
+#define QUIETSECS 1
+
+// replay captured terminal traffic (or, absent a capture, a synthesized mix
+// of ASCII, UTF-8, mouse reports, and keyboard escapes) through the input
+// layer, and report the rate at which it was lexed into events. we play the
+// part of the terminal on the master side of a pty, answering the Device
+// Attributes query which paces notcurses_init(). the child runs Notcurses on
+// the slave side, which it takes as its controlling terminal.
+
+static void
+usage(const char* argv0){
+  fprintf(stderr, "usage: %s [ -n megabytes ] [ capture ]\n", argv0);
+  exit(EXIT_FAILURE);
+}
+
+static uint64_t
+nowns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// synthesize approximately |len| bytes of mixed terminal input
+static char*
+synthesize(size_t len, size_t* outlen){
+  static const char text[] = "the quick brown fox jumps over the lazy dog. ";
+  static const char utf8[] = "\xc3\xbcn\xc3\xaf" "c\xc3\xb8" "d\xc3\xa9 \xe2\x98\x83 "
+                             "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e ";
+  char* buf = malloc(len + 128);
+  if(buf == NULL){
+    return NULL;
+  }
+  size_t used = 0;
+  unsigned iter = 0;
+  while(used < len){
+    int r;
+    switch(iter % 6){
+      case 0: r = snprintf(buf + used, 128, "%s", text); break;
+      case 1: r = snprintf(buf + used, 128, "%s", utf8); break;
+      case 2: r = snprintf(buf + used, 128, "\x1b[<35;%u;%uM\x1b[<35;%u;%uM",
+                           iter % 80 + 1, iter % 24 + 1,
+                           (iter + 1) % 80 + 1, iter % 24 + 1); break;
+      case 3: r = snprintf(buf + used, 128, "\x1b[97;5u\x1b[A\x1b[15~"); break;
+      case 4: r = snprintf(buf + used, 128, "\x1b[<0;%u;%uM\x1b[<0;%u;%um",
+                           iter % 80 + 1, iter % 24 + 1,
+                           iter % 80 + 1, iter % 24 + 1); break;
+      default: r = snprintf(buf + used, 128, "%s%s", text, text); break;
+    }
+    used += r;
+    ++iter;
+  }
+  *outlen = used;
+  return buf;
+}
+
+static char*
+slurp(const char* fn, size_t* outlen){
+  FILE* fp = fopen(fn, "rb");
+  if(fp == NULL){
+    fprintf(stderr, "couldn't open %s (%s)\n", fn, strerror(errno));
+    return NULL;
+  }
+  size_t size = 0, used = 0;
+  char* buf = NULL;
+  size_t r;
+  do{
+    if(used == size){
+      size = size ? size * 2 : BUFSIZ;
+      char* tmp = realloc(buf, size);
+      if(tmp == NULL){
+        free(buf);
+        fclose(fp);
+        return NULL;
+      }
+      buf = tmp;
+    }
+    r = fread(buf + used, 1, size - used, fp);
+    used += r;
+  }while(r);
+  fclose(fp);
+  *outlen = used;
+  return buf;
+}
+
+// runs on the slave side. reads events until input goes quiet. the ring
+// between the input thread and us is bounded, so some events might be
+// dropped when we fall behind; they were nonetheless lexed, and count towards
+// the rate (they're reported among the input errors).
+static int
+consume(size_t bytes){
+  notcurses_options opts = {
+    .flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN
+             | NCOPTION_NO_CLEAR_BITMAPS,
+  };
+  struct notcurses* nc = notcurses_core_init(&opts, NULL);
+  if(nc == NULL){
+    return -1;
+  }
+  notcurses_linesigs_disable(nc);
+  ncinput ni;
+  uint64_t events = 0;
+  uint64_t start = 0, end = 0;
+  for(;;){
+    // input deadlines are measured against CLOCK_MONOTONIC
+    struct timespec dl;
+    clock_gettime(CLOCK_MONOTONIC, &dl);
+    dl.tv_sec += start ? QUIETSECS : 10;
+    uint32_t id = notcurses_get(nc, &dl, &ni);
+    if(id == 0 || id == (uint32_t)-1){
+      break;
+    }
+    end = nowns();
+    if(start == 0){
+      start = end;
+    }
+    ++events;
+  }
+  ncstats stats;
+  notcurses_stats(nc, &stats);
+  notcurses_stop(nc);
+  if(events == 0){
+    fprintf(stderr, "didn't receive any input\n");
+    return -1;
+  }
+  double secs = (end - start) / 1e9;
+  uint64_t lexed = events + stats.input_errors;
+  fprintf(stderr, "%zuB -> %" PRIu64 " events (%" PRIu64 " delivered, %" PRIu64
+          " errors) in %.3fs: %.2f MB/s, %.2f Mevents/s\n", bytes, lexed, events,
+          stats.input_errors, secs, secs > 0 ? bytes / secs / 1e6 : 0,
+          secs > 0 ? lexed / secs / 1e6 : 0);
+  return 0;
+}
+
+// runs on the master side. answers queries, and writes |traffic| once the
+// child is ready to receive it.
+static int
+produce(int master, const char* traffic, size_t len, pid_t child){
+  size_t sent = 0;
+  bool ready = false;
+  uint64_t readyat = 0;
+  char carry[3] = {0};
+  int status;
+  while(waitpid(child, &status, WNOHANG) == 0){
+    struct pollfd pfd = { .fd = master, .events = POLLIN, };
+    if(ready && sent < len && nowns() > readyat){
+      pfd.events |= POLLOUT;
+    }
+    if(poll(&pfd, 1, 10) < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      return -1;
+    }
+    if(pfd.revents & POLLIN){
+      // keep the tail of the previous read, lest a query be split across reads
+      char rbuf[BUFSIZ + 3];
+      memcpy(rbuf, carry, sizeof(carry));
+      ssize_t r = read(master, rbuf + sizeof(carry), BUFSIZ);
+      if(r > 0){
+        r += sizeof(carry);
+        memcpy(carry, rbuf + r - sizeof(carry), sizeof(carry));
+        // cursor location report, as requested prior to device attributes
+        if(memmem(rbuf, r, "\x1b[6n", 4)){
+          if(write(master, "\x1b[1;1R", 6) != 6){
+            return -1;
+          }
+        }
+        // primary device attributes query. we're a vt220, sure.
+        if(!ready && memmem(rbuf, r, "\x1b[c", 3)){
+          if(write(master, "\x1b[?62;22c", 9) != 9){
+            return -1;
+          }
+          ready = true;
+          readyat = nowns() + 200000000ull; // let initialization wrap up
+        }
+      }
+    }
+    if(pfd.revents & POLLOUT){
+      ssize_t w = write(master, traffic + sent, len - sent);
+      if(w > 0){
+        sent += w;
+      }
+    }
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+int main(int argc, char** argv){
+  size_t megs = 4;
+  int c;
+  while((c = getopt(argc, argv, "n:")) != -1){
+    if(c == 'n'){
+      megs = strtoul(optarg, NULL, 0);
+    }else{
+      usage(argv[0]);
+    }
+  }
+  size_t len;
+  char* traffic;
+  if(argv[optind]){
+    traffic = slurp(argv[optind], &len);
+  }else{
+    traffic = synthesize(megs * 1024 * 1024, &len);
+  }
+  if(traffic == NULL){
+    return EXIT_FAILURE;
+  }
+  int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if(master < 0 || grantpt(master) || unlockpt(master)){
+    fprintf(stderr, "couldn't get pty (%s)\n", strerror(errno));
+    return EXIT_FAILURE;
+  }
+  struct winsize ws = { .ws_row = 24, .ws_col = 80, };
+  if(ioctl(master, TIOCSWINSZ, &ws)){
+    fprintf(stderr, "couldn't set geometry (%s)\n", strerror(errno));
+    return EXIT_FAILURE;
+  }
+  const char* slave = ptsname(master);
+  pid_t pid = fork();
+  if(pid < 0){
+    return EXIT_FAILURE;
+  }else if(pid == 0){
+    close(master);
+    setsid();
+    int sfd = open(slave, O_RDWR); // becomes our controlling terminal
+    if(sfd < 0 || dup2(sfd, STDIN_FILENO) < 0 || dup2(sfd, STDOUT_FILENO) < 0){
+      exit(EXIT_FAILURE);
+    }
+    exit(consume(len) ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+  int ret = produce(master, traffic, len, pid);
+  close(master);
+  free(traffic);
+  return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+}
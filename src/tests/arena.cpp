@@ -0,0 +1,151 @@
+#include "main.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+
+// resident set size in KiB, or 0 if it can't be determined
+static auto
+rss_kib() -> long {
+  long kib = 0;
+  FILE* fp = fopen("/proc/self/statm", "r");
+  if(fp){
+    long size, resident;
+    if(fscanf(fp, "%ld %ld", &size, &resident) == 2){
+      kib = resident * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+    fclose(fp);
+  }
+  return kib;
+}
+
+TEST_CASE("PlaneArena") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(n_);
+
+  // a plane built from a recycled shell and framebuffer mustn't inherit
+  // anything from its predecessor
+  SUBCASE("RecycledPlanesAreClean") {
+    int dummy;
+    struct ncplane_options nopts{};
+    nopts.rows = 4;
+    nopts.cols = 8;
+    nopts.name = "dirty";
+    nopts.userptr = &dummy;
+    nopts.flags = NCPLANE_OPTION_VSCROLL;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    ncplane_set_fg_rgb(n, 0x00ff00);
+    CHECK(0 < ncplane_putstr(n, "grime"));
+    CHECK(0 == ncplane_destroy(n));
+    nopts.name = nullptr;
+    nopts.userptr = nullptr;
+    nopts.flags = 0;
+    n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    auto name = ncplane_name(n);
+    REQUIRE(nullptr != name);
+    CHECK(0 == strcmp(name, ""));
+    free(name);
+    CHECK(nullptr == ncplane_userptr(n));
+    CHECK(!ncplane_scrolling_p(n));
+    CHECK(0 == ncplane_channels(n));
+    unsigned y, x;
+    ncplane_cursor_yx(n, &y, &x);
+    CHECK(0 == y);
+    CHECK(0 == x);
+    for(unsigned yy = 0 ; yy < 4 ; ++yy){
+      for(unsigned xx = 0 ; xx < 8 ; ++xx){
+        nccell c = NCCELL_TRIVIAL_INITIALIZER;
+        CHECK(0 <= ncplane_at_yx_cell(n, yy, xx, &c));
+        CHECK(0 == c.gcluster);
+        CHECK(0 == c.channels);
+        nccell_release(n, &c);
+      }
+    }
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  // growing within and across size classes must preserve the contents
+  SUBCASE("ResizeAcrossClasses") {
+    struct ncplane_options nopts{};
+    nopts.rows = 1;
+    nopts.cols = 10;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    CHECK(0 < ncplane_putstr(n, "0123456789"));
+    for(unsigned rows = 2 ; rows < 600 ; rows += 7){
+      CHECK(0 == ncplane_resize_simple(n, rows, 10));
+      CHECK(0 < ncplane_putstr_yx(n, rows - 1, 0, "x"));
+      auto egc = ncplane_at_yx(n, 0, 9, nullptr, nullptr);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, "9"));
+      free(egc);
+      egc = ncplane_at_yx(n, rows - 1, 1, nullptr, nullptr);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, ""));
+      free(egc);
+    }
+    CHECK(0 == ncplane_resize_simple(n, 1, 10));
+    auto egc = ncplane_at_yx(n, 0, 0, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK(0 == strcmp(egc, "0"));
+    free(egc);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  // throughput of creating and destroying small planes, as widgets do, and
+  // the resident set before and after
+  SUBCASE("ChurnBenchmark") {
+    constexpr int ITERS = 100000;
+    const long rssbefore = rss_kib();
+    struct ncplane_options nopts{};
+    nopts.rows = 3;
+    nopts.cols = 20;
+    nopts.name = "tooltip";
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0 ; i < ITERS ; ++i){
+      auto n = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != n);
+      CHECK(0 == ncplane_destroy(n));
+    }
+    auto churn = std::chrono::steady_clock::now() - start;
+    // keep a working set of differently-sized planes, replacing one at a time
+    std::vector<struct ncplane*> live(64, nullptr);
+    unsigned seed = 1;
+    start = std::chrono::steady_clock::now();
+    for(int i = 0 ; i < ITERS ; ++i){
+      seed = seed * 1103515245 + 12345;
+      auto& slot = live[(seed >> 16) % live.size()];
+      CHECK(0 == ncplane_destroy(slot));
+      nopts.rows = 1 + (seed >> 8) % 8;
+      nopts.cols = 1 + (seed >> 4) % 80;
+      slot = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != slot);
+    }
+    auto mixed = std::chrono::steady_clock::now() - start;
+    for(auto n : live){
+      CHECK(0 == ncplane_destroy(n));
+    }
+    const long rssafter = rss_kib();
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    std::cout << "plane churn: " << duration_cast<nanoseconds>(churn).count() / ITERS
+              << "ns/plane fixed, " << duration_cast<nanoseconds>(mixed).count() / ITERS
+              << "ns/plane mixed, RSS " << rssbefore << "KiB -> "
+              << rssafter << "KiB" << std::endl;
+    // whatever the arena retains is bounded (ASan's quarantine isn't)
+#ifndef __SANITIZE_ADDRESS__
+    CHECK(rssafter - rssbefore < 8192);
+#endif
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
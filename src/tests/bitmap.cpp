@@ -731,5 +731,146 @@ TEST_CASE("Bitmaps") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // once drawn, quiescent sprixels leave the worklist, and further renders
+  // elide them without visiting them.
+  SUBCASE("BitmapGridQuiescence") {
+    const unsigned count = 16;
+    auto y = nc_->tcache.cellpxy;
+    auto x = nc_->tcache.cellpxx;
+    std::vector<uint32_t> v(x * y, htole(0xffccccff));
+    auto ncv = ncvisual_from_rgba(v.data(), y, sizeof(decltype(v)::value_type) * x, x);
+    REQUIRE(nullptr != ncv);
+    std::vector<ncplane*> grid;
+    struct ncvisual_options vopts{};
+    vopts.n = n_;
+    vopts.blitter = NCBLIT_PIXEL;
+    vopts.flags = NCVISUAL_OPTION_NODEGRADE | NCVISUAL_OPTION_CHILDPLANE;
+    for(unsigned i = 0 ; i < count ; ++i){
+      vopts.y = i % 4;
+      vopts.x = (i / 4) * 2;
+      auto n = ncvisual_blit(nc_, ncv, &vopts);
+      REQUIRE(nullptr != n);
+      grid.push_back(n);
+    }
+    auto p = ncplane_pile(n_);
+    CHECK(count == p->sprixelcount);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == notcurses_render(nc_));
+    if(!nc_->tcache.pixel_draw_late){
+      CHECK(nullptr == p->sprixelwork);
+    }
+    ncstats stats{};
+    notcurses_stats(nc_, &stats);
+    auto elisions = stats.sprixelelisions;
+    auto emissions = stats.sprixelemissions;
+    CHECK(0 == notcurses_render(nc_));
+    notcurses_stats(nc_, &stats);
+    CHECK(emissions == stats.sprixelemissions);
+    CHECK(elisions + count == stats.sprixelelisions);
+    // moving one sprixel puts only it back on the worklist
+    CHECK(0 == ncplane_move_yx(grid[0], 6, 0));
+    CHECK(nullptr != p->sprixelwork);
+    CHECK(nullptr == p->sprixelwork->wnext);
+    CHECK(0 == notcurses_render(nc_));
+    for(auto n : grid){
+      CHECK(0 == ncplane_destroy(n));
+    }
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == p->sprixelcount);
+    CHECK(nullptr == p->sprixelwork);
+    ncvisual_destroy(ncv);
+  }
+
+  CHECK(!notcurses_stop(nc_));
+}
+
+// with NCOPTION_RETAIN_PILE_BITMAPS, kitty graphics of a pile which is
+// switched away from are only unplaced, and placed anew upon its return.
+TEST_CASE("RetainedBitmaps") {
+  notcurses_options nopts{};
+  nopts.loglevel = NCLOGLEVEL_SILENT;
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS
+                | NCOPTION_NO_ALTERNATE_SCREEN
+                | NCOPTION_DRAIN_INPUT
+                | NCOPTION_RETAIN_PILE_BITMAPS;
+  auto nc_ = notcurses_init(&nopts, nullptr);
+  REQUIRE(nullptr != nc_);
+  unsigned dimy, dimx;
+  auto n_ = notcurses_stddim_yx(nc_, &dimy, &dimx);
+  REQUIRE(n_);
+
+  if(notcurses_check_pixel_support(nc_) < NCPIXEL_KITTY_STATIC){
+    CHECK(!notcurses_stop(nc_));
+    return;
+  }
+
+  auto y = 10;
+  auto x = 10;
+  std::vector<uint32_t> v(x * y, htole(0xe61c28ff));
+  auto ncv = ncvisual_from_rgba(v.data(), y, sizeof(decltype(v)::value_type) * x, x);
+  REQUIRE(nullptr != ncv);
+  struct ncvisual_options vopts{};
+  vopts.blitter = NCBLIT_PIXEL;
+  vopts.flags = NCVISUAL_OPTION_NODEGRADE | NCVISUAL_OPTION_CHILDPLANE;
+  struct ncplane_options popts{};
+  popts.rows = dimy;
+  popts.cols = dimx;
+  popts.name = "tab";
+
+  SUBCASE("ParkedWhileHidden") {
+    vopts.n = n_;
+    auto n = ncvisual_blit(nc_, ncv, &vopts);
+    REQUIRE(nullptr != n);
+    auto s = n->sprite;
+    REQUIRE(nullptr != s);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(SPRIXEL_QUIESCENT == s->invalidated);
+    auto np = ncpile_create(nc_, &popts);
+    REQUIRE(nullptr != np);
+    CHECK(0 == ncpile_render(np));
+    CHECK(0 == ncpile_rasterize(np));
+    // the image data stays loaded in the terminal while its pile is hidden
+    CHECK(SPRIXEL_LOADED == s->invalidated);
+    // only those graphics which could be retransmitted count against the
+    // budget (kitty animation support consumes the glyph once it's drawn)
+    CHECK(ncplane_pile(n_)->parkedbytes == sprixel_parkedbytes(s));
+    ncstats stats;
+    notcurses_stats_reset(nc_, &stats);
+    CHECK(0 == notcurses_render(nc_));
+    notcurses_stats(nc_, &stats);
+    // upon its return, it's placed without being retransmitted
+    CHECK(SPRIXEL_QUIESCENT == s->invalidated);
+    CHECK(0 == stats.sprixelemissions);
+    CHECK(0 == ncplane_pile(n_)->parkedbytes);
+    CHECK(0 == ncplane_destroy(np));
+    CHECK(0 == ncplane_destroy(n));
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  // a parked graphic which is hidden no longer counts against the budget,
+  // and is deleted once its pile is destroyed.
+  SUBCASE("HiddenWhileParked") {
+    auto np = ncpile_create(nc_, &popts);
+    REQUIRE(nullptr != np);
+    vopts.n = np;
+    auto n = ncvisual_blit(nc_, ncv, &vopts);
+    REQUIRE(nullptr != n);
+    auto s = n->sprite;
+    REQUIRE(nullptr != s);
+    CHECK(0 == ncpile_render(np));
+    CHECK(0 == ncpile_rasterize(np));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(SPRIXEL_LOADED == s->invalidated);
+    CHECK(ncplane_pile(np)->parkedbytes == sprixel_parkedbytes(s));
+    CHECK(0 == ncplane_destroy(n));
+    CHECK(SPRIXEL_HIDE == s->invalidated);
+    CHECK(0 == ncplane_pile(np)->parkedbytes);
+    CHECK(0 == ncplane_destroy(np));
+    CHECK(1 == nc_->orphancount);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == nc_->orphancount);
+  }
+
+  ncvisual_destroy(ncv);
   CHECK(!notcurses_stop(nc_));
 }
@@ -250,5 +250,52 @@ TEST_CASE("Blit") {
     }
   }
 
+  // sextant glyphs ought be read back pixel-by-pixel
+  SUBCASE("SextantReverse") {
+    if(notcurses_cansextant(nc_)){
+      struct ncplane_options nopts{};
+      nopts.rows = 1;
+      nopts.cols = 2;
+      auto p = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != p);
+      CHECK(0 == ncplane_set_fg_rgb(p, 0xffffff));
+      CHECK(0 == ncplane_set_bg_rgb(p, 0x000000));
+      CHECK(0 < ncplane_putstr_yx(p, 0, 0, "\U0001fb00\u2590")); // 🬀▐
+      unsigned pxdimy, pxdimx;
+      auto edata = ncplane_as_rgba(p, NCBLIT_3x2, 0, 0, 0, 0, &pxdimy, &pxdimx);
+      REQUIRE(nullptr != edata);
+      CHECK(3 == pxdimy);
+      CHECK(4 == pxdimx);
+      const uint32_t w = htole(0xffffffff);
+      const uint32_t b = htole(0xff000000);
+      const uint32_t expected[12] = {
+        w, b, b, w,
+        b, b, b, w,
+        b, b, b, w,
+      };
+      for(size_t i = 0 ; i < sizeof(expected) / sizeof(*expected) ; ++i){
+        CHECK(edata[i] == expected[i]);
+      }
+      free(edata);
+      CHECK(0 == ncplane_destroy(p));
+    }
+  }
+
+  // glyphs outside of the blitter can't be converted back to pixels
+  SUBCASE("ReverseBlitForeignGlyph") {
+    struct ncplane_options nopts{};
+    nopts.rows = 1;
+    nopts.cols = 2;
+    auto p = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != p);
+    CHECK(1 == ncplane_putchar_yx(p, 0, 0, ' '));
+    auto edata = ncplane_as_rgba(p, NCBLIT_1x1, 0, 0, 0, 0, nullptr, nullptr);
+    CHECK(nullptr != edata);
+    free(edata);
+    CHECK(1 == ncplane_putchar_yx(p, 0, 1, 'x'));
+    CHECK(nullptr == ncplane_as_rgba(p, NCBLIT_1x1, 0, 0, 0, 0, nullptr, nullptr));
+    CHECK(0 == ncplane_destroy(p));
+  }
+
   CHECK(!notcurses_stop(nc_));
 }
@@ -0,0 +1,211 @@
+#include "main.h"
+#include <cstring>
+#include <string>
+
+// compare every cell of two planes of the same geometry
+static void
+check_same_cells(struct ncplane* a, struct ncplane* b){
+  unsigned dimy, dimx;
+  ncplane_dim_yx(a, &dimy, &dimx);
+  for(unsigned y = 0 ; y < dimy ; ++y){
+    for(unsigned x = 0 ; x < dimx ; ++x){
+      uint16_t sa, sb;
+      uint64_t ca, cb;
+      char* ea = ncplane_at_yx(a, y, x, &sa, &ca);
+      char* eb = ncplane_at_yx(b, y, x, &sb, &cb);
+      REQUIRE(nullptr != ea);
+      REQUIRE(nullptr != eb);
+      CHECK(0 == strcmp(ea, eb));
+      CHECK(sa == sb);
+      CHECK(ca == cb);
+      free(ea);
+      free(eb);
+    }
+  }
+}
+
+TEST_CASE("CompactPlanes") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(n_);
+  struct ncplane_options nopts{};
+  nopts.rows = 4;
+  nopts.cols = 20;
+
+  // a compact plane must read back exactly what a normal plane does
+  SUBCASE("MatchesFullCells") {
+    auto full = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != full);
+    nopts.flags = NCPLANE_OPTION_COMPACT;
+    auto compact = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != compact);
+    for(auto n : { full, compact }){
+      for(unsigned y = 0 ; y < 4 ; ++y){
+        ncplane_set_fg_rgb(n, 0x102030 * (y + 1));
+        ncplane_set_bg_alpha(n, y % 2 ? NCALPHA_BLEND : NCALPHA_OPAQUE);
+        ncplane_set_styles(n, y % 2 ? NCSTYLE_BOLD : NCSTYLE_ITALIC | NCSTYLE_UNDERLINE);
+        CHECK(0 < ncplane_putstr_yx(n, y, y, "héllo 🔥 wörld"));
+      }
+      // overwrite the left half of a wide glyph
+      CHECK(0 < ncplane_putchar_yx(n, 1, 7, 'x'));
+    }
+    check_same_cells(full, compact);
+    nccell c = NCCELL_TRIVIAL_INITIALIZER;
+    CHECK(0 < ncplane_at_yx_cell(compact, 0, 6, &c));
+    CHECK(nccell_double_wide_p(&c));
+    CHECK(0 == strcmp(nccell_extended_gcluster(compact, &c), "🔥"));
+    nccell_release(compact, &c);
+    CHECK(0 == ncplane_destroy(full));
+    CHECK(0 == ncplane_destroy(compact));
+  }
+
+  SUBCASE("Scrolling") {
+    nopts.flags = NCPLANE_OPTION_VSCROLL;
+    auto full = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != full);
+    nopts.flags |= NCPLANE_OPTION_COMPACT;
+    auto compact = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != compact);
+    for(auto n : { full, compact }){
+      for(int i = 0 ; i < 10 ; ++i){
+        ncplane_set_fg_rgb(n, 0x010101 * i);
+        CHECK(0 < ncplane_printf(n, "line %d\n", i));
+      }
+    }
+    check_same_cells(full, compact);
+    // the three lines above the cursor hold lines 7..9
+    for(unsigned y = 0 ; y < 3 ; ++y){
+      uint64_t channels;
+      char* egc = ncplane_at_yx(compact, y, 5, nullptr, &channels);
+      REQUIRE(nullptr != egc);
+      CHECK(std::to_string(7 + y) == egc);
+      CHECK(0x010101u * (7 + y) == ncchannels_fg_rgb(channels));
+      free(egc);
+    }
+    CHECK(0 == ncplane_destroy(full));
+    CHECK(0 == ncplane_destroy(compact));
+  }
+
+  SUBCASE("ResizeAndDup") {
+    nopts.flags = NCPLANE_OPTION_COMPACT;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    ncplane_set_fg_rgb(n, 0xabcdef);
+    for(unsigned y = 0 ; y < 4 ; ++y){
+      CHECK(0 < ncplane_putstr_yx(n, y, 0, "0123456789abcdefghij"));
+    }
+    // keep rows 1..2 and columns 5..14
+    CHECK(0 == ncplane_resize(n, 1, 5, 2, 10, 0, 0, 3, 12));
+    uint64_t channels;
+    char* egc = ncplane_at_yx(n, 0, 0, nullptr, &channels);
+    REQUIRE(nullptr != egc);
+    CHECK(0 == strcmp(egc, "5"));
+    CHECK(0xabcdef == ncchannels_fg_rgb(channels));
+    free(egc);
+    egc = ncplane_at_yx(n, 1, 9, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK(0 == strcmp(egc, "e"));
+    free(egc);
+    egc = ncplane_at_yx(n, 2, 11, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK(0 == strcmp(egc, ""));
+    free(egc);
+    auto dup = ncplane_dup(n, nullptr);
+    REQUIRE(nullptr != dup);
+    check_same_cells(n, dup);
+    CHECK(0 == ncplane_destroy(dup));
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  SUBCASE("MergeAndRender") {
+    nopts.flags = NCPLANE_OPTION_COMPACT;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    ncplane_set_bg_rgb(n, 0x224466);
+    CHECK(0 < ncplane_putstr(n, "compact"));
+    CHECK(0 == notcurses_render(nc_));
+    char* egc = notcurses_at_yx(nc_, 0, 2, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK(0 == strcmp(egc, "m"));
+    free(egc);
+    // merge into both a full and a compact plane
+    for(auto flags : { 0ull, NCPLANE_OPTION_COMPACT }){
+      nopts.flags = flags;
+      auto dst = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != dst);
+      CHECK(0 < ncplane_putstr_yx(dst, 1, 0, "below"));
+      CHECK(0 == ncplane_mergedown_simple(n, dst));
+      uint64_t channels;
+      egc = ncplane_at_yx(dst, 0, 6, nullptr, &channels);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, "t"));
+      CHECK(0x224466 == ncchannels_bg_rgb(channels));
+      free(egc);
+      egc = ncplane_at_yx(dst, 1, 4, nullptr, nullptr);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, "w"));
+      free(egc);
+      CHECK(0 == ncplane_destroy(dst));
+    }
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  // churning through more than 65536 channel pairs requires collection of
+  // unused pairs; keeping more than 65536 live requires full cells.
+  SUBCASE("PairOverflow") {
+    nopts.rows = 300;
+    nopts.cols = 300;
+    nopts.flags = NCPLANE_OPTION_COMPACT;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    for(unsigned i = 0 ; i < 70000 ; ++i){
+      ncplane_set_fg_rgb(n, i);
+      CHECK(0 < ncplane_putchar_yx(n, i % 2 ? 299 : 0, 0, 'x'));
+    }
+    uint64_t channels;
+    char* egc = ncplane_at_yx(n, 299, 0, nullptr, &channels);
+    REQUIRE(nullptr != egc);
+    CHECK(69999 == ncchannels_fg_rgb(channels));
+    free(egc);
+    for(unsigned i = 0 ; i < 70000 ; ++i){
+      ncplane_set_fg_rgb(n, i);
+      CHECK(0 < ncplane_putchar_yx(n, i / 300, i % 300, 'y'));
+    }
+    for(unsigned i = 0 ; i < 70000 ; i += 997){
+      egc = ncplane_at_yx(n, i / 300, i % 300, nullptr, &channels);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, "y"));
+      CHECK(i == ncchannels_fg_rgb(channels));
+      free(egc);
+    }
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  // a compact plane ought cost half what a full one does
+  SUBCASE("Footprint") {
+    nopts.rows = 500;
+    nopts.cols = 200;
+    struct ncstats stats;
+    notcurses_stats(nc_, &stats);
+    const auto before = stats.fbbytes;
+    auto full = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != full);
+    notcurses_stats(nc_, &stats);
+    const auto fullbytes = stats.fbbytes - before;
+    CHECK(0 == ncplane_destroy(full));
+    nopts.flags = NCPLANE_OPTION_COMPACT;
+    auto compact = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != compact);
+    notcurses_stats(nc_, &stats);
+    const auto compactbytes = stats.fbbytes - before;
+    CHECK(compactbytes * 2 == fullbytes);
+    CHECK(0 == ncplane_destroy(compact));
+    notcurses_stats(nc_, &stats);
+    CHECK(before == stats.fbbytes);
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
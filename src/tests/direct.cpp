@@ -177,9 +177,25 @@ TEST_CASE("Direct") {
   // make sure that we can pass undefined flags and still create the ncdirect.
   // we don't pass all 1s, or we turn on all logging, and run into trouble!
   SUBCASE("FutureFlags") {
-    auto fnc = ncdirect_init(NULL, stdout, NCDIRECT_OPTION_VERY_VERBOSE << 1u);
+    auto fnc = ncdirect_init(NULL, stdout, NCDIRECT_OPTION_BUFFERED_OUTPUT << 1u);
     REQUIRE(nullptr != fnc);
     CHECK(0 == ncdirect_stop(fnc));
   }
 
+  // color and style changes ought be held until the text they decorate
+  SUBCASE("BufferedOutput") {
+    auto bnc = ncdirect_init(NULL, stdout, NCDIRECT_OPTION_BUFFERED_OUTPUT);
+    REQUIRE(nullptr != bnc);
+    for(unsigned i = 0 ; i < 8 ; ++i){
+      CHECK(0 == ncdirect_set_fg_rgb(bnc, 0x204080 * i));
+      CHECK(0 == ncdirect_set_bg_palindex(bnc, i));
+      printf("buffered %u", i);
+      CHECK(0 == ncdirect_set_bg_default(bnc));
+      CHECK(0 == ncdirect_set_fg_default(bnc));
+      printf("\n");
+    }
+    CHECK(0 == ncdirect_flush(bnc));
+    CHECK(0 == ncdirect_stop(bnc));
+  }
+
 }
@@ -80,5 +80,58 @@ TEST_CASE("Fbuf") {
     fbuf_free(&f);
   }
 
+  // gather splices in with the fbuf's contents, skipping a prefix
+  SUBCASE("FbufWritevSplices") {
+    fbuf f{};
+    CHECK(0 == fbuf_init_small(&f));
+    CHECK(0 < fbuf_puts(&f, "--abcdef"));
+    std::string big(100000, 'X');
+    fbufsplice s[3] = {
+      { 4, "12", 2, {} },
+      { 4, big.c_str(), big.size(), {} },
+      { 8, "end", 3, {} },
+    };
+    char tmpl[] = "/tmp/ncfbufXXXXXX";
+    int fd = mkstemp(tmpl);
+    REQUIRE(0 <= fd);
+    unlink(tmpl);
+    CHECK(0 == fbuf_writev(fd, &f, 2, s, 3));
+    std::string expected = "ab12" + big + "cdefend";
+    CHECK(expected.size() == (size_t)lseek(fd, 0, SEEK_CUR));
+    std::string got(expected.size(), '\0');
+    CHECK((ssize_t)got.size() == pread(fd, &got[0], got.size(), 0));
+    CHECK(expected == got);
+    close(fd);
+    fbuf_free(&f);
+  }
+
+  // more splices than fit in a single writev()
+  SUBCASE("FbufWritevManySplices") {
+    fbuf f{};
+    CHECK(0 == fbuf_init_small(&f));
+    std::vector<fbufsplice> s;
+    std::string expected;
+    for(int i = 0 ; i < 200 ; ++i){
+      if(i % 3){
+        CHECK(1 == fbuf_putc(&f, 'a' + i % 26));
+        expected += 'a' + i % 26;
+      }
+      s.push_back({ f.used, "0123456789" + i % 10, 1, {} });
+      expected += '0' + i % 10;
+    }
+    CHECK(0 < fbuf_puts(&f, "tail"));
+    expected += "tail";
+    char tmpl[] = "/tmp/ncfbufXXXXXX";
+    int fd = mkstemp(tmpl);
+    REQUIRE(0 <= fd);
+    unlink(tmpl);
+    CHECK(0 == fbuf_writev(fd, &f, 0, s.data(), s.size()));
+    std::string got(expected.size(), '\0');
+    CHECK((ssize_t)got.size() == pread(fd, &got[0], got.size(), 0));
+    CHECK(expected == got);
+    close(fd);
+    fbuf_free(&f);
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 }
@@ -95,6 +95,48 @@ TEST_CASE("FdsAndSubprocs"
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // no callback, so the data is written to the plane by the built-in sink.
+  // a tiny buffer splits the UTF-8 across reads, and the carriage return is
+  // dropped.
+  SUBCASE("FdPlaneBuiltinSink") {
+    struct ncplane_options nopts{};
+    nopts.rows = 4;
+    nopts.cols = 20;
+    auto p = ncplane_create(n_, &nopts);
+    REQUIRE(p);
+    bool outofline_cancelled = false;
+    ncfdplane_options opts{};
+    opts.curry = &outofline_cancelled;
+    opts.flags = NCOPTION_FDPLANE_BATCH;
+    opts.bufsize = 3;
+    int pipes[2];
+    REQUIRE(0 == pipe(pipes));
+    const char text[] = "hello\r\nw\u00f6rld\u2603";
+    REQUIRE(sizeof(text) - 1 == write(pipes[1], text, sizeof(text) - 1));
+    REQUIRE(0 == close(pipes[1]));
+    auto ncfdp = ncfdplane_create(p, &opts, pipes[0], nullptr, testfdeof);
+    REQUIRE(ncfdp);
+    pthread_mutex_lock(&lock);
+    while(!outofline_cancelled){
+      pthread_cond_wait(&cond, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+    char* egc = ncplane_at_yx(p, 0, 4, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "o"));
+    free(egc);
+    egc = ncplane_at_yx(p, 1, 1, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "\u00f6"));
+    free(egc);
+    egc = ncplane_at_yx(p, 1, 5, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "\u2603"));
+    free(egc);
+    CHECK(0 == ncfdplane_destroy(ncfdp));
+    CHECK(0 == ncplane_destroy(p));
+  }
+
   /*
   SUBCASE("SubprocDestroyCmdExecFails") {
     char * const argv[] = { "/should-not-exist", nullptr, };
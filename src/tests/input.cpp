@@ -0,0 +1,377 @@
+#include "main.h"
+#include <poll.h>
+#include <fcntl.h>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <sys/ioctl.h>
+
+// the input layer can only be fed through a terminal, so we run a Notcurses
+// instance in a child, atop a pseudoterminal of our own. we play the terminal,
+// answering its queries with |replies| and a DA1. once the child reports that
+// notcurses_init() has returned, we write |payload|, which thus arrives in a
+// single read. the child collects the resulting events, and sends them back.
+struct ptyevent {
+  ncinput ni;
+  unsigned coalesced;
+};
+
+struct ptyinput {
+  std::vector<ptyevent> events;
+  uint64_t immediate;  // events available without waiting, after the first
+  uint64_t counted;    // input_events stat once all events were read
+};
+
+static void
+pty_child(int master, int ready, int res, uint64_t flags){
+  setsid();
+  int slave = open(ptsname(master), O_RDWR);
+  if(slave < 0 || ioctl(slave, TIOCSCTTY, 0)){
+    _exit(EXIT_FAILURE);
+  }
+  dup2(slave, STDIN_FILENO);
+  dup2(slave, STDOUT_FILENO);
+  dup2(slave, STDERR_FILENO);
+  close(master);
+  setenv("TERM", "xterm-256color", 1);
+  notcurses_options nopts{};
+  nopts.flags = flags | NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN;
+  nopts.loglevel = NCLOGLEVEL_SILENT;
+  auto nc = notcurses_init(&nopts, nullptr);
+  if(!nc || write(ready, "", 1) != 1){
+    _exit(EXIT_FAILURE);
+  }
+  close(ready);
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  ts.tv_sec += 5;
+  ptyevent ev{};
+  uint64_t counts[2] = {}; // immediate, counted
+  const struct timespec now{};
+  if(notcurses_get_coalesced(nc, &ts, &ev.ni, &ev.coalesced)){
+    bool waiting = false;
+    for(;;){
+      if(write(res, &ev, sizeof(ev)) != sizeof(ev)){
+        _exit(EXIT_FAILURE);
+      }
+      if(!waiting){
+        ++counts[0];
+        if(notcurses_get_coalesced(nc, &now, &ev.ni, &ev.coalesced)){
+          continue;
+        }
+        waiting = true;
+      }
+      // pick up any stragglers
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      ts.tv_sec += 1;
+      if(!notcurses_get_coalesced(nc, &ts, &ev.ni, &ev.coalesced)){
+        break;
+      }
+    }
+  }
+  ncstats stats;
+  notcurses_stats(nc, &stats);
+  counts[1] = stats.input_events;
+  notcurses_stop(nc);
+  if(write(res, counts, sizeof(counts)) != sizeof(counts)){
+    _exit(EXIT_FAILURE);
+  }
+  _exit(EXIT_SUCCESS);
+}
+
+static bool
+pty_input(const std::string& replies, const std::string& payload,
+          uint64_t flags, ptyinput& in){
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if(master < 0 || grantpt(master) || unlockpt(master)){
+    return false;
+  }
+  struct winsize ws{};
+  ws.ws_row = 24;
+  ws.ws_col = 80;
+  ws.ws_ypixel = 480;
+  ws.ws_xpixel = 800;
+  ioctl(master, TIOCSWINSZ, &ws);
+  int ready[2], res[2];
+  if(pipe(ready)){
+    close(master);
+    return false;
+  }
+  if(pipe(res)){
+    close(ready[0]);
+    close(ready[1]);
+    close(master);
+    return false;
+  }
+  pid_t pid = fork();
+  if(pid == 0){
+    close(ready[0]);
+    close(res[0]);
+    pty_child(master, ready[1], res[1], flags);
+  }
+  close(ready[1]);
+  close(res[1]);
+  std::string seen;
+  bool replied = false;
+  bool sent = false;
+  char buf[BUFSIZ];
+  struct pollfd pfds[2] = {
+    { .fd = master, .events = POLLIN, .revents = 0, },
+    { .fd = ready[0], .events = POLLIN, .revents = 0, },
+  };
+  // drain the child's output until it exits, replying to the DA1 query, and
+  // sending the payload once it's ready for it
+  while(pid > 0 && poll(pfds, sent ? 1 : 2, 5000) > 0){
+    if(pfds[0].revents){
+      ssize_t r = read(master, buf, sizeof(buf));
+      if(r <= 0){
+        break;
+      }
+      if(!replied){
+        seen.append(buf, r);
+        if(seen.find("\x1b[c") != std::string::npos){
+          std::string reply = replies + "\x1b[?62;22c";
+          replied = write(master, reply.data(), reply.size()) == (ssize_t)reply.size();
+        }
+      }
+    }
+    if(!sent && pfds[1].revents){
+      if(read(ready[0], buf, 1) != 1){
+        break;
+      }
+      sent = write(master, payload.data(), payload.size()) == (ssize_t)payload.size();
+    }
+  }
+  std::string results;
+  ssize_t r;
+  while((r = read(res[0], buf, sizeof(buf))) > 0){
+    results.append(buf, r);
+  }
+  close(ready[0]);
+  close(res[0]);
+  close(master);
+  int status;
+  if(pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)
+     || WEXITSTATUS(status) != EXIT_SUCCESS || !replied || !sent){
+    return false;
+  }
+  uint64_t counts[2];
+  if(results.size() % sizeof(ptyevent) != sizeof(counts)){
+    return false;
+  }
+  const size_t count = results.size() / sizeof(ptyevent);
+  in.events.resize(count);
+  memcpy(in.events.data(), results.data(), count * sizeof(ptyevent));
+  memcpy(counts, results.data() + count * sizeof(ptyevent), sizeof(counts));
+  in.immediate = counts[0];
+  in.counted = counts[1];
+  return true;
+}
+
+TEST_CASE("Input") {
+  // events lexed from a single read are published together, in order, and
+  // are all available once the first one is.
+  SUBCASE("InputPublishedTogether") {
+    ptyinput in;
+    REQUIRE(pty_input("", "ab\x1b[Acd\x1b[<0;3;4M", 0, in));
+    REQUIRE(6 == in.events.size());
+    CHECK(6 == in.immediate);
+    CHECK(6 == in.counted);
+    const uint32_t ids[] = { 'a', 'b', NCKEY_UP, 'c', 'd', NCKEY_BUTTON1, };
+    for(size_t i = 0 ; i < in.events.size() ; ++i){
+      CHECK(ids[i] == in.events[i].ni.id);
+    }
+    CHECK(3 == in.events[5].ni.y);
+    CHECK(2 == in.events[5].ni.x);
+  }
+
+  // more events than can be staged at once (256) still arrive in order
+  SUBCASE("InputPublishedInOrder") {
+    std::string payload;
+    for(int i = 0 ; i < 300 ; ++i){
+      payload += 'a' + i % 26;
+    }
+    ptyinput in;
+    REQUIRE(pty_input("", payload, 0, in));
+    REQUIRE(300 == in.events.size());
+    for(size_t i = 0 ; i < in.events.size() ; ++i){
+      CHECK('a' + i % 26 == in.events[i].ni.id);
+    }
+  }
+
+  // with NCOPTION_COALESCE_INPUT, a run of motion reports is merged into its
+  // latest member, which keeps that member's coordinates. an intervening
+  // event ends the run. the reply to our DECRQM enables pixel mice, and our
+  // cells are 20x10 pixels.
+  SUBCASE("InputCoalescedMotion") {
+    ptyinput in;
+    REQUIRE(pty_input("\x1b[?1016;2$y",
+                      "\x1b[<35;15;7M\x1b[<35;55;27M\x1b[<35;105;47M"
+                      "a\x1b[<35;31;21M\x1b[<35;22;13M",
+                      NCOPTION_COALESCE_INPUT, in));
+    REQUIRE(3 == in.events.size());
+    CHECK(NCKEY_MOTION == in.events[0].ni.id);
+    CHECK(2 == in.events[0].coalesced);
+    CHECK(2 == in.events[0].ni.y);
+    CHECK(10 == in.events[0].ni.x);
+    CHECK(6 == in.events[0].ni.ypx);
+    CHECK(4 == in.events[0].ni.xpx);
+    CHECK('a' == in.events[1].ni.id);
+    CHECK(0 == in.events[1].coalesced);
+    CHECK(NCKEY_MOTION == in.events[2].ni.id);
+    CHECK(1 == in.events[2].coalesced);
+    CHECK(0 == in.events[2].ni.y);
+    CHECK(2 == in.events[2].ni.x);
+    CHECK(12 == in.events[2].ni.ypx);
+    CHECK(1 == in.events[2].ni.xpx);
+    // every report was counted as an input event
+    CHECK(6 == in.counted);
+  }
+
+  // without it, every report is delivered
+  SUBCASE("InputUncoalescedMotion") {
+    ptyinput in;
+    REQUIRE(pty_input("\x1b[?1016;2$y",
+                      "\x1b[<35;15;7M\x1b[<35;55;27M\x1b[<35;105;47M",
+                      0, in));
+    REQUIRE(3 == in.events.size());
+    for(const auto& ev : in.events){
+      CHECK(NCKEY_MOTION == ev.ni.id);
+      CHECK(0 == ev.coalesced);
+    }
+    CHECK(4 == in.events[2].ni.xpx);
+  }
+
+  // the escape automaton, once compiled into a flat table, must recognize
+  // exactly what the trie from which it was built did. this corpus (and what
+  // it lexes to under xterm-256color) was captured from the trie automaton.
+  // unknown sequences and bracketed pastes are replayed as their characters.
+  SUBCASE("InputEscapeCorpus") {
+    struct expect {
+      uint32_t id;
+      unsigned mods;
+      ncintype_e evtype;
+      int y, x; // only checked for mouse events
+    };
+    std::vector<expect> expected = {
+      { NCKEY_UP, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_DOWN, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_RIGHT, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_LEFT, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_UP, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_DOWN, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_RIGHT, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_LEFT, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_HOME, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_END, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_HOME, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_END, 0, NCTYPE_UNKNOWN, 0, 0, },
+    };
+    auto replay = [&expected](const char* seq){
+      while(*seq){
+        expected.push_back({ (uint32_t)*seq++, 0, NCTYPE_UNKNOWN, 0, 0, });
+      }
+    };
+    replay("\x1b[1~");
+    replay("\x1b[4~");
+    expected.insert(expected.end(), {
+      { NCKEY_INS, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_DEL, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_PGUP, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_PGDOWN, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_F01, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_F02, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_F03, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_F04, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_F05, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_F06, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_F12, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_UP, NCKEY_MOD_CTRL, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_DOWN, NCKEY_MOD_SHIFT, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_RIGHT, NCKEY_MOD_ALT, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_LEFT, NCKEY_MOD_CTRL | NCKEY_MOD_SHIFT, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_DEL, NCKEY_MOD_CTRL, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_F25, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_F17, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_TAB, NCKEY_MOD_SHIFT, NCTYPE_UNKNOWN, 0, 0, },
+      { 'A', NCKEY_MOD_CTRL, NCTYPE_PRESS, 0, 0, },
+      { NCKEY_ENTER, 0, NCTYPE_PRESS, 0, 0, },
+      { NCKEY_BUTTON1, 0, NCTYPE_PRESS, 3, 2, },
+      { NCKEY_BUTTON1, 0, NCTYPE_RELEASE, 3, 2, },
+      { NCKEY_BUTTON4, 0, NCTYPE_PRESS, 0, 0, },
+      { NCKEY_MOTION, 0, NCTYPE_RELEASE, 5, 4, },
+      { NCKEY_BEGIN, 0, NCTYPE_PRESS, 0, 0, },
+      { NCKEY_HOME, NCKEY_MOD_SHIFT, NCTYPE_UNKNOWN, 0, 0, },
+      { 'x', 0, NCTYPE_UNKNOWN, 0, 0, },
+    });
+    replay("\x1b[200~hi\x1b[201~q");
+    expected.insert(expected.end(), {
+      { NCKEY_BACKSPACE, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { NCKEY_BACKSPACE, 0, NCTYPE_UNKNOWN, 0, 0, },
+      { 'A', NCKEY_MOD_CTRL, NCTYPE_UNKNOWN, 0, 0, },
+    });
+    ptyinput in;
+    REQUIRE(pty_input("",
+                      "\x1b[A\x1b[B\x1b[C\x1b[D\x1bOA\x1bOB\x1bOC\x1bOD"
+                      "\x1b[H\x1b[F\x1bOH\x1bOF\x1b[1~\x1b[4~"
+                      "\x1b[2~\x1b[3~\x1b[5~\x1b[6~"
+                      "\x1bOP\x1bOQ\x1bOR\x1bOS\x1b[15~\x1b[17~\x1b[24~"
+                      "\x1b[1;5A\x1b[1;2B\x1b[1;3C\x1b[1;6D\x1b[3;5~"
+                      "\x1b[1;5P\x1b[15;2~\x1b[Z\x1b[97;5u\x1b[13u"
+                      "\x1b[<0;3;4M\x1b[<0;3;4m\x1b[<64;1;1M\x1b[<35;5;6M"
+                      "\x1b[E\x1b[1;2H\x1bx\x1b[200~hi\x1b[201~q\x7f\x08\x01",
+                      0, in));
+    REQUIRE(expected.size() == in.events.size());
+    for(size_t i = 0 ; i < expected.size() ; ++i){
+      const ncinput& ni = in.events[i].ni;
+      CHECK(expected[i].id == ni.id);
+      CHECK(expected[i].mods == ni.modifiers);
+      CHECK(expected[i].evtype == ni.evtype);
+      if(nckey_mouse_p(ni.id)){
+        CHECK(expected[i].y == ni.y);
+        CHECK(expected[i].x == ni.x);
+      }
+    }
+  }
+
+  // runs of printable ASCII are lexed a word at a time. runs of every length
+  // modulo the word size, ended by control characters, DEL, escapes, and
+  // UTF-8, must lex just as they would a byte at a time.
+  SUBCASE("InputAsciiRuns") {
+    struct breaker {
+      const char* seq;
+      uint32_t id;
+      unsigned mods;
+    } breakers[] = {
+      { "\x01", 'A', NCKEY_MOD_CTRL, },
+      { "\x7f", NCKEY_BACKSPACE, 0, },
+      { "\x1b[A", NCKEY_UP, 0, },
+      { "\xc3\xa9", 0xe9, 0, },
+      { "\t", NCKEY_TAB, 0, },
+      { "\r", NCKEY_ENTER, 0, },
+    };
+    const size_t bcount = sizeof(breakers) / sizeof(*breakers);
+    std::string payload;
+    std::vector<std::pair<uint32_t, unsigned>> expected;
+    char c = ' ';
+    for(int len = 1 ; len <= 24 ; ++len){
+      for(int i = 0 ; i < len ; ++i){
+        payload += c;
+        expected.emplace_back(c, 0);
+        if(++c > '~'){
+          c = ' ';
+        }
+      }
+      const breaker& b = breakers[len % bcount];
+      payload += b.seq;
+      expected.emplace_back(b.id, b.mods);
+    }
+    ptyinput in;
+    REQUIRE(pty_input("", payload, 0, in));
+    REQUIRE(expected.size() == in.events.size());
+    for(size_t i = 0 ; i < expected.size() ; ++i){
+      CHECK(expected[i].first == in.events[i].ni.id);
+      CHECK(expected[i].second == in.events[i].ni.modifiers);
+    }
+  }
+}
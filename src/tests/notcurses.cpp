@@ -1,4 +1,5 @@
 #include <string>
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
 #include "main.h"
@@ -133,6 +134,92 @@ TEST_CASE("NotcursesBase") {
     CHECK(0 == stats.renders);
   }
 
+  // a budget we can't possibly meet drives us to maximal degradation, which
+  // absorbs small color changes, and defers low-priority planes
+  SUBCASE("BandwidthDegradation"){
+    struct ncplane* n = notcurses_stdplane(nc_);
+    CHECK(0 == notcurses_set_bandwidth(nc_, 1));
+    notcurses_stats_reset(nc_, nullptr);
+    for(unsigned i = 0 ; i < 8 ; ++i){
+      CHECK(0 == ncplane_set_bg_rgb8(n, 0x40 + i, 0x40 + i, 0x40 + i));
+      for(unsigned y = 0 ; y < 4 ; ++y){
+        CHECK(0 < ncplane_putstr_yx(n, y, 0, "degradation"));
+      }
+      CHECK(0 == notcurses_render(nc_));
+    }
+    struct ncstats stats;
+    notcurses_stats(nc_, &stats);
+    CHECK(3 == stats.degradation);
+    CHECK(0 < stats.degraded_frames);
+    CHECK(0 < stats.degraded_cells);
+    struct ncplane_options nopts{};
+    nopts.y = 5;
+    nopts.rows = 1;
+    nopts.cols = 1;
+    nopts.flags = NCPLANE_OPTION_LOWPRIORITY;
+    auto low = ncplane_create(n, &nopts);
+    REQUIRE(nullptr != low);
+    CHECK(0 < ncplane_putchar(low, 'L'));
+    CHECK(0 == notcurses_render(nc_));
+    char* egc = notcurses_at_yx(nc_, 5, 0, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK(0 != strcmp(egc, "L"));
+    free(egc);
+    // lifting the budget restores fidelity, and lets the deferred cell out
+    CHECK(0 == notcurses_set_bandwidth(nc_, 0));
+    CHECK(0 == notcurses_render(nc_));
+    egc = notcurses_at_yx(nc_, 5, 0, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK(0 == strcmp(egc, "L"));
+    free(egc);
+    notcurses_stats(nc_, &stats);
+    CHECK(0 == stats.degradation);
+    CHECK(0 == ncplane_destroy(low));
+  }
+
+  // an unchanged frame visits each cell once, eliding it, and finds each row
+  // clean. time frames in which a few rows change, the typical case for
+  // damage computation.
+  SUBCASE("RasterBenchmark"){
+    constexpr int FRAMES = 200;
+    unsigned dimy, dimx;
+    struct ncplane* n = notcurses_stddim_yx(nc_, &dimy, &dimx);
+    for(unsigned y = 0 ; y < dimy ; ++y){
+      for(unsigned x = 0 ; x < dimx ; ++x){
+        CHECK(0 < ncplane_putchar_yx(n, y, x, 'a' + (y + x) % 26));
+      }
+    }
+    CHECK(0 == notcurses_render(nc_));
+    notcurses_stats_reset(nc_, nullptr);
+    CHECK(0 == notcurses_render(nc_));
+    struct ncstats stats;
+    notcurses_stats(nc_, &stats);
+    CHECK(0 == stats.cellemissions);
+    CHECK(dimy * dimx == stats.cellelisions);
+    CHECK(dimy == stats.cleanrows);
+    // only the changed row is compared cell by cell
+    CHECK(0 < ncplane_putstr_yx(n, 1, 0, "changed"));
+    notcurses_stats_reset(nc_, nullptr);
+    CHECK(0 == notcurses_render(nc_));
+    notcurses_stats(nc_, &stats);
+    CHECK(dimy - 1 == stats.cleanrows);
+    CHECK(7 == stats.cellemissions);
+    auto start = std::chrono::steady_clock::now();
+    for(int f = 0 ; f < FRAMES ; ++f){
+      CHECK(0 == ncplane_set_fg_rgb8(n, f & 0xff, 0x80, 0x80));
+      for(unsigned y = f % 8 ; y < dimy ; y += 8){
+        CHECK(0 < ncplane_putstr_yx(n, y, 0, "damage"));
+      }
+      CHECK(0 == notcurses_render(nc_));
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    std::cout << "raster: " << dimx << "x" << dimy << " "
+              << duration_cast<nanoseconds>(elapsed).count() / FRAMES
+              << "ns/frame" << std::endl;
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
@@ -103,6 +103,38 @@ TEST_CASE("Palette") {
     nccell_release(n_, &r);
   }
 
+  // alternate two RGB colors across the screen, so that neither can be
+  // elided. by the second frame, both ought be coming from the palette.
+  SUBCASE("DynamicPalette") {
+    CHECK(0 > notcurses_set_dynamic_palette(nc_, 241));
+    if(0 == notcurses_set_dynamic_palette(nc_, 8)){
+      unsigned dimy, dimx;
+      ncplane_dim_yx(n_, &dimy, &dimx);
+      for(int frame = 0 ; frame < 3 ; ++frame){
+        for(unsigned y = 0 ; y < dimy ; ++y){
+          for(unsigned x = 0 ; x < dimx ; ++x){
+            CHECK(0 == ncplane_set_fg_rgb(n_, (x + y) % 2 ? 0x8a7b6c : 0x6c7b8a));
+            CHECK(0 == ncplane_set_bg_rgb(n_, (x + y) % 2 ? 0x102030 : 0x302010));
+            CHECK(0 < ncplane_putchar_yx(n_, y, x, frame % 2 ? 'x' : 'o'));
+          }
+        }
+        CHECK(0 == notcurses_render(nc_));
+      }
+      ncstats stats;
+      notcurses_stats(nc_, &stats);
+      CHECK(0 < stats.dynpal_spent);
+      CHECK(stats.dynpal_spent < stats.dynpal_saved);
+      uint64_t channels;
+      auto egc = notcurses_at_yx(nc_, 0, 1, nullptr, &channels);
+      REQUIRE(egc);
+      CHECK(0 == strcmp(egc, "o"));
+      free(egc);
+      CHECK(0x8a7b6c == ncchannels_fg_rgb(channels));
+      CHECK(0x102030 == ncchannels_bg_rgb(channels));
+      CHECK(0 == notcurses_set_dynamic_palette(nc_, 0));
+    }
+  }
+
   // common teardown
   CHECK(0 == notcurses_stop(nc_));
 }
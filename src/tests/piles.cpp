@@ -304,6 +304,51 @@ TEST_CASE("Piles") {
     ncplane_destroy(gen3);
   }
 
+  // switch the display to another pile and back. each switch need only emit
+  // those cells which differ from the pile being replaced, and destroying
+  // the displayed pile forgets it.
+  SUBCASE("SwitchPilesAndBack") {
+    CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "abc"));
+    CHECK(0 == notcurses_render(nc_));
+    struct ncplane_options nopts = {
+      .y = 0, .x = 0,
+      .rows = dimy,
+      .cols = dimx,
+      .userptr = nullptr, .name = "tab", .resizecb = nullptr, .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    auto np = ncpile_create(nc_, &nopts);
+    REQUIRE(nullptr != np);
+    CHECK(0 < ncplane_putstr_yx(np, 0, 0, "abd"));
+    ncstats stats;
+    notcurses_stats_reset(nc_, &stats);
+    CHECK(0 == ncpile_render(np));
+    CHECK(0 == ncpile_rasterize(np));
+    notcurses_stats(nc_, &stats);
+    CHECK(1 == stats.cellemissions);
+    CHECK(ncplane_pile(np) == nc_->last_pile);
+    uint16_t stylemask;
+    uint64_t channels;
+    char* egc = notcurses_at_yx(nc_, 0, 2, &stylemask, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "d"));
+    free(egc);
+    notcurses_stats_reset(nc_, &stats);
+    CHECK(0 == notcurses_render(nc_));
+    notcurses_stats(nc_, &stats);
+    CHECK(1 == stats.cellemissions);
+    egc = notcurses_at_yx(nc_, 0, 2, &stylemask, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "c"));
+    free(egc);
+    CHECK(0 == ncpile_render(np));
+    CHECK(0 == ncpile_rasterize(np));
+    CHECK(0 == ncplane_destroy(np));
+    CHECK(nullptr == nc_->last_pile);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(ncplane_pile(n_) == nc_->last_pile);
+  }
+
   // common teardown
   CHECK(0 == notcurses_stop(nc_));
 }
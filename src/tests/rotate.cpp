@@ -1,5 +1,7 @@
 #include "main.h"
+#include "lib/visual-details.h"
 #include <cmath>
+#include <algorithm>
 #include <vector>
 
 void RotateCW(struct notcurses* nc, struct ncplane* n) {
@@ -290,6 +292,70 @@ TEST_CASE("Rotate") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // quarter turns are exact copies of the source pixels, and leave no holes
+  SUBCASE("RotateVisualQuarterExact") {
+    const int height = 4;
+    const int width = 6;
+    std::vector<uint32_t> rgba(width * height);
+    for(int i = 0 ; i < height * width ; ++i){
+      rgba[i] = htole(0xff000000 + i * 0x0a0b0c);
+    }
+    auto ncv = ncvisual_from_rgba(rgba.data(), height, width * 4, width);
+    REQUIRE(ncv);
+    CHECK(0 == ncvisual_rotate(ncv, M_PI / 2));
+    CHECK(width == ncv->pixy);
+    CHECK(height == ncv->pixx);
+    for(unsigned y = 0 ; y < ncv->pixy ; ++y){
+      for(unsigned x = 0 ; x < ncv->pixx ; ++x){
+        const uint32_t p = ncv->data[y * ncv->rowstride / 4 + x];
+        CHECK(rgba.end() != std::find(rgba.begin(), rgba.end(), p));
+      }
+    }
+    CHECK(0 == ncvisual_rotate(ncv, -M_PI / 2));
+    CHECK(height == ncv->pixy);
+    CHECK(width == ncv->pixx);
+    for(int y = 0 ; y < height ; ++y){
+      for(int x = 0 ; x < width ; ++x){
+        CHECK(rgba[y * width + x] == ncv->data[y * ncv->rowstride / 4 + x]);
+      }
+    }
+    ncvisual_destroy(ncv);
+  }
+
+  // an arbitrary rotation of an opaque square yields an opaque, convex
+  // region; each row's opaque pixels must be contiguous
+  SUBCASE("RotateVisualHoleFree") {
+    const int side = 64;
+    std::vector<uint32_t> rgba(side * side, htole(0xff336699));
+    auto ncv = ncvisual_from_rgba(rgba.data(), side, side * 4, side);
+    REQUIRE(ncv);
+    CHECK(0 == ncvisual_rotate(ncv, M_PI / 5));
+    CHECK(side < ncv->pixx);
+    CHECK(side < ncv->pixy);
+    for(unsigned y = 0 ; y < ncv->pixy ; ++y){
+      int first = -1;
+      int last = -1;
+      int opaque = 0;
+      for(unsigned x = 0 ; x < ncv->pixx ; ++x){
+        const uint32_t p = ncv->data[y * ncv->rowstride / 4 + x];
+        if(ncpixel_a(p) == 0xff){
+          if(first < 0){
+            first = x;
+          }
+          last = x;
+          ++opaque;
+          CHECK(0x99 == ncpixel_r(p));
+          CHECK(0x66 == ncpixel_g(p));
+          CHECK(0x33 == ncpixel_b(p));
+        }
+      }
+      if(opaque){
+        CHECK(last - first + 1 == opaque);
+      }
+    }
+    ncvisual_destroy(ncv);
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
@@ -0,0 +1,142 @@
+#include "main.h"
+#include <cstring>
+#include <string>
+
+// the EGC at y, x of n, as a string
+static auto
+egc_at(struct ncplane* n, unsigned y, unsigned x, uint64_t* channels = nullptr) -> std::string {
+  char* egc = ncplane_at_yx(n, y, x, nullptr, channels);
+  REQUIRE(nullptr != egc);
+  std::string s(egc);
+  free(egc);
+  return s;
+}
+
+// the first 'len' columns of row y of n
+static auto
+row_at(struct ncplane* n, unsigned y, unsigned len) -> std::string {
+  std::string s;
+  for(unsigned x = 0 ; x < len ; ++x){
+    s += egc_at(n, y, x);
+  }
+  return s;
+}
+
+TEST_CASE("Scrollback") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(n_);
+  struct ncplane_options nopts{};
+  nopts.rows = 5;
+  nopts.cols = 20;
+  nopts.flags = NCPLANE_OPTION_VSCROLL;
+  auto n = ncplane_create(n_, &nopts);
+  REQUIRE(nullptr != n);
+  nopts.flags = 0;
+  auto view = ncplane_create(n_, &nopts);
+  REQUIRE(nullptr != view);
+
+  SUBCASE("NoStoreNoHistory") {
+    CHECK(0 == ncplane_scrollback_rows(n));
+    CHECK(0 < ncplane_putstr(n, "live"));
+    CHECK(0 == ncplane_scrollback_window(n, 10, view));
+    CHECK("live" == row_at(view, 0, 4));
+    CHECK(-1 == ncplane_scrollback_window(n, 0, n));
+  }
+
+  // every row scrolled away can be recovered, colors and all
+  SUBCASE("RecoverHistory") {
+    ncscrollback_options opts{};
+    REQUIRE(0 == ncplane_set_scrollback(n, &opts));
+    for(int i = 0 ; i < 1000 ; ++i){
+      ncplane_set_fg_rgb(n, i);
+      CHECK(0 < ncplane_printf(n, "line %d\n", i));
+    }
+    // lines 996..999 and the cursor's row remain in the plane
+    CHECK(996 == ncplane_scrollback_rows(n));
+    for(unsigned back : { 996u, 500u, 3u }){
+      CHECK((back < 5 ? (int)back : 5) == ncplane_scrollback_window(n, back, view));
+      for(unsigned y = 0 ; y < 5 ; ++y){
+        const unsigned line = 996 - back + y;
+        std::string expect = "line " + std::to_string(line);
+        CHECK(expect == row_at(view, y, expect.size()));
+        uint64_t channels;
+        egc_at(view, y, 0, &channels);
+        CHECK(line == ncchannels_fg_rgb(channels));
+        CHECK("" == egc_at(view, y, expect.size() + 1));
+      }
+    }
+    // asking for more than we have starts at the oldest row
+    CHECK(5 == ncplane_scrollback_window(n, 5000, view));
+    CHECK("line 0" == row_at(view, 0, 6));
+    CHECK(0 == ncplane_set_scrollback(n, nullptr));
+    CHECK(0 == ncplane_scrollback_rows(n));
+  }
+
+  SUBCASE("WideAndExtendedGlyphs") {
+    ncscrollback_options opts{};
+    REQUIRE(0 == ncplane_set_scrollback(n, &opts));
+    ncplane_set_styles(n, NCSTYLE_BOLD);
+    // a base with two combining accents needs the EGCpool
+    CHECK(0 < ncplane_putstr(n, "a🔥be\u0301\u0301c\n"));
+    ncplane_set_styles(n, NCSTYLE_NONE);
+    for(int i = 0 ; i < 5 ; ++i){
+      CHECK(0 < ncplane_putstr(n, "\n"));
+    }
+    CHECK(2 == ncplane_scrollback_rows(n));
+    CHECK(2 == ncplane_scrollback_window(n, 2, view));
+    CHECK("a" == egc_at(view, 0, 0));
+    CHECK("🔥" == egc_at(view, 0, 1));
+    CHECK("b" == egc_at(view, 0, 3));
+    CHECK("e\u0301\u0301" == egc_at(view, 0, 4));
+    CHECK("c" == egc_at(view, 0, 5));
+    uint16_t stylemask;
+    char* egc = ncplane_at_yx(view, 0, 0, &stylemask, nullptr);
+    REQUIRE(nullptr != egc);
+    free(egc);
+    CHECK(NCSTYLE_BOLD == stylemask);
+    nccell c = NCCELL_TRIVIAL_INITIALIZER;
+    CHECK(0 <= ncplane_at_yx_cell(view, 0, 2, &c));
+    CHECK(nccell_wide_right_p(&c));
+    nccell_release(view, &c);
+  }
+
+  // old pages are discarded once maxrows are otherwise retained, and pages
+  // beyond maxresident go to disk, yet remain readable
+  SUBCASE("BoundedAndSpilled") {
+    ncscrollback_options opts{};
+    opts.maxrows = 20000;
+    opts.maxresident = 8192;
+    REQUIRE(0 == ncplane_set_scrollback(n, &opts));
+    for(int i = 0 ; i < 50000 ; ++i){
+      CHECK(0 < ncplane_printf(n, "%d\n", i));
+    }
+    const unsigned rows = ncplane_scrollback_rows(n);
+    CHECK(20000 <= rows);
+    CHECK(30000 > rows);
+    for(unsigned back : { rows, 19999u, 12345u, 5u }){
+      CHECK(0 < ncplane_scrollback_window(n, back, view));
+      const std::string expect = std::to_string(49996 - back);
+      CHECK(expect == row_at(view, 0, expect.size()));
+    }
+  }
+
+  SUBCASE("UnboundedHistory") {
+    ncscrollback_options opts{};
+    REQUIRE(0 == ncplane_set_scrollback(n, &opts));
+    ncplane_set_fg_rgb(n, 0x80c0ff);
+    for(int i = 0 ; i < 100000 ; ++i){
+      CHECK(0 < ncplane_printf(n, "%06d event\n", i));
+    }
+    CHECK(99996 == ncplane_scrollback_rows(n));
+    CHECK(0 < ncplane_scrollback_window(n, 99996, view));
+    CHECK("000000 event" == row_at(view, 0, 12));
+  }
+
+  CHECK(0 == ncplane_destroy(view));
+  CHECK(0 == ncplane_destroy(n));
+  CHECK(0 == notcurses_stop(nc_));
+}
@@ -255,6 +255,59 @@ TEST_CASE("Scrolling") {
     // FIXME
   }
 
+  // a multi-line ncplane_scrollup() must match scrolling one line at a time:
+  // the surviving rows rotate up by r, and bound planes move up by r until
+  // they no longer intersect us.
+  SUBCASE("ScrollupBatch") {
+    struct ncplane_options nopts = {
+      .y = 1,
+      .x = 1,
+      .rows = 4,
+      .cols = 8,
+      .userptr = nullptr, .name = nullptr, .resizecb = nullptr, .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    struct ncplane* n = ncplane_create(n_, &nopts);
+    REQUIRE(n);
+    CHECK(!ncplane_set_scrolling(n, true));
+    for(int y = 0 ; y < 4 ; ++y){
+      CHECK(1 == ncplane_putchar_yx(n, y, 0, 'a' + y));
+    }
+    struct ncplane_options copts = {
+      .y = 2,
+      .x = 0,
+      .rows = 1,
+      .cols = 2,
+      .userptr = nullptr, .name = nullptr, .resizecb = nullptr, .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    struct ncplane* child = ncplane_create(n, &copts);
+    REQUIRE(child);
+    CHECK(0 == ncplane_cursor_move_yx(n, 3, 0));
+    CHECK(0 == ncplane_scrollup(n, 2));
+    for(int y = 0 ; y < 4 ; ++y){
+      uint16_t stylemask;
+      uint64_t channels;
+      char* egc = ncplane_at_yx(n, y, 0, &stylemask, &channels);
+      REQUIRE(egc);
+      if(y < 2){
+        CHECK('c' + y == *egc);
+      }else{
+        CHECK('\0' == *egc);
+      }
+      free(egc);
+    }
+    CHECK(0 == ncplane_y(child));
+    // the child leaves us after one more scroll, and stops there
+    CHECK(0 == ncplane_scrollup(n, 10));
+    CHECK(-1 == ncplane_y(child));
+    unsigned y, x;
+    ncplane_cursor_yx(n, &y, &x);
+    CHECK(3 == y);
+    CHECK(0 == x);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
   // ensure that bound planes are scrolled along with us
   SUBCASE("BoundScroll") {
     int starty = 4;
@@ -0,0 +1,131 @@
+#include "main.h"
+#include <mutex>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+struct sinkcapture {
+  std::mutex lock;
+  std::vector<std::string> frames;
+  unsigned delayms; // sleep this long in each callback
+};
+
+auto testsinkcb(struct ncsink* s, const void* buf, size_t len, uint64_t ns,
+                void* curry) -> int {
+  auto cap = static_cast<sinkcapture*>(curry);
+  {
+    std::lock_guard<std::mutex> lck(cap->lock);
+    cap->frames.emplace_back(static_cast<const char*>(buf), len);
+  }
+  if(cap->delayms){
+    usleep(cap->delayms * 1000);
+  }
+  (void)s;
+  (void)ns;
+  return 0;
+}
+
+static auto
+frames_containing(sinkcapture* cap, const char* needle) -> unsigned {
+  std::lock_guard<std::mutex> lck(cap->lock);
+  unsigned count = 0;
+  for(const auto& f : cap->frames){
+    if(f.find(needle) != std::string::npos){
+      ++count;
+    }
+  }
+  return count;
+}
+
+TEST_CASE("Sinks") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(n_);
+
+  // a callback sink sees the rasterized frame
+  SUBCASE("SinkCallback") {
+    sinkcapture cap{};
+    ncsink_options sopts{};
+    sopts.curry = &cap;
+    auto s = ncsink_create(nc_, &sopts, -1, testsinkcb);
+    REQUIRE(nullptr != s);
+    CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "sinkhole"));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncsink_destroy(s));
+    CHECK(0 < frames_containing(&cap, "sinkhole"));
+  }
+
+  // the asciicast sink writes a header, and an output event per frame
+  SUBCASE("SinkAsciicast") {
+    char fn[] = "/tmp/ncsinkXXXXXX";
+    int fd = mkstemp(fn);
+    REQUIRE(0 <= fd);
+    auto s = ncsink_asciicast(nc_, nullptr, fd);
+    REQUIRE(nullptr != s);
+    CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "\"recorded\""));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncsink_destroy(s));
+    std::string cast;
+    char buf[BUFSIZ];
+    ssize_t r;
+    REQUIRE(0 == lseek(fd, 0, SEEK_SET));
+    while((r = read(fd, buf, sizeof(buf))) > 0){
+      cast.append(buf, r);
+    }
+    close(fd);
+    unlink(fn);
+    CHECK(0 == cast.find("{\"version\": 2, \"width\": "));
+    CHECK(std::string::npos != cast.find(", \"o\", \""));
+    CHECK(std::string::npos != cast.find("\\\"recorded\\\""));
+    CHECK(std::string::npos == cast.find('\x1b'));
+  }
+
+  // a slow, non-blocking sink drops frames rather than stalling us, and is
+  // then resynchronized with a keyframe
+  SUBCASE("SinkDropsAndResyncs") {
+    sinkcapture cap{};
+    cap.delayms = 50;
+    ncsink_options sopts{};
+    sopts.curry = &cap;
+    sopts.maxqueue = 1;
+    auto s = ncsink_create(nc_, &sopts, -1, testsinkcb);
+    REQUIRE(nullptr != s);
+    CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "steadfast"));
+    CHECK(0 == notcurses_render(nc_));
+    for(int i = 0 ; i < 5 ; ++i){
+      CHECK(0 < ncplane_putchar_yx(n_, 1, 0, 'a' + i));
+      CHECK(0 == notcurses_render(nc_));
+    }
+    CHECK(0 < ncsink_dropped(s));
+    usleep(500000); // let the sink drain
+    // the first render is dropped, but requests a keyframe, which precedes
+    // the second render's delta
+    CHECK(0 < ncplane_putchar_yx(n_, 1, 0, 'y'));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 < ncplane_putchar_yx(n_, 1, 0, 'z'));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncsink_destroy(s));
+    // the first delta, and at least the resync
+    CHECK(2 <= frames_containing(&cap, "steadfast"));
+    // the frame carrying our final change is the same delta the terminal got,
+    // not a repaint. the keyframe before it carried the unchanged text.
+    auto last = std::find_if(cap.frames.rbegin(), cap.frames.rend(),
+                             [](const std::string& f){
+                               return f.find('z') != std::string::npos;
+                             });
+    REQUIRE(cap.frames.rend() != last);
+    CHECK(std::string::npos == last->find("steadfast"));
+    auto key = std::next(last);
+    REQUIRE(cap.frames.rend() != key);
+    CHECK(std::string::npos != key->find("steadfast"));
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}